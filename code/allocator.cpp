@@ -0,0 +1,251 @@
+#include "allocator.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+#if !defined(FALCON_MEMORY_BACKEND_SYSTEM) && !defined(FALCON_MEMORY_BACKEND_POOL) && !defined(FALCON_MEMORY_BACKEND_TRACKING)
+#define FALCON_MEMORY_BACKEND_TRACKING
+#endif
+
+namespace {
+
+// counters of one tag, constant initialized so allocations during static
+// initialization are counted
+struct counters {
+    std::atomic<int64_t> live_bytes{ 0 };
+    std::atomic<int64_t> peak_bytes{ 0 };
+    std::atomic<int64_t> num_live{ 0 };
+    std::atomic<int64_t> num_allocs{ 0 };
+};
+
+counters tags[FALCON_MEMORY_TAG_NUM];
+
+// tag index, unknown tags are charged to the app
+inline int tag_index(falcon_memory_tag tag) {
+    return (tag >= 0 && tag < FALCON_MEMORY_TAG_NUM) ? tag : FALCON_MEMORY_TAG_APP;
+}
+
+#if !defined(FALCON_MEMORY_BACKEND_SYSTEM)
+
+// block header, keeps the user pointer 16 byte aligned
+struct alignas(16) header {
+    uint64_t size;
+    uint32_t tag;
+    uint32_t size_class;
+};
+
+static_assert(sizeof(header) == 16, "header must keep 16 byte alignment");
+
+// size class of blocks from malloc
+constexpr uint32_t no_class = 0xFFFFFFFF;
+
+void count_alloc(int tag, size_t size) {
+    counters &c = tags[tag];
+    const int64_t live = c.live_bytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed) + static_cast<int64_t>(size);
+    int64_t peak = c.peak_bytes.load(std::memory_order_relaxed);
+    while (live > peak && !c.peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+    c.num_live.fetch_add(1, std::memory_order_relaxed);
+    c.num_allocs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void count_free(int tag, size_t size) {
+    counters &c = tags[tag];
+    c.live_bytes.fetch_sub(static_cast<int64_t>(size), std::memory_order_relaxed);
+    c.num_live.fetch_sub(1, std::memory_order_relaxed);
+}
+
+#endif
+
+#if defined(FALCON_MEMORY_BACKEND_POOL)
+
+// size classes (header included), larger blocks come from malloc
+constexpr size_t class_sizes[] = { 32, 64, 128, 256, 512 };
+constexpr int num_classes = sizeof(class_sizes) / sizeof(class_sizes[0]);
+
+// pages are carved into blocks of one class and never returned
+constexpr size_t page_size = 64 * 1024;
+
+// free list of one class, a free block stores the next one in its first bytes
+struct size_class {
+    std::mutex mutex;
+    void *free = nullptr;
+};
+
+size_class classes[num_classes];
+
+uint32_t find_class(size_t total) {
+    for (int i = 0; i < num_classes; i++) {
+        if (total <= class_sizes[i]) {
+            return static_cast<uint32_t>(i);
+        }
+    }
+    return no_class;
+}
+
+void *pool_alloc(uint32_t index) {
+    size_class &c = classes[index];
+    std::lock_guard<std::mutex> lock(c.mutex);
+    if (!c.free) {
+        auto *page = static_cast<uint8_t *>(std::malloc(page_size));
+        if (!page) {
+            return nullptr;
+        }
+        const size_t block = class_sizes[index];
+        for (size_t offset = 0; offset + block <= page_size; offset += block) {
+            void *p = page + offset;
+            *static_cast<void **>(p) = c.free;
+            c.free = p;
+        }
+    }
+    void *p = c.free;
+    c.free = *static_cast<void **>(p);
+    return p;
+}
+
+void pool_free(uint32_t index, void *p) {
+    size_class &c = classes[index];
+    std::lock_guard<std::mutex> lock(c.mutex);
+    *static_cast<void **>(p) = c.free;
+    c.free = p;
+}
+
+#endif
+
+} // namespace
+
+extern "C" {
+
+void *falcon_malloc(falcon_memory_tag tag, size_t size) {
+#if defined(FALCON_MEMORY_BACKEND_SYSTEM)
+    (void)tag;
+    return std::malloc(size);
+#else
+    if (size > SIZE_MAX - sizeof(header)) {
+        return nullptr;
+    }
+    const size_t total = size + sizeof(header);
+    uint32_t cls = no_class;
+    void *block = nullptr;
+#if defined(FALCON_MEMORY_BACKEND_POOL)
+    cls = find_class(total);
+    block = (cls != no_class) ? pool_alloc(cls) : std::malloc(total);
+#else
+    block = std::malloc(total);
+#endif
+    if (!block) {
+        return nullptr;
+    }
+    const int index = tag_index(tag);
+    auto *h = static_cast<header *>(block);
+    h->size = size;
+    h->tag = static_cast<uint32_t>(index);
+    h->size_class = cls;
+    count_alloc(index, size);
+    return h + 1;
+#endif
+}
+
+void *falcon_calloc(falcon_memory_tag tag, size_t count, size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) {
+        return nullptr;
+    }
+    void *p = falcon_malloc(tag, count * size);
+    if (p) {
+        std::memset(p, 0, count * size);
+    }
+    return p;
+}
+
+void falcon_free(void *p) {
+#if defined(FALCON_MEMORY_BACKEND_SYSTEM)
+    std::free(p);
+#else
+    if (!p) {
+        return;
+    }
+    header *h = static_cast<header *>(p) - 1;
+    count_free(static_cast<int>(h->tag), static_cast<size_t>(h->size));
+#if defined(FALCON_MEMORY_BACKEND_POOL)
+    if (h->size_class != no_class) {
+        pool_free(h->size_class, h);
+        return;
+    }
+#endif
+    std::free(h);
+#endif
+}
+
+falcon_memory_stats falcon_memory_query(falcon_memory_tag tag) {
+    const counters &c = tags[tag_index(tag)];
+    falcon_memory_stats s;
+    s.live_bytes = c.live_bytes.load(std::memory_order_relaxed);
+    s.peak_bytes = c.peak_bytes.load(std::memory_order_relaxed);
+    s.num_live = c.num_live.load(std::memory_order_relaxed);
+    s.num_allocs = c.num_allocs.load(std::memory_order_relaxed);
+    return s;
+}
+
+const char *falcon_memory_backend(void) {
+#if defined(FALCON_MEMORY_BACKEND_SYSTEM)
+    return "system";
+#elif defined(FALCON_MEMORY_BACKEND_POOL)
+    return "pool";
+#else
+    return "tracking";
+#endif
+}
+
+} // extern "C"
+
+#if defined(FALCON_MEMORY_TRACK_NEW)
+
+// global new and delete charged to the app tag (aligned variants keep the
+// default implementation)
+void *operator new(std::size_t size) {
+    if (void *p = falcon_malloc(FALCON_MEMORY_TAG_APP, size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    return falcon_malloc(FALCON_MEMORY_TAG_APP, size ? size : 1);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return falcon_malloc(FALCON_MEMORY_TAG_APP, size ? size : 1);
+}
+
+void operator delete(void *p) noexcept {
+    falcon_free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    falcon_free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    falcon_free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept {
+    falcon_free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+    falcon_free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+    falcon_free(p);
+}
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef FALCON_ALLOCATOR_H_
+#define FALCON_ALLOCATOR_H_
+
+// tagged allocation for sokol and falcon
+//
+// C interface, so sokol.c can route SOKOL_MALLOC/SOKOL_FREE through it. the
+// backend is chosen at build time with FALCON_MEMORY_BACKEND:
+//   tracking  malloc with a 16 byte header, live and peak bytes per tag
+//   pool      tracking with size-class free lists for small blocks
+//   system    plain malloc/free, nothing is counted
+// blocks have to be released with falcon_free.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// memory tag
+typedef enum falcon_memory_tag {
+    FALCON_MEMORY_TAG_GFX,
+    FALCON_MEMORY_TAG_FETCH,
+    FALCON_MEMORY_TAG_AUDIO,
+    FALCON_MEMORY_TAG_APP,
+    FALCON_MEMORY_TAG_NUM,
+} falcon_memory_tag;
+
+// memory statistics of a tag (user bytes, without headers)
+typedef struct falcon_memory_stats {
+    int64_t live_bytes;
+    int64_t peak_bytes;
+    int64_t num_live;
+    int64_t num_allocs;
+} falcon_memory_stats;
+
+// allocate, nullptr on failure
+void *falcon_malloc(falcon_memory_tag tag, size_t size);
+
+// allocate zeroed memory, nullptr on failure
+void *falcon_calloc(falcon_memory_tag tag, size_t count, size_t size);
+
+// release a block (nullptr is ignored)
+void falcon_free(void *p);
+
+// get statistics of a tag (any thread)
+falcon_memory_stats falcon_memory_query(falcon_memory_tag tag);
+
+// get backend name
+const char *falcon_memory_backend(void);
+
+#ifdef __cplusplus
+} // extern "C"
+
+#include <cstddef>
+#include <new>
+
+namespace falcon {
+
+// STL allocator charging a tag
+template <class T, falcon_memory_tag Tag = FALCON_MEMORY_TAG_APP>
+struct tagged_allocator {
+    using value_type = T;
+
+    template <class U>
+    struct rebind {
+        using other = tagged_allocator<U, Tag>;
+    };
+
+    tagged_allocator() = default;
+
+    template <class U>
+    tagged_allocator(const tagged_allocator<U, Tag> &) {}
+
+    inline T *allocate(std::size_t n) {
+        if (void *p = falcon_malloc(Tag, n * sizeof(T))) {
+            return static_cast<T *>(p);
+        }
+        throw std::bad_alloc();
+    }
+
+    inline void deallocate(T *p, std::size_t) { falcon_free(p); }
+
+    template <class U>
+    inline bool operator==(const tagged_allocator<U, Tag> &) const { return true; }
+
+    template <class U>
+    inline bool operator!=(const tagged_allocator<U, Tag> &) const { return false; }
+};
+
+} // namespace falcon
+
+#endif // __cplusplus
+
+#endif // FALCON_ALLOCATOR_H_
@@ -1,4 +1,15 @@
 #include "application.h"
+#include "debug_draw.h"
+#include "gfx.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <random>
+#include <thread>
 
 #include "sokol_app.h"
 #include "sokol_gfx.h"
@@ -9,6 +20,45 @@
 
 namespace {
 
+// frame index, only advanced by application::frame_cb
+uint64_t frame_count = 0;
+
+// sokol calls of benchmark and replay runs, deterministic unlike timings
+struct call_counters {
+    uint64_t frames;
+    uint64_t passes;
+    uint64_t pipelines;
+    uint64_t bindings;
+    uint64_t uniforms;
+    uint64_t draws;
+};
+call_counters counters = {};
+
+// trace hooks counting calls
+void count_default_pass(const sg_pass_action *, int, int, void *) {
+    counters.passes++;
+}
+
+void count_pass(sg_pass, const sg_pass_action *, void *) {
+    counters.passes++;
+}
+
+void count_pipeline(sg_pipeline, void *) {
+    counters.pipelines++;
+}
+
+void count_bindings(const sg_bindings *, void *) {
+    counters.bindings++;
+}
+
+void count_uniforms(sg_shader_stage, int, const void *, int, void *) {
+    counters.uniforms++;
+}
+
+void count_draw(int, int, int, void *) {
+    counters.draws++;
+}
+
 // init callback
 void init(void *userdata) {
     if (auto *app = static_cast<falcon::application *>(userdata)) {
@@ -44,10 +94,36 @@ void fail(const char *message, void *userdata) {
     }
 }
 
+// check for events replaced by a replay
+bool is_input(const sapp_event *ev) {
+    switch (ev->type) {
+    case SAPP_EVENTTYPE_KEY_DOWN:
+    case SAPP_EVENTTYPE_KEY_UP:
+    case SAPP_EVENTTYPE_CHAR:
+    case SAPP_EVENTTYPE_MOUSE_DOWN:
+    case SAPP_EVENTTYPE_MOUSE_UP:
+    case SAPP_EVENTTYPE_MOUSE_SCROLL:
+    case SAPP_EVENTTYPE_MOUSE_MOVE:
+    case SAPP_EVENTTYPE_MOUSE_ENTER:
+    case SAPP_EVENTTYPE_MOUSE_LEAVE:
+    case SAPP_EVENTTYPE_TOUCHES_BEGAN:
+    case SAPP_EVENTTYPE_TOUCHES_MOVED:
+    case SAPP_EVENTTYPE_TOUCHES_ENDED:
+    case SAPP_EVENTTYPE_TOUCHES_CANCELLED:
+        return true;
+    default:
+        return false;
+    }
+}
+
 } // namespace
 
 namespace falcon {
 
+uint64_t gfx::frame_index() {
+    return frame_count;
+}
+
 void application::setup(int argc, char** argv, sapp_desc &desc) {
     // setup arguments
     {
@@ -69,6 +145,12 @@ void application::setup(int argc, char** argv, sapp_desc &desc) {
 }
 
 void application::shutdown() {
+    _jobs.shutdown();
+    _resources.shutdown();
+    _pacer.shutdown();
+    _frame_memory.shutdown();
+    _double_frame_memory.shutdown();
+    debug_draw::shutdown();
     sfetch_shutdown();
     sargs_shutdown();
     sg_shutdown();
@@ -105,25 +187,120 @@ void application::init_cb() {
     // time
     stm_setup();
 
+    // workers
+    _jobs.setup();
+
+    // deferred resource creation, ids for worker threads are reserved on
+    // request with resources().set_reserve()
+    gfx::creation_queue_desc resources_desc;
+    resources_desc.reserved_buffers = 0;
+    resources_desc.reserved_images = 0;
+    _resources.setup(resources_desc);
+
+    // per-frame memory
+    _frame_memory.setup({});
+    _double_frame_memory.setup({ 1024 * 1024, 2 });
+
+    // frame pacing, keeps a target set in configure()
+    _pacer.setup(_pacer.desc());
+
+    // input recording
+    start_recorder();
+
+    // non-interactive benchmark run
+    _bench_frames = std::max(atoi(sargs_value_def("bench_frames", "0")), 0);
+    _bench_frame = 0;
+
+    // count sokol calls of benchmark and replay runs
+    if (_bench_frames > 0 || _recorder.mode() == recorder_mode::replay) {
+        sg_trace_hooks hooks = {};
+        hooks.begin_default_pass = count_default_pass;
+        hooks.begin_pass = count_pass;
+        hooks.apply_pipeline = count_pipeline;
+        hooks.apply_bindings = count_bindings;
+        hooks.apply_uniforms = count_uniforms;
+        hooks.draw = count_draw;
+        sg_install_trace_hooks(&hooks);
+        _count_calls = true;
+    }
+
     // user callback
     init();
 }
 
 void application::frame_cb() {
+    // pace before the frame
+    if (!_pacer.late_input()) {
+        _pacer.wait();
+    }
+
+    const uint64_t frame_start = stm_now();
+
     // update fetch
     sfetch_dowork();
 
+    // create queued resources
+    _resources.process();
+
     // update delta time
     _delta_time = stm_sec(stm_laptime(&_last_time));
 
+    // record or replay input
+    step_recorder();
+
+    // skip the frame when nothing changed
+    if (_on_demand) {
+        const bool active = redraw_needed();
+        account_frame(active);
+        if (!active) {
+            idle();
+            std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(_idle_sleep_ms));
+            return;
+        }
+    }
+
     // user callback
-    frame();
+    if (_pipelined) {
+        frame_pipelined();
+    }
+    else {
+        begin_update_frame();
+        frame();
+    }
+
+    // debug lines on top of the frame, in a pass of their own only when
+    // there are any
+    if (debug_draw::valid() && debug_draw::enabled()) {
+        debug_draw::render(width(), height());
+    }
 
     // update gfx
     sg_commit();
+    frame_count++;
+    counters.frames += _count_calls ? 1 : 0;
+
+    if (_recorder.mode() == recorder_mode::replay) {
+        _recorder.account(stm_ms(stm_since(frame_start)), _timings.update_ms, _timings.render_ms);
+    }
+
+    // end a benchmark run
+    if (_bench_frames > 0 && ++_bench_frame == _bench_frames) {
+        finish_bench();
+    }
+
+    // pace before the next events
+    if (_pacer.late_input()) {
+        _pacer.wait();
+    }
 }
 
 void application::cleanup_cb() {
+    // finish a running update
+    _jobs.wait(_update_counter);
+
+    // flush a recording
+    _recorder.stop();
+
     // user callback
     cleanup();
 
@@ -132,15 +309,305 @@ void application::cleanup_cb() {
 }
 
 void application::event_cb(const sapp_event *ev) {
+    // live input is replaced by the replay
+    if (_recorder.mode() == recorder_mode::replay && is_input(ev)) {
+        return;
+    }
+    _recorder.add_event(ev);
+    dispatch_event(ev);
+}
+
+void application::dispatch_event(const sapp_event *ev) {
+    // accumulate input
+    const bool discrete = _input.handle(ev);
+
+    // wake up
+    if (_on_demand) {
+        request_redraw();
+    }
+
     // user callback
-    event(ev);
+    if (discrete || !_coalesce_input) {
+        event(ev);
+    }
 }
 
 void application::fail_cb(const char *message) {
-    //SOKOL_LOG(message);
-    
+    // log like sokol does without SOKOL_LOG
+    fputs(message, stderr);
+    fputc('\n', stderr);
+
     // user callback
     fail(message);
 }
 
+void application::set_pipelined(bool enabled) {
+    if (_pipelined && !enabled) {
+        _jobs.wait(_update_counter);
+    }
+    _pipelined = enabled;
+    _update_started = false;
+}
+
+void application::frame() {
+    run_update(_delta_time);
+    collect_update_timings();
+    _update_index ^= 1;
+    run_render();
+}
+
+void application::set_frame_rate(double fps, bool late_input) {
+    _pacer.set_target((fps > 0.0) ? 1000.0 / fps : 0.0);
+    _pacer.set_late_input(late_input);
+}
+
+void application::set_fixed_timestep(double tick_rate, int max_steps) {
+    _jobs.wait(_update_counter);
+    _fixed_delta = (tick_rate > 0.0) ? 1.0 / tick_rate : 0.0;
+    _max_fixed_steps = std::max(max_steps, 1);
+    _accumulator = 0.0;
+}
+
+void application::run_update(double dt) {
+    const uint64_t start = stm_now();
+    int steps = 0;
+    double dropped = 0.0;
+    if (_fixed_delta > 0.0) {
+        _accumulator += dt;
+        while (_accumulator >= _fixed_delta && steps < _max_fixed_steps) {
+            fixed_update(_fixed_delta);
+            _accumulator -= _fixed_delta;
+            steps++;
+        }
+
+        // drop whole steps that did not fit, keep the fraction for alpha
+        if (_accumulator >= _fixed_delta) {
+            dropped = std::floor(_accumulator / _fixed_delta) * _fixed_delta;
+            _accumulator -= dropped;
+        }
+        _alpha[_update_index] = static_cast<float>(_accumulator / _fixed_delta);
+    }
+    update(dt);
+    _update_timings.update_ms = stm_ms(stm_since(start));
+    _update_timings.fixed_steps = steps;
+    _update_timings.dropped_ms = dropped * 1000.0;
+}
+
+void application::collect_update_timings() {
+    _timings.update_ms = _update_timings.update_ms;
+    _timings.fixed_steps = _update_timings.fixed_steps;
+    _timings.dropped_ms = _update_timings.dropped_ms;
+}
+
+void application::run_render() {
+    const uint64_t start = stm_now();
+    render();
+    _timings.render_ms = stm_ms(stm_since(start));
+}
+
+void application::frame_pipelined() {
+    // the update of this frame was started last frame, the first one runs here
+    const uint64_t start = stm_now();
+    if (_update_started) {
+        _jobs.wait(_update_counter);
+    }
+    else {
+        begin_update_frame();
+        run_update(_delta_time);
+        _update_started = true;
+    }
+    _timings.wait_ms = stm_ms(stm_since(start));
+    collect_update_timings();
+
+    // debug lines of the finished update are drawn with this frame, the
+    // next update adds its own while this one is rendered
+    debug_draw::collect();
+
+    // update the next frame while this one is rendered
+    _update_index ^= 1;
+    begin_update_frame();
+    const double dt = _delta_time;
+    _jobs.submit([this, dt] { run_update(dt); }, &_update_counter);
+    run_render();
+}
+
+void application::set_on_demand(bool enabled, double idle_sleep_ms, int settle_frames) {
+    _on_demand = enabled;
+    _idle_sleep_ms = std::max(idle_sleep_ms, 0.0);
+    _settle_frames = std::max(settle_frames, 0);
+    _redraw_stats = {};
+    _frame_start = 0;
+    request_redraw();
+}
+
+void application::request_redraw() {
+    _redraw_frames.store(1 + _settle_frames, std::memory_order_relaxed);
+}
+
+void application::set_animating(bool enabled) {
+    // settle the last animated frame
+    if (_animating && !enabled) {
+        request_redraw();
+    }
+    _animating = enabled;
+}
+
+bool application::redraw_needed() {
+    // resources created or failed since the last frame
+    const gfx::creation_queue_stats &rs = _resources.stats();
+    const int done = rs.num_created + rs.num_failed;
+    if (done != _resources_done) {
+        _resources_done = done;
+        request_redraw();
+    }
+
+    if (_animating) {
+        return true;
+    }
+    int frames = _redraw_frames.load(std::memory_order_relaxed);
+    while (frames > 0 && !_redraw_frames.compare_exchange_weak(frames, frames - 1, std::memory_order_relaxed)) {
+    }
+    return frames > 0;
+}
+
+void application::account_frame(bool active) {
+    const uint64_t now = stm_now();
+    const double cpu = 1000.0 * static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+    if (_frame_start != 0) {
+        const double wall_ms = stm_ms(stm_diff(now, _frame_start));
+        const double cpu_ms = cpu - _frame_cpu;
+        if (_frame_active) {
+            _redraw_stats.num_active++;
+            _redraw_stats.active_ms += wall_ms;
+            _redraw_stats.active_cpu_ms += cpu_ms;
+        }
+        else {
+            _redraw_stats.num_idle++;
+            _redraw_stats.idle_ms += wall_ms;
+            _redraw_stats.idle_cpu_ms += cpu_ms;
+        }
+    }
+    _frame_active = active;
+    _frame_start = now;
+    _frame_cpu = cpu;
+}
+
+void application::start_recorder() {
+    if (sargs_exists("replay")) {
+        const char *path = sargs_value("replay");
+        if (!_recorder.replay(path)) {
+            fail_cb((std::string("replay ") + path + ": " + _recorder.error()).c_str());
+            return;
+        }
+        _replay_delta = atof(sargs_value_def("replay_delta", "16.667")) / 1000.0;
+        _replay_quit = atoi(sargs_value_def("replay_quit", "1")) != 0;
+        srand(_recorder.seed());
+    }
+    else if (sargs_exists("record")) {
+        const char *path = sargs_value("record");
+        const uint32_t seed = std::random_device{}();
+        if (!_recorder.record(path, seed)) {
+            fail_cb((std::string("record ") + path + ": " + _recorder.error()).c_str());
+            return;
+        }
+        srand(seed);
+    }
+}
+
+void application::step_recorder() {
+    if (_recorder.mode() == recorder_mode::record) {
+        _recorder.end_frame(_delta_time);
+    }
+    else if (_recorder.mode() == recorder_mode::replay) {
+        double dt = 0.0;
+        if (!_recorder.next_frame(dt, _replay_events)) {
+            finish_replay();
+            return;
+        }
+        _delta_time = (_replay_delta > 0.0) ? _replay_delta : dt;
+        for (const sapp_event &ev : _replay_events) {
+            dispatch_event(&ev);
+        }
+    }
+}
+
+void application::finish_replay() {
+    const replay_stats s = _recorder.stats();
+    _recorder.stop();
+
+    // times relative to the reference workload. the fastest frame only
+    // catches large changes, the slowest one depends on what else runs on
+    // the machine and is only noted
+    const double reference_ms = bench_report::reference_ms();
+    _bench.note("frame_ms", s.frame_ms);
+    _bench.note("min_frame_ms", s.min_frame_ms);
+    _bench.note("max_frame_ms", s.max_frame_ms);
+    _bench.note("update_ms", s.update_ms);
+    _bench.note("render_ms", s.render_ms);
+    _bench.note("max_frame_ratio", s.max_frame_ms / reference_ms);
+    _bench.add("frame_ratio", s.frame_ms / reference_ms);
+    _bench.add("min_frame_ratio", s.min_frame_ms / reference_ms, 0.5);
+    _bench.add("update_ratio", s.update_ms / reference_ms);
+    _bench.add("render_ratio", s.render_ms / reference_ms);
+
+    // share of redrawn frames, lower is better for a replayed scenario
+    if (_on_demand) {
+        const int total = _redraw_stats.num_active + _redraw_stats.num_idle;
+        _bench.add("active_ratio", (total > 0) ? static_cast<double>(_redraw_stats.num_active) / total : 0.0);
+    }
+    finish_report("replay");
+
+    if (_replay_quit) {
+        quit();
+    }
+}
+
+void application::finish_bench() {
+    finish_report("bench");
+    quit();
+}
+
+void application::finish_report(const char *prefix) {
+    const std::string report = std::string(prefix) + "_report";
+    const std::string baseline = std::string(prefix) + "_baseline";
+    const std::string tolerance = std::string(prefix) + "_tolerance";
+
+    // calls per frame only change with the code
+    if (counters.frames > 0) {
+        const double n = static_cast<double>(counters.frames);
+        _bench.add("passes_per_frame", counters.passes / n, 0.05);
+        _bench.add("pipelines_per_frame", counters.pipelines / n, 0.05);
+        _bench.add("bindings_per_frame", counters.bindings / n, 0.05);
+        _bench.add("uniforms_per_frame", counters.uniforms / n, 0.05);
+        _bench.add("draws_per_frame", counters.draws / n, 0.05);
+    }
+
+    for (const std::string &f : _bench.failures()) {
+        fail_cb(("check failed: " + f).c_str());
+        _report_failed = true;
+    }
+    if (sargs_exists(report.c_str()) && !_bench.write(sargs_value(report.c_str()))) {
+        fail_cb((report + " " + sargs_value(report.c_str()) + ": cannot write file").c_str());
+        _report_failed = true;
+    }
+    if (sargs_exists(baseline.c_str())) {
+        const char *path = sargs_value(baseline.c_str());
+        std::vector<std::string> regressions;
+        if (!_bench.compare(path, atof(sargs_value_def(tolerance.c_str(), "0.1")), regressions)) {
+            fail_cb((baseline + " " + path + ": cannot read file").c_str());
+            _report_failed = true;
+        }
+        for (const std::string &r : regressions) {
+            fail_cb(("regression " + r).c_str());
+        }
+        _report_failed |= !regressions.empty();
+    }
+}
+
+void application::begin_update_frame() {
+    _frame_memory.reset();
+    _double_frame_memory.reset();
+    _input.publish(_inputs[_update_index]);
+}
+
 } // namespace falcon
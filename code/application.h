@@ -1,10 +1,53 @@
 #ifndef FALCON_APPLICATION_H_
 #define FALCON_APPLICATION_H_
 
+#include <atomic>
+#include <string>
+#include <vector>
+
 #include "sokol_app.h"
 
+#include "bench_report.h"
+#include "creation_queue.h"
+#include "frame_arena.h"
+#include "frame_pacer.h"
+#include "input.h"
+#include "input_recorder.h"
+#include "job_system.h"
+
 namespace falcon {
 
+// cpu time of the frame stages (last frame)
+struct frame_timings {
+    // update() on the calling thread or a worker
+    double update_ms;
+
+    // render() on the main thread
+    double render_ms;
+
+    // main thread waiting for the previous update
+    double wait_ms;
+
+    // fixed steps run and simulation time dropped by the catch-up limit
+    int fixed_steps;
+    double dropped_ms;
+};
+
+// render-on-demand statistics (since enabling, wall and process cpu time)
+struct redraw_stats {
+    // frames that ran frame() and frames that were skipped
+    int num_active;
+    int num_idle;
+
+    // wall time from the start of a frame to the start of the next one
+    double active_ms;
+    double idle_ms;
+
+    // cpu time of all threads over the same spans
+    double active_cpu_ms;
+    double idle_cpu_ms;
+};
+
 // sokol_app wrapper
 class application {
 public:
@@ -38,7 +81,7 @@ public:
     // event callback
     void event_cb(const sapp_event *ev);
 
-    // fail callback
+    // fail callback, also reports errors of the application (logged to stderr)
     void fail_cb(const char *message);
 
     // get main window width
@@ -50,6 +93,122 @@ public:
     // get delta time
     inline double delta_time() const { return _delta_time; }
 
+    // get worker threads
+    inline job_system &jobs() { return _jobs; }
+
+    // get deferred resource creation (nothing is reserved for worker threads
+    // until resources().set_reserve() is called)
+    inline gfx::creation_queue &resources() { return _resources; }
+
+    // get per-frame memory, reset before frame() or, in pipelined mode,
+    // before update() is started (1 MiB until set up again in init())
+    inline frame_arena &frame_memory() { return _frame_memory; }
+
+    // get per-frame memory that stays valid during the following frame, for
+    // results of a pipelined update() that render() reads one frame later
+    inline frame_arena &double_frame_memory() { return _double_frame_memory; }
+
+    // get frame pacer, unlimited until a target is set
+    //
+    // the pacer waits at the start of frame_cb, before the delta time is
+    // sampled, so the frame is presented as soon as it is rendered. with
+    // late_input it waits at the end of frame_cb instead: sokol delivers the
+    // events of the next frame after the wait, right before they are
+    // simulated, and presentation is delayed by the wait.
+    inline frame_pacer &pacer() { return _pacer; }
+
+    // limit the frame rate (0: unlimited)
+    void set_frame_rate(double fps, bool late_input = false);
+
+    // input of the frame being simulated, published before frame() or, in
+    // pipelined mode, before update() is started (any thread)
+    inline const input_snapshot &input() const { return _inputs[_update_index]; }
+
+    // input of the snapshot drawn by render()
+    inline const input_snapshot &render_input() const { return _inputs[render_index()]; }
+
+    // only pass discrete events to event(), mouse move and scroll events are
+    // then only visible through input()
+    inline void set_coalesce_input(bool enabled) { _coalesce_input = enabled; }
+
+    // get input recorder
+    //
+    // started from the command line: record=<file> writes events, frame
+    // deltas and the random seed of the run, replay=<file> plays them back
+    // with a fixed delta time of replay_delta milliseconds (default 16.667,
+    // 0 uses the recorded deltas). live input events are ignored during a
+    // replay, srand() is called with the recorded seed and the app quits
+    // after printing frame time statistics, unless replay_quit=0.
+    //
+    // replay_report=<file> writes the statistics and the bench() metrics as
+    // json. with replay_baseline=<file> they are compared against an earlier
+    // report, allowing replay_tolerance (default 0.1) slowdown per metric.
+    // regressions are reported through fail() and exit_code() turns 1.
+    inline const input_recorder &recorder() const { return _recorder; }
+
+    // get benchmark metrics, adding a name again adds a sample to its median
+    //
+    // bench_frames=<n> on the command line runs n frames and quits. the
+    // metrics are then handled like a replay report with bench_report=<file>,
+    // bench_baseline=<file> and bench_tolerance (default 0.1). failed
+    // bench().check() calls fail both kinds of runs.
+    inline bench_report &bench() { return _bench; }
+
+    // process exit status, 1 after a failed report comparison
+    inline int exit_code() const { return _report_failed ? 1 : 0; }
+
+    // seed of the recorded or replayed run (0 otherwise)
+    inline uint32_t seed() const { return _recorder.seed(); }
+
+    // run update() for the next frame on a worker while render() draws the
+    // current one, frame() is not called in this mode
+    //
+    // update() must then only touch the update_index() snapshot and not call
+    // sokol, render() reads the render_index() snapshot. events arrive on
+    // the main thread while update() runs and have to be queued.
+    void set_pipelined(bool enabled);
+
+    // check pipelined mode
+    inline bool pipelined() const { return _pipelined; }
+
+    // snapshot slot written by update() and read by render() (0 or 1)
+    inline int update_index() const { return _update_index; }
+    inline int render_index() const { return _update_index ^ 1; }
+
+    // get stage timings
+    inline const frame_timings &timings() const { return _timings; }
+
+    // run fixed_update() at tick_rate Hz before every update(), at most
+    // max_steps times per frame. time beyond that is dropped instead of being
+    // caught up later, so a long frame cannot snowball (0 disables)
+    void set_fixed_timestep(double tick_rate, int max_steps = 5);
+
+    // only run frame() and sg_commit() when something changed: an event
+    // arrived, a queued resource was created, request_redraw() was called or
+    // an animation is running. other frames call idle() and sleep for
+    // idle_sleep_ms. every redraw is drawn settle_frames more times so all
+    // swapchain buffers hold the latest image while idle.
+    void set_on_demand(bool enabled, double idle_sleep_ms = 10.0, int settle_frames = 2);
+
+    // check render-on-demand mode
+    inline bool on_demand() const { return _on_demand; }
+
+    // redraw at least once (any thread)
+    void request_redraw();
+
+    // keep redrawing while an animation runs
+    void set_animating(bool enabled);
+
+    // get render-on-demand statistics
+    inline const redraw_stats &redraws() const { return _redraw_stats; }
+
+    // get fixed step in seconds (0 when disabled)
+    inline double fixed_delta() const { return _fixed_delta; }
+
+    // blend factor between the previous and the latest fixed step of the
+    // rendered snapshot (time left in the accumulator / fixed_delta())
+    inline float alpha() const { return _alpha[render_index()]; }
+
 protected:
     // configure
     virtual void configure(sapp_desc &desc) {}
@@ -57,8 +216,20 @@ protected:
     // initialize
     virtual void init() {}
 
-    // update
-    virtual void frame() {}
+    // frame, by default update() followed by render()
+    virtual void frame();
+
+    // simulate one fixed step, called before update()
+    virtual void fixed_update(double dt) {}
+
+    // simulate into the update_index() snapshot
+    virtual void update(double dt) {}
+
+    // draw the render_index() snapshot
+    virtual void render() {}
+
+    // frame skipped in render-on-demand mode, poll loaders here
+    virtual void idle() {}
 
     // cleanup
     virtual void cleanup() {}
@@ -70,15 +241,125 @@ protected:
     virtual void fail(const char *message) {}
 
 private:
+    // timed stages
+    void run_update(double dt);
+    void run_render();
+
+    // take over the timings of a finished update
+    void collect_update_timings();
+
+    // wait for the running update, start the next one and render
+    void frame_pipelined();
+
+    // check whether this frame has to be drawn
+    bool redraw_needed();
+
+    // account the previous frame and start timing this one
+    void account_frame(bool active);
+
+    // pass an event to input and user code
+    void dispatch_event(const sapp_event *ev);
+
+    // start recording or replaying from the arguments
+    void start_recorder();
+
+    // record the events of this frame or replay the next frame
+    void step_recorder();
+
+    // report and compare replay statistics
+    void finish_replay();
+
+    // report and compare the metrics of a bench_frames run and quit
+    void finish_bench();
+
+    // write the metrics to <prefix>_report and compare them against
+    // <prefix>_baseline with <prefix>_tolerance
+    void finish_report(const char *prefix);
+
+    // start a frame of the update slot: reset frame memory, publish input
+    void begin_update_frame();
+
     // last time
     uint64_t _last_time;
 
     // delta time
     double _delta_time;
+
+    // worker threads
+    job_system _jobs;
+
+    // deferred resource creation
+    gfx::creation_queue _resources;
+
+    // per-frame memory
+    frame_arena _frame_memory;
+    frame_arena _double_frame_memory;
+
+    // frame pacing
+    frame_pacer _pacer;
+
+    // input, one snapshot per update slot
+    input_system _input;
+    input_snapshot _inputs[2];
+    bool _coalesce_input = false;
+
+    // input recording
+    input_recorder _recorder;
+    std::vector<sapp_event> _replay_events;
+    double _replay_delta = 0.0;
+    bool _replay_quit = true;
+
+    // benchmark metrics, exit_code() 1 after a regression
+    bench_report _bench;
+    int _bench_frames = 0;
+    int _bench_frame = 0;
+    bool _report_failed = false;
+
+    // sokol calls are counted in benchmark and replay runs
+    bool _count_calls = false;
+
+    // pipelined update
+    bool _pipelined = false;
+    bool _update_started = false;
+    int _update_index = 0;
+    job_counter _update_counter;
+
+    // render on demand
+    bool _on_demand = false;
+    bool _animating = false;
+    double _idle_sleep_ms = 10.0;
+    int _settle_frames = 2;
+    std::atomic<int> _redraw_frames{ 0 };
+    int _resources_done = 0;
+    bool _frame_active = true;
+    uint64_t _frame_start = 0;
+    double _frame_cpu = 0.0;
+    redraw_stats _redraw_stats{};
+
+    // fixed timestep
+    double _fixed_delta = 0.0;
+    int _max_fixed_steps = 5;
+    double _accumulator = 0.0;
+    float _alpha[2] = { 1.f, 1.f };
+
+    // stage timings (update fields are written by the updating thread)
+    frame_timings _update_timings{};
+    frame_timings _timings{};
 };
 
 } // namespace falcon
 
+#if defined(SOKOL_NO_ENTRY)
+// sapp_run() returns on desktop platforms, the app then sets the exit status
+#define FALCON_MAIN(APP) \
+int main(int argc, char* argv[]) { \
+    static APP _app; \
+    sapp_desc desc = {}; \
+    _app.setup(argc, argv, desc); \
+    sapp_run(&desc); \
+    return _app.exit_code(); \
+}
+#else
 #define FALCON_MAIN(APP) \
 sapp_desc sokol_main(int argc, char* argv[]) { \
     static APP _app; \
@@ -86,5 +367,6 @@ sapp_desc sokol_main(int argc, char* argv[]) { \
     _app.setup(argc, argv, desc); \
     return desc; \
 }
+#endif
 
 #endif // FALCON_APPLICATION_H_
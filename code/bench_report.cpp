@@ -0,0 +1,154 @@
+#include "bench_report.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <unordered_map>
+
+#include "sokol_time.h"
+
+namespace falcon {
+
+namespace {
+
+// smallest increase reported as a regression
+constexpr double min_difference = 0.01;
+
+// read a flat json object of numbers
+bool read_flat_json(const char *path, std::unordered_map<std::string, double> &out) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return false;
+    }
+    std::string text;
+    char buffer[4096];
+    size_t n = 0;
+    while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+        text.append(buffer, n);
+    }
+    fclose(f);
+
+    // "name" : number pairs, everything else is skipped
+    size_t i = 0;
+    while ((i = text.find('"', i)) != std::string::npos) {
+        const size_t end = text.find('"', i + 1);
+        if (end == std::string::npos) {
+            return false;
+        }
+        std::string name = text.substr(i + 1, end - i - 1);
+        i = text.find_first_not_of(" \t\r\n", end + 1);
+        if (i == std::string::npos || text[i] != ':') {
+            continue;
+        }
+        const char *begin = text.c_str() + i + 1;
+        char *stop = nullptr;
+        const double value = strtod(begin, &stop);
+        if (stop != begin) {
+            out[std::move(name)] = value;
+        }
+        i = static_cast<size_t>(stop - text.c_str());
+    }
+    return true;
+}
+
+} // namespace
+
+void bench_report::add(const char *name, double value, double tolerance) {
+    add_value(name, value, tolerance, true);
+}
+
+void bench_report::note(const char *name, double value) {
+    add_value(name, value, -1.0, false);
+}
+
+double bench_report::reference_ms() {
+    static double result = 0.0;
+    if (result > 0.0) {
+        return result;
+    }
+
+    // same input every run, fixed generator
+    std::vector<uint32_t> values(64 * 1024), work;
+    uint32_t state = 1;
+    for (uint32_t &v : values) {
+        state = state * 1664525u + 1013904223u;
+        v = state;
+    }
+    for (int run = 0; run < 5; run++) {
+        work = values;
+        const uint64_t start = stm_now();
+        std::sort(work.begin(), work.end());
+        const double ms = stm_ms(stm_since(start));
+        result = (run == 0) ? ms : std::min(result, ms);
+    }
+    return result;
+}
+
+void bench_report::check(bool ok, const char *message) {
+    if (ok) {
+        return;
+    }
+    for (const std::string &f : _failures) {
+        if (f == message) {
+            return;
+        }
+    }
+    _failures.push_back(message);
+}
+
+bool bench_report::write(const char *path) const {
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        return false;
+    }
+    fprintf(f, "{\n");
+    for (size_t i = 0; i < _metrics.size(); i++) {
+        fprintf(f, "    \"%s\": %.6f%s\n", _metrics[i].name.c_str(), _metrics[i].value, (i + 1 < _metrics.size()) ? "," : "");
+    }
+    fprintf(f, "}\n");
+    return fclose(f) == 0;
+}
+
+bool bench_report::compare(const char *path, double tolerance, std::vector<std::string> &regressions) const {
+    std::unordered_map<std::string, double> baseline;
+    if (!read_flat_json(path, baseline)) {
+        return false;
+    }
+
+    for (const bench_metric &m : _metrics) {
+        const auto i = baseline.find(m.name);
+        if (!m.tracked || i == baseline.end()) {
+            continue;
+        }
+        const double t = (m.tolerance >= 0.0) ? m.tolerance : tolerance;
+        const double limit = std::max(i->second * (1.0 + t), i->second + min_difference);
+        if (m.value > limit) {
+            char message[256];
+            snprintf(message, sizeof(message), "%s: %.3f, baseline %.3f (+%.0f%%, allowed +%.0f%%)",
+                m.name.c_str(), m.value, i->second, (i->second > 0.0) ? 100.0 * (m.value / i->second - 1.0) : 0.0, 100.0 * t);
+            regressions.push_back(message);
+        }
+    }
+    return true;
+}
+
+void bench_report::add_value(const char *name, double value, double tolerance, bool tracked) {
+    for (bench_metric &m : _metrics) {
+        if (m.name == name) {
+            m.samples.push_back(value);
+            std::vector<double> sorted = m.samples;
+            const size_t half = sorted.size() / 2;
+            std::nth_element(sorted.begin(), sorted.begin() + half, sorted.end());
+            m.value = sorted[half];
+            if (sorted.size() % 2 == 0) {
+                m.value = (m.value + *std::max_element(sorted.begin(), sorted.begin() + half)) * .5;
+            }
+            m.tolerance = (tolerance >= 0.0) ? tolerance : m.tolerance;
+            return;
+        }
+    }
+    _metrics.push_back({ name, value, tolerance, { value }, tracked });
+}
+
+} // namespace falcon
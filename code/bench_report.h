@@ -0,0 +1,85 @@
+#ifndef FALCON_BENCH_REPORT_H_
+#define FALCON_BENCH_REPORT_H_
+
+#include <string>
+#include <vector>
+
+namespace falcon {
+
+// benchmark result, lower is better
+struct bench_metric {
+    std::string name;
+    double value = 0.0;
+
+    // allowed slowdown over the baseline as a fraction (< 0: the default)
+    double tolerance = -1.0;
+
+    // added values, value is their median
+    std::vector<double> samples;
+
+    // compared against the baseline (false: only written)
+    bool tracked = true;
+};
+
+// benchmark results written to and compared against json files
+//
+// the file is a flat json object of metric names and numbers. a metric is a
+// regression when it exceeds its baseline value by more than its tolerance,
+// metrics missing on either side are skipped. adding a name again adds a
+// sample and the value is the median of all samples, so per-frame timings
+// can be added every frame and frames preempted by other processes do not
+// count. failed checks of results fail the run with or without a baseline.
+//
+// absolute timings depend on the machine and its load. tracked timings are
+// ratios to a reference measured in the same run, either another
+// implementation of the same work or reference_ms(); absolute values are
+// only noted. increases below 0.01 are ignored, they are noise of ratios of
+// very short timings.
+class bench_report {
+public:
+    // add a metric or a sample of it
+    void add(const char *name, double value, double tolerance = -1.0);
+
+    // add a metric that is written but never compared
+    void note(const char *name, double value);
+
+    // record a failed check of a result, repeated messages are kept once
+    void check(bool ok, const char *message);
+
+    // remove all metrics and failed checks
+    inline void clear() {
+        _metrics.clear();
+        _failures.clear();
+    }
+
+    // write the metrics as json
+    bool write(const char *path) const;
+
+    // compare against a baseline file, false if it cannot be read. messages
+    // describing the regressions are appended to regressions.
+    bool compare(const char *path, double tolerance, std::vector<std::string> &regressions) const;
+
+    // get metrics
+    inline const std::vector<bench_metric> &metrics() const { return _metrics; }
+
+    // get messages of failed checks
+    inline const std::vector<std::string> &failures() const { return _failures; }
+
+    // time of a fixed cpu workload (sorting 64k integers), the fastest of a
+    // few runs measured once per process
+    static double reference_ms();
+
+private:
+    // add a metric or a sample of it
+    void add_value(const char *name, double value, double tolerance, bool tracked);
+
+    // metrics in insertion order
+    std::vector<bench_metric> _metrics;
+
+    // failed checks
+    std::vector<std::string> _failures;
+};
+
+} // namespace falcon
+
+#endif // FALCON_BENCH_REPORT_H_
@@ -0,0 +1,269 @@
+#include "creation_queue.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "sokol_time.h"
+
+namespace falcon::gfx {
+
+void creation_queue::setup(const creation_queue_desc &desc) {
+    shutdown();
+
+    _desc = desc;
+    _main_thread = std::this_thread::get_id();
+    _stats = {};
+    _num_exhausted = 0;
+    _valid = true;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    refill();
+}
+
+void creation_queue::shutdown() {
+    if (!_valid) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (uint32_t id : _buffer_reserve) {
+        sg_dealloc_buffer({ id });
+    }
+    for (uint32_t id : _image_reserve) {
+        sg_dealloc_image({ id });
+    }
+    for (const item &it : _queue) {
+        if (it.buffer.id != SG_INVALID_ID && sg_query_buffer_state(it.buffer) == SG_RESOURCESTATE_ALLOC) {
+            sg_dealloc_buffer(it.buffer);
+        }
+        if (it.image.id != SG_INVALID_ID && sg_query_image_state(it.image) == SG_RESOURCESTATE_ALLOC) {
+            sg_dealloc_image(it.image);
+        }
+    }
+    _buffer_reserve.clear();
+    _image_reserve.clear();
+    _queue.clear();
+    _pending.clear();
+    _valid = false;
+}
+
+sg_buffer creation_queue::make_buffer(const sg_buffer_desc &desc) {
+    if (!_valid) {
+        return {};
+    }
+
+    // copy content outside the lock
+    item it{};
+    it.buffer_desc = desc;
+    if (desc.content && desc.size > 0) {
+        const auto *src = static_cast<const uint8_t *>(desc.content);
+        it.data.assign(src, src + desc.size);
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    it.buffer.id = take_id(_buffer_reserve, false);
+    if (it.buffer.id == SG_INVALID_ID) {
+        return {};
+    }
+    const sg_buffer buf = it.buffer;
+    _pending.insert(key(buf.id, false));
+    _queue.push_back(std::move(it));
+    return buf;
+}
+
+sg_image creation_queue::make_image(const sg_image_desc &desc) {
+    if (!_valid) {
+        return {};
+    }
+
+    // pack all subimages into one block, pointers are rebuilt in init
+    item it{};
+    it.image_desc = desc;
+    size_t total = 0;
+    for (const auto &face : desc.content.subimage) {
+        for (const auto &sub : face) {
+            total += (sub.ptr && sub.size > 0) ? static_cast<size_t>(sub.size) : 0;
+        }
+    }
+    it.data.resize(total);
+    size_t offset = 0;
+    for (int f = 0; f < SG_CUBEFACE_NUM; f++) {
+        for (int m = 0; m < SG_MAX_MIPMAPS; m++) {
+            auto &sub = it.image_desc.content.subimage[f][m];
+            if (!sub.ptr || sub.size <= 0) {
+                sub = {};
+                continue;
+            }
+            std::memcpy(it.data.data() + offset, sub.ptr, sub.size);
+            sub.ptr = reinterpret_cast<const void *>(offset);
+            offset += sub.size;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    it.image.id = take_id(_image_reserve, true);
+    if (it.image.id == SG_INVALID_ID) {
+        return {};
+    }
+    const sg_image img = it.image;
+    _pending.insert(key(img.id, true));
+    _queue.push_back(std::move(it));
+    return img;
+}
+
+void creation_queue::process() {
+    if (!_valid) {
+        return;
+    }
+    const uint64_t start = stm_now();
+
+    // refill the reserve
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        refill();
+    }
+
+    // at least one item per call, so a small budget still makes progress
+    for (;;) {
+        item it;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_queue.empty()) {
+                break;
+            }
+            it = std::move(_queue.front());
+            _queue.pop_front();
+        }
+        init(it);
+        if (stm_ms(stm_since(start)) >= _desc.budget_ms) {
+            break;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats.num_pending = static_cast<int>(_queue.size());
+    }
+    _stats.num_exhausted = _num_exhausted.load(std::memory_order_relaxed);
+    _stats.process_ms = stm_ms(stm_since(start));
+}
+
+void creation_queue::set_reserve(int buffers, int images) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _desc.reserved_buffers = std::max(buffers, 0);
+    _desc.reserved_images = std::max(images, 0);
+    if (_valid) {
+        refill();
+    }
+}
+
+bool creation_queue::pending(sg_buffer buf) const {
+    return lookup(key(buf.id, false));
+}
+
+bool creation_queue::pending(sg_image img) const {
+    return lookup(key(img.id, true));
+}
+
+sg_resource_state creation_queue::state(sg_buffer buf) const {
+    return pending(buf) ? SG_RESOURCESTATE_ALLOC : sg_query_buffer_state(buf);
+}
+
+sg_resource_state creation_queue::state(sg_image img) const {
+    return pending(img) ? SG_RESOURCESTATE_ALLOC : sg_query_image_state(img);
+}
+
+void creation_queue::refill() {
+    // an exhausted pool returns SG_INVALID_ID, which must not be handed out
+    while (static_cast<int>(_buffer_reserve.size()) < _desc.reserved_buffers) {
+        const uint32_t id = sg_alloc_buffer().id;
+        if (id == SG_INVALID_ID) {
+            break;
+        }
+        _buffer_reserve.push_back(id);
+    }
+    while (static_cast<int>(_image_reserve.size()) < _desc.reserved_images) {
+        const uint32_t id = sg_alloc_image().id;
+        if (id == SG_INVALID_ID) {
+            break;
+        }
+        _image_reserve.push_back(id);
+    }
+
+    // give back ids after the reserve was made smaller
+    while (static_cast<int>(_buffer_reserve.size()) > _desc.reserved_buffers) {
+        sg_dealloc_buffer({ _buffer_reserve.back() });
+        _buffer_reserve.pop_back();
+    }
+    while (static_cast<int>(_image_reserve.size()) > _desc.reserved_images) {
+        sg_dealloc_image({ _image_reserve.back() });
+        _image_reserve.pop_back();
+    }
+}
+
+uint32_t creation_queue::take_id(std::vector<uint32_t> &reserve, bool image) {
+    if (!reserve.empty()) {
+        const uint32_t id = reserve.back();
+        reserve.pop_back();
+        return id;
+    }
+    if (std::this_thread::get_id() == _main_thread) {
+        return image ? sg_alloc_image().id : sg_alloc_buffer().id;
+    }
+    _num_exhausted.fetch_add(1, std::memory_order_relaxed);
+    return SG_INVALID_ID;
+}
+
+void creation_queue::init(item &it) {
+    sg_resource_state result = SG_RESOURCESTATE_FAILED;
+    uint64_t k = 0;
+    if (it.buffer.id != SG_INVALID_ID) {
+        k = key(it.buffer.id, false);
+
+        // destroyed while queued
+        if (sg_query_buffer_state(it.buffer) != SG_RESOURCESTATE_ALLOC) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _pending.erase(k);
+            _stats.num_dropped++;
+            return;
+        }
+        it.buffer_desc.content = it.data.empty() ? nullptr : it.data.data();
+        sg_init_buffer(it.buffer, it.buffer_desc);
+        result = sg_query_buffer_state(it.buffer);
+    }
+    else {
+        k = key(it.image.id, true);
+        if (sg_query_image_state(it.image) != SG_RESOURCESTATE_ALLOC) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _pending.erase(k);
+            _stats.num_dropped++;
+            return;
+        }
+        for (auto &face : it.image_desc.content.subimage) {
+            for (auto &sub : face) {
+                if (sub.size > 0) {
+                    sub.ptr = it.data.data() + reinterpret_cast<uintptr_t>(sub.ptr);
+                }
+            }
+        }
+        sg_init_image(it.image, it.image_desc);
+        result = sg_query_image_state(it.image);
+    }
+
+    if (result == SG_RESOURCESTATE_VALID) {
+        _stats.num_created++;
+    }
+    else {
+        _stats.num_failed++;
+    }
+    // resolved, sokol knows the state from now on
+    std::lock_guard<std::mutex> lock(_mutex);
+    _pending.erase(k);
+}
+
+bool creation_queue::lookup(uint64_t k) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _pending.count(k) != 0;
+}
+
+} // namespace falcon::gfx
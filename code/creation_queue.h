@@ -0,0 +1,140 @@
+#ifndef FALCON_CREATION_QUEUE_H_
+#define FALCON_CREATION_QUEUE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "sokol_gfx.h"
+
+namespace falcon::gfx {
+
+// creation queue description
+struct creation_queue_desc {
+    // ids allocated ahead for other threads (each takes a sokol pool slot)
+    int reserved_buffers = 32;
+    int reserved_images = 32;
+
+    // main thread time per process() call
+    double budget_ms = 2.0;
+};
+
+// creation queue statistics
+struct creation_queue_stats {
+    int num_pending;
+    int num_created;
+    int num_failed;
+
+    // destroyed before they were initialized
+    int num_dropped;
+
+    // requests from other threads while the id reserve was empty
+    int num_exhausted;
+
+    // time of the last process() call
+    double process_ms;
+};
+
+// deferred buffer and image creation from any thread
+//
+// make_buffer/make_image return a handle immediately, taken from ids that
+// were allocated on the main thread with sg_alloc_buffer/sg_alloc_image, and
+// copy the descriptor content. process() runs sg_init_buffer/sg_init_image on
+// the main thread until the time budget is used up and refills the reserve.
+// until then the handle is in SG_RESOURCESTATE_ALLOC: it can be stored in
+// bindings, but must not be drawn with. when the reserve is empty, requests
+// from other threads return an invalid handle and count as exhausted. the
+// reserve stops short when a sokol pool runs out. labels are not copied.
+class creation_queue {
+public:
+    // ctor
+    creation_queue() = default;
+
+    // dtor
+    ~creation_queue() { shutdown(); }
+
+    creation_queue(const creation_queue &) = delete;
+    creation_queue &operator=(const creation_queue &) = delete;
+
+    // allocate the id reserve (main thread, after sg_setup)
+    void setup(const creation_queue_desc &desc);
+
+    // release reserved and pending ids (main thread, before sg_shutdown)
+    void shutdown();
+
+    // queue a buffer (any thread)
+    sg_buffer make_buffer(const sg_buffer_desc &desc);
+
+    // queue an image (any thread)
+    sg_image make_image(const sg_image_desc &desc);
+
+    // initialize queued resources within the budget (main thread)
+    void process();
+
+    // check whether a resource still waits for process() (any thread)
+    bool pending(sg_buffer buf) const;
+    bool pending(sg_image img) const;
+
+    // get state of a queued resource, SG_RESOURCESTATE_ALLOC while pending
+    // and the sokol state afterwards (main thread)
+    sg_resource_state state(sg_buffer buf) const;
+    sg_resource_state state(sg_image img) const;
+
+    // change the per-frame budget
+    inline void set_budget(double ms) { _desc.budget_ms = ms; }
+
+    // change the number of reserved ids (main thread)
+    void set_reserve(int buffers, int images);
+
+    // get statistics
+    inline const creation_queue_stats &stats() const { return _stats; }
+
+private:
+    // queued resource with its own copy of the content
+    struct item {
+        sg_buffer buffer;
+        sg_image image;
+        sg_buffer_desc buffer_desc;
+        sg_image_desc image_desc;
+        std::vector<uint8_t> data;
+    };
+
+    // allocate or release ids up to the reserve sizes (main thread, locked)
+    void refill();
+
+    // take a reserved id, or allocate one on the main thread
+    uint32_t take_id(std::vector<uint32_t> &reserve, bool image);
+
+    // initialize one item
+    void init(item &it);
+
+    // pending set key, buffer and image ids may collide
+    static inline uint64_t key(uint32_t id, bool image) { return (image ? (1ull << 32) : 0) | id; }
+
+    // look up a pending key
+    bool lookup(uint64_t key) const;
+
+    // description
+    creation_queue_desc _desc;
+    bool _valid = false;
+    std::thread::id _main_thread;
+
+    // reserved ids, queue and handed out ids until they are initialized
+    mutable std::mutex _mutex;
+    std::vector<uint32_t> _buffer_reserve;
+    std::vector<uint32_t> _image_reserve;
+    std::deque<item> _queue;
+    std::unordered_set<uint64_t> _pending;
+
+    // statistics
+    std::atomic<int> _num_exhausted{ 0 };
+    creation_queue_stats _stats{};
+};
+
+} // namespace falcon::gfx
+
+#endif // FALCON_CREATION_QUEUE_H_
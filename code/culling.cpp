@@ -0,0 +1,235 @@
+#include "culling.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "sokol_time.h"
+
+namespace {
+
+using falcon::math::vec4;
+
+// append the lanes of mask to out, branch free
+inline int append_mask(uint32_t *out, int n, int mask, int lanes, uint32_t first) {
+    for (int j = 0; j < lanes; j++) {
+        out[n] = first + static_cast<uint32_t>(j);
+        n += (mask >> j) & 1;
+    }
+    return n;
+}
+
+// scalar sphere test
+inline bool sphere_visible(const vec4 *planes, float x, float y, float z, float r) {
+    for (int p = 0; p < 6; p++) {
+        if (planes[p].x * x + planes[p].y * y + planes[p].z * z + planes[p].w < -r) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// scalar box test
+inline bool aabb_visible(const vec4 *planes, float cx, float cy, float cz, float ex, float ey, float ez) {
+    for (int p = 0; p < 6; p++) {
+        const float d = planes[p].x * cx + planes[p].y * cy + planes[p].z * cz + planes[p].w;
+        const float r = std::fabs(planes[p].x) * ex + std::fabs(planes[p].y) * ey + std::fabs(planes[p].z) * ez;
+        if (d < -r) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+namespace falcon {
+
+frustum make_frustum(const math::mat4 &m) {
+    // rows of the column-major matrix
+    math::vec4 rows[4];
+    for (int r = 0; r < 4; r++) {
+        rows[r] = { m[0][r], m[1][r], m[2][r], m[3][r] };
+    }
+
+    frustum f;
+    f.planes[0] = rows[3] + rows[0];
+    f.planes[1] = rows[3] - rows[0];
+    f.planes[2] = rows[3] + rows[1];
+    f.planes[3] = rows[3] - rows[1];
+    f.planes[4] = rows[3] + rows[2];
+    f.planes[5] = rows[3] - rows[2];
+    for (auto &p : f.planes) {
+        const float len = std::sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
+        if (len > 0.f) {
+            p *= 1.f / len;
+        }
+    }
+    return f;
+}
+
+int cull_spheres(const frustum &f, const sphere_soa &s, int begin, int end, uint32_t *visible) {
+    int n = 0;
+    int i = begin;
+#if defined(FALCON_MATH_AVX)
+    for (; i + 8 <= end; i += 8) {
+        const __m256 x = _mm256_loadu_ps(s.x + i);
+        const __m256 y = _mm256_loadu_ps(s.y + i);
+        const __m256 z = _mm256_loadu_ps(s.z + i);
+        const __m256 neg_r = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(s.radius + i));
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (const auto &p : f.planes) {
+            __m256 d = _mm256_set1_ps(p.w);
+            d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(p.x), x));
+            d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(p.y), y));
+            d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(p.z), z));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, neg_r, _CMP_GE_OQ));
+        }
+        n = append_mask(visible, n, _mm256_movemask_ps(inside), 8, static_cast<uint32_t>(i));
+    }
+#endif
+#if defined(FALCON_MATH_SSE)
+    for (; i + 4 <= end; i += 4) {
+        const __m128 x = _mm_loadu_ps(s.x + i);
+        const __m128 y = _mm_loadu_ps(s.y + i);
+        const __m128 z = _mm_loadu_ps(s.z + i);
+        const __m128 neg_r = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(s.radius + i));
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (const auto &p : f.planes) {
+            __m128 d = _mm_set1_ps(p.w);
+            d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(p.x), x));
+            d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(p.y), y));
+            d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(p.z), z));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(d, neg_r));
+        }
+        n = append_mask(visible, n, _mm_movemask_ps(inside), 4, static_cast<uint32_t>(i));
+    }
+#endif
+    for (; i < end; i++) {
+        if (sphere_visible(f.planes, s.x[i], s.y[i], s.z[i], s.radius[i])) {
+            visible[n++] = static_cast<uint32_t>(i);
+        }
+    }
+    return n;
+}
+
+int cull_aabbs(const frustum &f, const aabb_soa &b, int begin, int end, uint32_t *visible) {
+    int n = 0;
+    int i = begin;
+#if defined(FALCON_MATH_AVX)
+    const __m256 abs_mask8 = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    for (; i + 8 <= end; i += 8) {
+        const __m256 cx = _mm256_loadu_ps(b.center_x + i);
+        const __m256 cy = _mm256_loadu_ps(b.center_y + i);
+        const __m256 cz = _mm256_loadu_ps(b.center_z + i);
+        const __m256 ex = _mm256_loadu_ps(b.extent_x + i);
+        const __m256 ey = _mm256_loadu_ps(b.extent_y + i);
+        const __m256 ez = _mm256_loadu_ps(b.extent_z + i);
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (const auto &p : f.planes) {
+            const __m256 px = _mm256_set1_ps(p.x), py = _mm256_set1_ps(p.y), pz = _mm256_set1_ps(p.z);
+            __m256 d = _mm256_set1_ps(p.w);
+            d = _mm256_add_ps(d, _mm256_mul_ps(px, cx));
+            d = _mm256_add_ps(d, _mm256_mul_ps(py, cy));
+            d = _mm256_add_ps(d, _mm256_mul_ps(pz, cz));
+            __m256 r = _mm256_mul_ps(_mm256_and_ps(px, abs_mask8), ex);
+            r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_and_ps(py, abs_mask8), ey));
+            r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_and_ps(pz, abs_mask8), ez));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(d, r), _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+        n = append_mask(visible, n, _mm256_movemask_ps(inside), 8, static_cast<uint32_t>(i));
+    }
+#endif
+#if defined(FALCON_MATH_SSE)
+    const __m128 abs_mask4 = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    for (; i + 4 <= end; i += 4) {
+        const __m128 cx = _mm_loadu_ps(b.center_x + i);
+        const __m128 cy = _mm_loadu_ps(b.center_y + i);
+        const __m128 cz = _mm_loadu_ps(b.center_z + i);
+        const __m128 ex = _mm_loadu_ps(b.extent_x + i);
+        const __m128 ey = _mm_loadu_ps(b.extent_y + i);
+        const __m128 ez = _mm_loadu_ps(b.extent_z + i);
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (const auto &p : f.planes) {
+            const __m128 px = _mm_set1_ps(p.x), py = _mm_set1_ps(p.y), pz = _mm_set1_ps(p.z);
+            __m128 d = _mm_set1_ps(p.w);
+            d = _mm_add_ps(d, _mm_mul_ps(px, cx));
+            d = _mm_add_ps(d, _mm_mul_ps(py, cy));
+            d = _mm_add_ps(d, _mm_mul_ps(pz, cz));
+            __m128 r = _mm_mul_ps(_mm_and_ps(px, abs_mask4), ex);
+            r = _mm_add_ps(r, _mm_mul_ps(_mm_and_ps(py, abs_mask4), ey));
+            r = _mm_add_ps(r, _mm_mul_ps(_mm_and_ps(pz, abs_mask4), ez));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, r), _mm_setzero_ps()));
+        }
+        n = append_mask(visible, n, _mm_movemask_ps(inside), 4, static_cast<uint32_t>(i));
+    }
+#endif
+    for (; i < end; i++) {
+        if (aabb_visible(f.planes, b.center_x[i], b.center_y[i], b.center_z[i], b.extent_x[i], b.extent_y[i], b.extent_z[i])) {
+            visible[n++] = static_cast<uint32_t>(i);
+        }
+    }
+    return n;
+}
+
+void frustum_culler::setup(const frustum_culler_desc &desc) {
+    _desc = desc;
+    _desc.chunk_size = std::max(8, _desc.chunk_size);
+}
+
+const std::vector<uint32_t> &frustum_culler::cull(const frustum &f, const sphere_soa &spheres, int count) {
+    run(count, [&f, &spheres](int begin, int end, uint32_t *out) {
+        return cull_spheres(f, spheres, begin, end, out);
+    });
+    return _visible;
+}
+
+const std::vector<uint32_t> &frustum_culler::cull(const frustum &f, const aabb_soa &boxes, int count) {
+    run(count, [&f, &boxes](int begin, int end, uint32_t *out) {
+        return cull_aabbs(f, boxes, begin, end, out);
+    });
+    return _visible;
+}
+
+template <class Test>
+void frustum_culler::run(int count, const Test &test) {
+    const uint64_t start = stm_now();
+    _stats = {};
+    count = std::max(0, count);
+
+    // one output range per chunk
+    const int chunk_size = _desc.chunk_size;
+    const int num_chunks = (count + chunk_size - 1) / chunk_size;
+    _visible.resize(count);
+    _chunk_counts.assign(num_chunks, 0);
+
+    auto fn = [this, &test, chunk_size, count](int first_chunk, int end_chunk) {
+        for (int c = first_chunk; c < end_chunk; c++) {
+            const int begin = c * chunk_size;
+            const int end = std::min(count, begin + chunk_size);
+            _chunk_counts[c] = test(begin, end, _visible.data() + begin);
+        }
+    };
+    if (_desc.jobs) {
+        _desc.jobs->parallel_for(num_chunks, 1, fn);
+    } else {
+        fn(0, num_chunks);
+    }
+
+    // move chunk ranges together
+    int n = 0;
+    for (int c = 0; c < num_chunks; c++) {
+        const int begin = c * chunk_size;
+        if (n != begin && _chunk_counts[c] > 0) {
+            std::memmove(_visible.data() + n, _visible.data() + begin, _chunk_counts[c] * sizeof(uint32_t));
+        }
+        n += _chunk_counts[c];
+    }
+    _visible.resize(n);
+
+    _stats.num_tested = count;
+    _stats.num_visible = n;
+    _stats.num_chunks = num_chunks;
+    _stats.cull_ms = stm_ms(stm_since(start));
+}
+
+} // namespace falcon
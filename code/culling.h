@@ -0,0 +1,114 @@
+#ifndef FALCON_CULLING_H_
+#define FALCON_CULLING_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "job_system.h"
+#include "vecmath.h"
+
+namespace falcon {
+
+// view frustum as six normalized planes (left, right, bottom, top, near, far),
+// a point p is inside a plane when dot(plane.xyz, p) + plane.w >= 0
+struct frustum {
+    math::vec4 planes[6];
+};
+
+// extract the frustum of a GL view-projection matrix (clip z in [-w, w])
+frustum make_frustum(const math::mat4 &view_proj);
+
+// bounding spheres in structure-of-arrays layout
+struct sphere_soa {
+    const float *x = nullptr;
+    const float *y = nullptr;
+    const float *z = nullptr;
+    const float *radius = nullptr;
+};
+
+// axis-aligned boxes as center and half extent in structure-of-arrays layout
+struct aabb_soa {
+    const float *center_x = nullptr;
+    const float *center_y = nullptr;
+    const float *center_z = nullptr;
+    const float *extent_x = nullptr;
+    const float *extent_y = nullptr;
+    const float *extent_z = nullptr;
+};
+
+// test spheres [begin, end) and write indices of visible ones, returns number written
+// (visible must hold end - begin entries)
+int cull_spheres(const frustum &f, const sphere_soa &spheres, int begin, int end, uint32_t *visible);
+
+// test boxes [begin, end) and write indices of visible ones, returns number written
+// (visible must hold end - begin entries)
+int cull_aabbs(const frustum &f, const aabb_soa &boxes, int begin, int end, uint32_t *visible);
+
+// frustum culler description
+struct frustum_culler_desc {
+    // workers for chunks (null: cull on the calling thread)
+    job_system *jobs = nullptr;
+
+    // objects per job
+    int chunk_size = 16 * 1024;
+};
+
+// frustum culler statistics (of the last cull)
+struct frustum_culler_stats {
+    int num_tested;
+    int num_visible;
+    int num_chunks;
+    double cull_ms;
+};
+
+// parallel frustum culling into a compact visible index list
+//
+// objects are tested 8 (AVX) or 4 (SSE) at a time against all planes, see
+// FALCON_MATH_SSE/FALCON_MATH_AVX in vecmath.h. every chunk writes its
+// visible indices into its own range of the output, the ranges are then
+// moved together, so the list is sorted and can drive draw submission
+// (e.g. one instance_batch::draw or gather of world matrices per index).
+class frustum_culler {
+public:
+    // ctor
+    frustum_culler() = default;
+
+    frustum_culler(const frustum_culler &) = delete;
+    frustum_culler &operator=(const frustum_culler &) = delete;
+
+    // set workers and chunk size
+    void setup(const frustum_culler_desc &desc);
+
+    // cull spheres, returns the visible indices
+    const std::vector<uint32_t> &cull(const frustum &f, const sphere_soa &spheres, int count);
+
+    // cull boxes, returns the visible indices
+    const std::vector<uint32_t> &cull(const frustum &f, const aabb_soa &boxes, int count);
+
+    // get visible indices of the last cull
+    inline const std::vector<uint32_t> &visible() const { return _visible; }
+
+    // get statistics
+    inline const frustum_culler_stats &stats() const { return _stats; }
+
+private:
+    // run test(begin, end, out) over chunks and compact
+    template <class Test>
+    void run(int count, const Test &test);
+
+    // description
+    frustum_culler_desc _desc;
+
+    // visible indices
+    std::vector<uint32_t> _visible;
+
+    // visible count per chunk
+    std::vector<int> _chunk_counts;
+
+    // statistics
+    frustum_culler_stats _stats{};
+};
+
+} // namespace falcon
+
+#endif // FALCON_CULLING_H_
@@ -0,0 +1,380 @@
+#include "debug_draw.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "sokol_gfx.h"
+
+namespace {
+
+#if defined(SOKOL_GLES3)
+#define FALCON_DEBUG_DRAW_GLSL_VERSION "#version 300 es\nprecision mediump float;\n"
+#else
+#define FALCON_DEBUG_DRAW_GLSL_VERSION "#version 330\n"
+#endif
+
+// vertex shader
+const char *debug_draw_vs_source =
+    FALCON_DEBUG_DRAW_GLSL_VERSION
+    "uniform mat4 mvp;\n"
+    "layout(location=0) in vec3 position;\n"
+    "layout(location=1) in vec4 color0;\n"
+    "out vec4 color;\n"
+    "void main() {\n"
+    "    gl_Position = mvp * vec4(position, 1.0);\n"
+    "    color = color0;\n"
+    "}\n";
+
+// fragment shader
+const char *debug_draw_fs_source =
+    FALCON_DEBUG_DRAW_GLSL_VERSION
+    "in vec4 color;\n"
+    "out vec4 frag_color;\n"
+    "void main() {\n"
+    "    frag_color = color;\n"
+    "}\n";
+
+// line vertex
+struct vertex {
+    float x, y, z;
+    uint32_t color;
+};
+
+// lines of one thread, [0]: depth tested, [1]: overlay
+struct thread_buffer {
+    std::vector<vertex> lines[2];
+};
+
+// module state
+struct state {
+    bool valid = false;
+    std::atomic<bool> enabled{ true };
+    falcon::debug_draw::desc desc;
+
+    sg_buffer buffer{};
+    sg_shader shader{};
+    sg_pipeline pipelines[2]{};
+    float view_proj[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+    // per-thread buffers, registered once per thread and setup
+    std::mutex mutex;
+    std::vector<std::unique_ptr<thread_buffer>> buffers;
+    std::atomic<uint32_t> generation{ 1 };
+
+    // capacity accounting
+    std::atomic<int> reserved{ 0 };
+    std::atomic<int> dropped{ 0 };
+
+    // lines taken by collect() for the next render
+    std::vector<vertex> collected[2];
+    bool has_collected = false;
+
+    std::vector<vertex> staging;
+    falcon::debug_draw::stats stats{};
+};
+
+state _state;
+
+thread_local thread_buffer *_local_buffer = nullptr;
+thread_local uint32_t _local_generation = 0;
+
+// get buffer of the calling thread
+thread_buffer *local_buffer() {
+    const uint32_t generation = _state.generation.load(std::memory_order_acquire);
+    if (_local_buffer && _local_generation == generation) {
+        return _local_buffer;
+    }
+    std::lock_guard<std::mutex> lock(_state.mutex);
+    _state.buffers.push_back(std::make_unique<thread_buffer>());
+    _local_buffer = _state.buffers.back().get();
+    _local_generation = generation;
+    return _local_buffer;
+}
+
+// reserve vertices against the frame capacity
+bool reserve(int count) {
+    if (!_state.valid || !_state.enabled.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    // a rejected reservation must not take up capacity, so smaller ones
+    // still fit
+    int reserved = _state.reserved.load(std::memory_order_relaxed);
+    do {
+        if (reserved + count > _state.desc.max_vertices) {
+            _state.dropped.fetch_add(count / 2, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!_state.reserved.compare_exchange_weak(reserved, reserved + count, std::memory_order_relaxed));
+    return true;
+}
+
+} // namespace
+
+namespace falcon::debug_draw {
+
+void setup(const desc &d) {
+    shutdown();
+
+    _state.desc = d;
+
+    // stream vertex buffer
+    {
+        sg_buffer_desc buffer_desc{};
+        buffer_desc.type = SG_BUFFERTYPE_VERTEXBUFFER;
+        buffer_desc.usage = SG_USAGE_STREAM;
+        buffer_desc.size = d.max_vertices * static_cast<int>(sizeof(vertex));
+        buffer_desc.label = d.label;
+        _state.buffer = sg_make_buffer(&buffer_desc);
+    }
+
+    // shader
+    {
+        sg_shader_desc shader_desc{};
+        shader_desc.attrs[0].name = "position";
+        shader_desc.attrs[1].name = "color0";
+        shader_desc.vs.source = debug_draw_vs_source;
+        shader_desc.vs.uniform_blocks[0].size = 16 * sizeof(float);
+        shader_desc.vs.uniform_blocks[0].uniforms[0].name = "mvp";
+        shader_desc.vs.uniform_blocks[0].uniforms[0].type = SG_UNIFORMTYPE_MAT4;
+        shader_desc.fs.source = debug_draw_fs_source;
+        shader_desc.label = d.label;
+        _state.shader = sg_make_shader(&shader_desc);
+    }
+
+    // depth tested and overlay pipelines
+    for (int i = 0; i < 2; i++) {
+        sg_pipeline_desc pipeline_desc{};
+        pipeline_desc.shader = _state.shader;
+        pipeline_desc.primitive_type = SG_PRIMITIVETYPE_LINES;
+        pipeline_desc.layout.attrs[0].format = SG_VERTEXFORMAT_FLOAT3;
+        pipeline_desc.layout.attrs[1].format = SG_VERTEXFORMAT_UBYTE4N;
+        pipeline_desc.depth_stencil.depth_compare_func = (i == 0) ? SG_COMPAREFUNC_LESS_EQUAL : SG_COMPAREFUNC_ALWAYS;
+        pipeline_desc.depth_stencil.depth_write_enabled = false;
+        pipeline_desc.blend.enabled = true;
+        pipeline_desc.blend.src_factor_rgb = SG_BLENDFACTOR_SRC_ALPHA;
+        pipeline_desc.blend.dst_factor_rgb = SG_BLENDFACTOR_ONE_MINUS_SRC_ALPHA;
+        pipeline_desc.label = d.label;
+        _state.pipelines[i] = sg_make_pipeline(&pipeline_desc);
+    }
+
+    _state.staging.reserve(d.max_vertices);
+    _state.valid = true;
+}
+
+void shutdown() {
+    if (!_state.valid) {
+        return;
+    }
+    _state.valid = false;
+
+    for (auto &pip : _state.pipelines) {
+        sg_destroy_pipeline(pip);
+        pip = {};
+    }
+    sg_destroy_shader(_state.shader);
+    _state.shader = {};
+    sg_destroy_buffer(_state.buffer);
+    _state.buffer = {};
+
+    // invalidate thread-local buffers
+    std::lock_guard<std::mutex> lock(_state.mutex);
+    _state.buffers.clear();
+    _state.generation.fetch_add(1, std::memory_order_release);
+    _state.reserved = 0;
+    _state.dropped = 0;
+    _state.collected[0].clear();
+    _state.collected[1].clear();
+    _state.has_collected = false;
+    _state.staging.clear();
+    _state.stats = {};
+}
+
+bool valid() {
+    return _state.valid;
+}
+
+void set_enabled(bool enabled) {
+    _state.enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool enabled() {
+    return _state.enabled.load(std::memory_order_relaxed);
+}
+
+void view_proj(const float m[16]) {
+    for (int i = 0; i < 16; i++) {
+        _state.view_proj[i] = m[i];
+    }
+}
+
+void line(const float a[3], const float b[3], uint32_t color, bool depth_test) {
+    if (!reserve(2)) {
+        return;
+    }
+    auto &lines = local_buffer()->lines[depth_test ? 0 : 1];
+    lines.push_back({ a[0], a[1], a[2], color });
+    lines.push_back({ b[0], b[1], b[2], color });
+}
+
+void box(const float min[3], const float max[3], uint32_t color, bool depth_test) {
+    if (!reserve(24)) {
+        return;
+    }
+    const float c[8][3] = {
+        { min[0], min[1], min[2] }, { max[0], min[1], min[2] },
+        { max[0], max[1], min[2] }, { min[0], max[1], min[2] },
+        { min[0], min[1], max[2] }, { max[0], min[1], max[2] },
+        { max[0], max[1], max[2] }, { min[0], max[1], max[2] },
+    };
+    static const int edges[12][2] = {
+        { 0, 1 }, { 1, 2 }, { 2, 3 }, { 3, 0 },
+        { 4, 5 }, { 5, 6 }, { 6, 7 }, { 7, 4 },
+        { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 },
+    };
+    auto &lines = local_buffer()->lines[depth_test ? 0 : 1];
+    for (const auto &e : edges) {
+        lines.push_back({ c[e[0]][0], c[e[0]][1], c[e[0]][2], color });
+        lines.push_back({ c[e[1]][0], c[e[1]][1], c[e[1]][2], color });
+    }
+}
+
+void sphere(const float center[3], float radius, uint32_t color, bool depth_test, int segments) {
+    if (segments < 3 || !reserve(segments * 6)) {
+        return;
+    }
+    auto &lines = local_buffer()->lines[depth_test ? 0 : 1];
+    const float step = 6.28318530718f / segments;
+    for (int axis = 0; axis < 3; axis++) {
+        const int u = (axis + 1) % 3, v = (axis + 2) % 3;
+        float p0[3] = { center[0], center[1], center[2] };
+        p0[u] += radius;
+        for (int i = 1; i <= segments; i++) {
+            float p1[3] = { center[0], center[1], center[2] };
+            p1[u] += std::cos(i * step) * radius;
+            p1[v] += std::sin(i * step) * radius;
+            lines.push_back({ p0[0], p0[1], p0[2], color });
+            lines.push_back({ p1[0], p1[1], p1[2], color });
+            p0[0] = p1[0]; p0[1] = p1[1]; p0[2] = p1[2];
+        }
+    }
+}
+
+void axes(const float m[16], float size, bool depth_test) {
+    const float origin[3] = { m[12], m[13], m[14] };
+    static const uint32_t colors[3] = { 0xFF0000FF, 0xFF00FF00, 0xFFFF0000 };
+    for (int i = 0; i < 3; i++) {
+        const float end[3] = {
+            origin[0] + m[i * 4 + 0] * size,
+            origin[1] + m[i * 4 + 1] * size,
+            origin[2] + m[i * 4 + 2] * size,
+        };
+        line(origin, end, colors[i], depth_test);
+    }
+}
+
+void collect() {
+    if (!_state.valid) {
+        return;
+    }
+
+    // lines of the next update count against a new frame
+    _state.reserved.store(0, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(_state.mutex);
+    for (int i = 0; i < 2; i++) {
+        for (auto &buffer : _state.buffers) {
+            auto &lines = buffer->lines[i];
+            _state.collected[i].insert(_state.collected[i].end(), lines.begin(), lines.end());
+            lines.clear();
+        }
+    }
+    _state.has_collected = true;
+}
+
+void render(int width, int height) {
+    if (!_state.valid) {
+        return;
+    }
+
+    _state.stats = {};
+    _state.stats.num_dropped = _state.dropped.exchange(0, std::memory_order_relaxed);
+
+    // lines of the calling thread are drawn this frame either way
+    thread_buffer *own = nullptr;
+    if (_local_buffer && _local_generation == _state.generation.load(std::memory_order_acquire)) {
+        own = _local_buffer;
+    }
+
+    // merge collected lines or all thread buffers, depth tested lines first,
+    // up to the stream buffer capacity
+    int counts[2] = {};
+    _state.staging.clear();
+    auto append = [&counts](std::vector<vertex> &lines, int i) {
+        const size_t room = static_cast<size_t>(_state.desc.max_vertices) - _state.staging.size();
+        const size_t count = std::min(lines.size(), room);
+        _state.staging.insert(_state.staging.end(), lines.begin(), lines.begin() + count);
+        _state.stats.num_dropped += static_cast<int>((lines.size() - count) / 2);
+        counts[i] += static_cast<int>(count);
+        lines.clear();
+    };
+    {
+        std::lock_guard<std::mutex> lock(_state.mutex);
+        _state.stats.num_threads = static_cast<int>(_state.buffers.size());
+        for (int i = 0; i < 2; i++) {
+            if (_state.has_collected) {
+                append(_state.collected[i], i);
+                if (own) {
+                    append(own->lines[i], i);
+                }
+                continue;
+            }
+            for (auto &buffer : _state.buffers) {
+                append(buffer->lines[i], i);
+            }
+        }
+    }
+    if (!_state.has_collected) {
+        _state.reserved.store(0, std::memory_order_relaxed);
+    }
+    _state.has_collected = false;
+    _state.stats.num_lines = static_cast<int>(_state.staging.size() / 2);
+    if (_state.staging.empty()) {
+        return;
+    }
+
+    const int offset = sg_append_buffer(_state.buffer, _state.staging.data(), static_cast<int>(_state.staging.size() * sizeof(vertex)));
+
+    // draw over what the frame rendered
+    sg_pass_action pass_action{};
+    pass_action.colors[0].action = SG_ACTION_LOAD;
+    pass_action.depth.action = SG_ACTION_LOAD;
+    pass_action.stencil.action = SG_ACTION_LOAD;
+    sg_begin_default_pass(&pass_action, width, height);
+
+    sg_bindings bindings{};
+    bindings.vertex_buffers[0] = _state.buffer;
+    bindings.vertex_buffer_offsets[0] = offset;
+
+    int first = 0;
+    for (int i = 0; i < 2; i++) {
+        if (counts[i] > 0) {
+            sg_apply_pipeline(_state.pipelines[i]);
+            sg_apply_bindings(&bindings);
+            sg_apply_uniforms(SG_SHADERSTAGE_VS, 0, _state.view_proj, sizeof(_state.view_proj));
+            sg_draw(first, counts[i], 1);
+            _state.stats.num_draws++;
+        }
+        first += counts[i];
+    }
+    sg_end_pass();
+}
+
+const stats &get_stats() {
+    return _state.stats;
+}
+
+} // namespace falcon::debug_draw
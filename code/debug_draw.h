@@ -0,0 +1,74 @@
+#ifndef FALCON_DEBUG_DRAW_H_
+#define FALCON_DEBUG_DRAW_H_
+
+#include <cstdint>
+
+namespace falcon::debug_draw {
+
+// debug draw description
+struct desc {
+    // line vertex capacity per frame (two per line)
+    int max_vertices = 256 * 1024;
+
+    // debug label
+    const char *label = nullptr;
+};
+
+// debug draw statistics (of the last render)
+struct stats {
+    int num_lines;
+    int num_dropped;
+    int num_draws;
+    int num_threads;
+};
+
+// create buffers and pipelines
+void setup(const desc &d);
+
+// destroy all resources
+void shutdown();
+
+// check setup
+bool valid();
+
+// enable or disable drawing, lines added while disabled are ignored (default enabled)
+void set_enabled(bool enabled);
+
+// check enabled
+bool enabled();
+
+// set view-projection matrix (column-major) for the next render
+void view_proj(const float m[16]);
+
+// add a line, lock-free from any thread
+void line(const float a[3], const float b[3], uint32_t color, bool depth_test = true);
+
+// add an axis-aligned box
+void box(const float min[3], const float max[3], uint32_t color, bool depth_test = true);
+
+// add a wireframe sphere (three great circles)
+void sphere(const float center[3], float radius, uint32_t color, bool depth_test = true, int segments = 24);
+
+// add axes of a transform (column-major)
+void axes(const float m[16], float size, bool depth_test = true);
+
+// take the lines added so far for the next render, while no other thread
+// adds lines (called by application in pipelined mode once the update of
+// the rendered frame is finished and before the next one starts)
+void collect();
+
+// draw all lines in a new pass over the default framebuffer and reset, no
+// pass is started without lines (called by application at the end of
+// frame_cb when set up and enabled)
+//
+// after collect() only the collected lines and those of the calling thread
+// are drawn, other threads may keep adding lines for the next collect().
+// otherwise all lines are drawn and no thread may add lines meanwhile.
+void render(int width, int height);
+
+// get statistics
+const stats &get_stats();
+
+} // namespace falcon::debug_draw
+
+#endif // FALCON_DEBUG_DRAW_H_
@@ -1,7 +1,30 @@
 #ifndef FALCON_H_
 #define FALCON_H_
 
+#include "allocator.h"
 #include "application.h"
+#include "bench_report.h"
+#include "creation_queue.h"
+#include "culling.h"
+#include "debug_draw.h"
+#include "frame_arena.h"
+#include "frame_pacer.h"
 #include "gfx.h"
+#include "gltf_loader.h"
+#include "input.h"
+#include "input_recorder.h"
+#include "instance_batch.h"
+#include "job_system.h"
+#include "mesh_arena.h"
+#include "mesh_lod.h"
+#include "mesh_optimizer.h"
+#include "occlusion_culler.h"
+#include "spatial_index.h"
+#include "sprite_batch.h"
+#include "text_renderer.h"
+#include "texture_atlas.h"
+#include "transform_system.h"
+#include "vecmath.h"
+#include "vertex_packing.h"
 
 #endif // FALCON_H_
@@ -0,0 +1,108 @@
+#include "frame_arena.h"
+
+#include <algorithm>
+#include <new>
+
+namespace falcon {
+
+namespace {
+
+// alignment of the buffers, larger requests go to the heap
+constexpr size_t buffer_alignment = 64;
+
+} // namespace
+
+void *frame_arena_resource::do_allocate(size_t bytes, size_t alignment) {
+    // memory_resource has no way to report failure but throwing
+    void *p = _arena->alloc(bytes, alignment);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void frame_arena::setup(const frame_arena_desc &desc) {
+    shutdown();
+
+    _desc = desc;
+    _desc.num_buffers = std::clamp(_desc.num_buffers, 1, 2);
+    for (int i = 0; i < _desc.num_buffers; i++) {
+        _buffers[i].data = static_cast<uint8_t *>(::operator new(_desc.capacity, std::align_val_t(buffer_alignment)));
+        _buffers[i].used.store(0, std::memory_order_relaxed);
+    }
+    _current = 0;
+    _stats = {};
+    _valid = true;
+}
+
+void frame_arena::shutdown() {
+    if (!_valid) {
+        return;
+    }
+
+    for (int i = 0; i < _desc.num_buffers; i++) {
+        release_overflows(_buffers[i]);
+        ::operator delete(_buffers[i].data, std::align_val_t(buffer_alignment));
+        _buffers[i].data = nullptr;
+    }
+    _valid = false;
+}
+
+void *frame_arena::alloc(size_t size, size_t alignment) {
+    if (!_valid) {
+        return nullptr;
+    }
+    buffer &b = _buffers[_current];
+    if (alignment > buffer_alignment) {
+        return alloc_overflow(b, size, alignment);
+    }
+
+    size_t offset = b.used.load(std::memory_order_relaxed);
+    for (;;) {
+        const size_t begin = (offset + alignment - 1) & ~(alignment - 1);
+        const size_t end = begin + size;
+        if (end > _desc.capacity) {
+            return alloc_overflow(b, size, alignment);
+        }
+        if (b.used.compare_exchange_weak(offset, end, std::memory_order_relaxed)) {
+            return b.data + begin;
+        }
+    }
+}
+
+void frame_arena::reset() {
+    if (!_valid) {
+        return;
+    }
+
+    // account the finished frame
+    buffer &done = _buffers[_current];
+    _stats.used = done.used.load(std::memory_order_relaxed) + done.overflow_bytes;
+    _stats.high_water = std::max(_stats.high_water, _stats.used);
+    _stats.overflow_bytes = done.overflow_bytes;
+    _stats.num_overflows += (done.overflow_bytes > 0) ? 1 : 0;
+
+    // reuse the oldest buffer
+    _current = (_current + 1) % _desc.num_buffers;
+    buffer &next = _buffers[_current];
+    release_overflows(next);
+    next.used.store(0, std::memory_order_relaxed);
+}
+
+void *frame_arena::alloc_overflow(buffer &b, size_t size, size_t alignment) {
+    void *p = ::operator new(std::max<size_t>(size, 1), std::align_val_t(alignment));
+    std::lock_guard<std::mutex> lock(_overflow_mutex);
+    b.overflows.push_back({ p, alignment });
+    b.overflow_bytes += size;
+    return p;
+}
+
+void frame_arena::release_overflows(buffer &b) {
+    for (const overflow &o : b.overflows) {
+        ::operator delete(o.data, std::align_val_t(o.alignment));
+    }
+    b.overflows.clear();
+    b.overflow_bytes = 0;
+}
+
+} // namespace falcon
@@ -0,0 +1,131 @@
+#ifndef FALCON_FRAME_ARENA_H_
+#define FALCON_FRAME_ARENA_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+namespace falcon {
+
+class frame_arena;
+
+// std::pmr adaptor, deallocation is a no-op
+class frame_arena_resource final : public std::pmr::memory_resource {
+public:
+    explicit frame_arena_resource(frame_arena *arena) : _arena(arena) {}
+
+private:
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override {}
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+    frame_arena *_arena;
+};
+
+// frame arena description
+struct frame_arena_desc {
+    // bytes per buffer
+    size_t capacity = 1024 * 1024;
+
+    // 1: memory lives until the next reset, 2: until the one after it
+    int num_buffers = 1;
+};
+
+// frame arena statistics
+struct frame_arena_stats {
+    // bytes allocated in the last finished frame, and at most
+    size_t used;
+    size_t high_water;
+
+    // bytes of the last finished frame that did not fit and came from the heap
+    size_t overflow_bytes;
+
+    // frames that overflowed
+    int num_overflows;
+};
+
+// linear allocator reset once per frame
+//
+// allocation bumps an atomic offset, so any thread can allocate while the
+// frame runs, and nothing is freed individually. requests that do not fit
+// are served from the heap and released on the next reset, so an undersized
+// arena only costs speed; size it from high_water. with two buffers reset()
+// alternates between them, so an allocation survives one more frame.
+// destructors are never run.
+class frame_arena {
+public:
+    // ctor
+    frame_arena() = default;
+
+    // dtor
+    ~frame_arena() { shutdown(); }
+
+    frame_arena(const frame_arena &) = delete;
+    frame_arena &operator=(const frame_arena &) = delete;
+
+    // allocate the buffers
+    void setup(const frame_arena_desc &desc);
+
+    // release the buffers
+    void shutdown();
+
+    // allocate uninitialized memory (any thread, nullptr before setup)
+    void *alloc(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    // allocate an uninitialized array (any thread)
+    template <class T>
+    inline T *alloc_array(size_t count) { return static_cast<T *>(alloc(sizeof(T) * count, alignof(T))); }
+
+    // end the frame: release the memory of the frame before it (no other
+    // thread may allocate meanwhile)
+    void reset();
+
+    // get std::pmr memory resource
+    inline std::pmr::memory_resource *resource() { return &_resource; }
+
+    // get statistics
+    inline const frame_arena_stats &stats() const { return _stats; }
+
+private:
+    // heap block of an overflowing allocation
+    struct overflow {
+        void *data;
+        size_t alignment;
+    };
+
+    // one buffer
+    struct buffer {
+        uint8_t *data = nullptr;
+        std::atomic<size_t> used{ 0 };
+        std::vector<overflow> overflows;
+        size_t overflow_bytes = 0;
+    };
+
+    // allocate from the heap
+    void *alloc_overflow(buffer &b, size_t size, size_t alignment);
+
+    // free heap blocks of a buffer
+    void release_overflows(buffer &b);
+
+    // description
+    frame_arena_desc _desc;
+    bool _valid = false;
+
+    // buffers
+    buffer _buffers[2];
+    int _current = 0;
+    std::mutex _overflow_mutex;
+
+    // pmr adaptor
+    frame_arena_resource _resource{ this };
+
+    // statistics
+    frame_arena_stats _stats{};
+};
+
+} // namespace falcon
+
+#endif // FALCON_FRAME_ARENA_H_
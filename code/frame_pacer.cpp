@@ -0,0 +1,133 @@
+#include "frame_pacer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "sokol_time.h"
+
+namespace falcon {
+
+namespace {
+
+// overshoot estimate decay per sleep
+constexpr double oversleep_decay = 0.99;
+
+// sokol_time ticks from milliseconds, ticks are not nanoseconds everywhere
+uint64_t ticks(double ms) {
+    const double ns_per_tick = stm_ns(1000000) / 1000000.0;
+    return static_cast<uint64_t>(ms * 1000000.0 / ns_per_tick);
+}
+
+} // namespace
+
+void frame_pacer::setup(const frame_pacer_desc &desc) {
+    shutdown();
+
+    _desc = desc;
+    _desc.window = std::max(_desc.window, 1);
+    _samples.assign(_desc.window, {});
+    _next_sample = 0;
+    _num_samples = 0;
+    _oversleep_ms = 0.0;
+    _stats = {};
+    _last_wake = stm_now();
+    _deadline = _last_wake + ticks(_desc.target_ms);
+    _valid = true;
+}
+
+void frame_pacer::shutdown() {
+    if (!_valid) {
+        return;
+    }
+
+    _samples.clear();
+    _valid = false;
+}
+
+void frame_pacer::set_target(double ms) {
+    _desc.target_ms = std::max(ms, 0.0);
+    _deadline = _last_wake + ticks(_desc.target_ms);
+}
+
+void frame_pacer::wait() {
+    if (!_valid) {
+        return;
+    }
+
+    double sleep_ms = 0.0;
+    double spin_ms = 0.0;
+    bool missed = false;
+    if (_desc.target_ms > 0.0) {
+        uint64_t now = stm_now();
+        if (now >= _deadline) {
+            missed = true;
+        }
+        else {
+            // sleep until the spin margin, measure the overshoot
+            const double remaining = stm_ms(stm_diff(_deadline, now));
+            const double request = remaining - _desc.spin_ms - _oversleep_ms;
+            if (request > 0.0) {
+                std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(request));
+                const uint64_t woke = stm_now();
+                sleep_ms = stm_ms(stm_diff(woke, now));
+                _oversleep_ms = std::max(sleep_ms - request, _oversleep_ms * oversleep_decay);
+                now = woke;
+            }
+
+            // spin the rest
+            const uint64_t spin_start = now;
+            while (now < _deadline) {
+                std::this_thread::yield();
+                now = stm_now();
+            }
+            spin_ms = stm_ms(stm_diff(now, spin_start));
+        }
+    }
+
+    // a missed deadline restarts the schedule from now
+    const uint64_t wake = stm_now();
+    const uint64_t step = ticks(_desc.target_ms);
+    _deadline = missed ? wake + step : _deadline + step;
+
+    sample &s = _samples[_next_sample];
+    s.interval_ms = stm_ms(stm_diff(wake, _last_wake));
+    s.sleep_ms = sleep_ms;
+    s.spin_ms = spin_ms;
+    s.missed = missed;
+    _last_wake = wake;
+    _next_sample = (_next_sample + 1) % _desc.window;
+    _num_samples = std::min(_num_samples + 1, _desc.window);
+    update_stats();
+}
+
+void frame_pacer::update_stats() {
+    double interval = 0.0, sleep = 0.0, spin = 0.0;
+    int missed = 0;
+    for (int i = 0; i < _num_samples; i++) {
+        interval += _samples[i].interval_ms;
+        sleep += _samples[i].sleep_ms;
+        spin += _samples[i].spin_ms;
+        missed += _samples[i].missed ? 1 : 0;
+    }
+    const double n = static_cast<double>(_num_samples);
+    _stats.frame_ms = interval / n;
+    _stats.sleep_ms = sleep / n;
+    _stats.spin_ms = spin / n;
+
+    // deviation from the target, or from the average without a limit
+    const double expected = (_desc.target_ms > 0.0) ? _desc.target_ms : _stats.frame_ms;
+    double variance = 0.0, max_error = 0.0;
+    for (int i = 0; i < _num_samples; i++) {
+        const double d = _samples[i].interval_ms - _stats.frame_ms;
+        variance += d * d;
+        max_error = std::max(max_error, std::fabs(_samples[i].interval_ms - expected));
+    }
+    _stats.jitter_ms = std::sqrt(variance / n);
+    _stats.max_error_ms = max_error;
+    _stats.oversleep_ms = _oversleep_ms;
+    _stats.num_missed = missed;
+}
+
+} // namespace falcon
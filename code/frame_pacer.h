@@ -0,0 +1,126 @@
+#ifndef FALCON_FRAME_PACER_H_
+#define FALCON_FRAME_PACER_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace falcon {
+
+// frame pacer description
+struct frame_pacer_desc {
+    // target frame time (0: no limit, intervals are still measured)
+    double target_ms = 0.0;
+
+    // time before the deadline that is always spun instead of slept, the
+    // measured sleep overshoot is added on top
+    double spin_ms = 0.5;
+
+    // wait at the end of the frame instead of the start, see application
+    bool late_input = false;
+
+    // number of frames the statistics are taken over
+    int window = 120;
+};
+
+// frame pacer statistics (over the window)
+struct frame_pacer_stats {
+    // achieved frame interval
+    double frame_ms;
+
+    // standard deviation of the interval and worst miss of the target
+    double jitter_ms;
+    double max_error_ms;
+
+    // time per frame spent sleeping and spinning
+    double sleep_ms;
+    double spin_ms;
+
+    // current estimate of how much longer than requested a sleep takes
+    double oversleep_ms;
+
+    // frames that started after their deadline
+    int num_missed;
+};
+
+// frame limiter with a hybrid sleep and spin wait
+//
+// wait() blocks until the next deadline, target_ms after the previous one.
+// most of the time is slept, the rest is spun on sokol_time, so the wake-up
+// is precise without burning a core. the spin margin follows the observed
+// sleep overshoot: it jumps up to every new overshoot and decays slowly, which
+// adapts to coarse os timers. a frame that misses its deadline restarts the
+// schedule instead of rushing the following frames. stm_setup() has to be
+// called before setup().
+class frame_pacer {
+public:
+    // ctor
+    frame_pacer() = default;
+
+    // dtor
+    ~frame_pacer() { shutdown(); }
+
+    frame_pacer(const frame_pacer &) = delete;
+    frame_pacer &operator=(const frame_pacer &) = delete;
+
+    // setup
+    void setup(const frame_pacer_desc &desc);
+
+    // shutdown
+    void shutdown();
+
+    // wait for the next deadline and record the interval
+    void wait();
+
+    // change the target frame time (0: no limit)
+    void set_target(double ms);
+
+    // get target frame time
+    inline double target() const { return _desc.target_ms; }
+
+    // get description
+    inline const frame_pacer_desc &desc() const { return _desc; }
+
+    // change where application waits
+    inline void set_late_input(bool enabled) { _desc.late_input = enabled; }
+
+    // check where application waits
+    inline bool late_input() const { return _desc.late_input; }
+
+    // get statistics
+    inline const frame_pacer_stats &stats() const { return _stats; }
+
+private:
+    // one recorded frame
+    struct sample {
+        double interval_ms;
+        double sleep_ms;
+        double spin_ms;
+        bool missed;
+    };
+
+    // recompute statistics
+    void update_stats();
+
+    // description
+    frame_pacer_desc _desc;
+    bool _valid = false;
+
+    // schedule
+    uint64_t _deadline = 0;
+    uint64_t _last_wake = 0;
+
+    // sleep overshoot estimate
+    double _oversleep_ms = 0.0;
+
+    // rolling window
+    std::vector<sample> _samples;
+    int _next_sample = 0;
+    int _num_samples = 0;
+
+    // statistics
+    frame_pacer_stats _stats{};
+};
+
+} // namespace falcon
+
+#endif // FALCON_FRAME_PACER_H_
@@ -1,6 +1,7 @@
 #ifndef FALCON_GFX_H_
 #define FALCON_GFX_H_
 
+#include <cstdint>
 #include <functional>
 
 #include "sokol_gfx.h"
@@ -77,6 +78,13 @@ inline auto make_pass(std::function<void(sg_pass_desc&)> fn) {
     return make_pass(desc);
 }
 
+// index of the frame being built, advanced only by the application frame
+// loop after sg_commit() (defined in application.cpp)
+//
+// modules appending to stream buffers compare it to enforce their capacity
+// per frame instead of per flush.
+uint64_t frame_index();
+
 template <class T>
 inline T make(std::function<void(T&)> fn) {
     T instance{};
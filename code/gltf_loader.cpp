@@ -0,0 +1,887 @@
+#include "gltf_loader.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+// handle layout
+constexpr uint32_t slot_bits = 16;
+constexpr uint32_t slot_mask = (1u << slot_bits) - 1;
+
+inline uint32_t make_id(uint32_t index, uint16_t generation) {
+    return (static_cast<uint32_t>(generation) << slot_bits) | ((index + 1) & slot_mask);
+}
+
+// glb constants
+constexpr uint32_t glb_magic = 0x46546C67;
+constexpr uint32_t glb_json = 0x4E4F534A;
+constexpr uint32_t glb_bin = 0x004E4942;
+constexpr uint32_t glb_header_size = 12 + 8;
+
+// accessor component types
+constexpr int component_byte = 5120;
+constexpr int component_ubyte = 5121;
+constexpr int component_short = 5122;
+constexpr int component_ushort = 5123;
+constexpr int component_uint = 5125;
+constexpr int component_float = 5126;
+
+// data passed through sokol_fetch
+struct fetch_user_data {
+    falcon::gfx::gltf_loader *loader;
+    uint32_t id;
+};
+
+inline uint32_t read_u32(const uint8_t *p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline int component_size(int type) {
+    switch (type) {
+    case component_byte:
+    case component_ubyte: return 1;
+    case component_short:
+    case component_ushort: return 2;
+    case component_uint:
+    case component_float: return 4;
+    }
+    return 0;
+}
+
+inline float read_float(const uint8_t *p, int type, bool normalized) {
+    switch (type) {
+    case component_byte: {
+        const auto v = static_cast<int8_t>(*p);
+        return normalized ? std::max(v / 127.f, -1.f) : v;
+    }
+    case component_ubyte:
+        return normalized ? *p / 255.f : *p;
+    case component_short: {
+        int16_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return normalized ? std::max(v / 32767.f, -1.f) : v;
+    }
+    case component_ushort: {
+        uint16_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return normalized ? v / 65535.f : v;
+    }
+    case component_uint:
+        return static_cast<float>(read_u32(p));
+    default: {
+        float v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    }
+}
+
+inline uint32_t read_index(const uint8_t *p, int type) {
+    switch (type) {
+    case component_ubyte: return *p;
+    case component_ushort: {
+        uint16_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    default: return read_u32(p);
+    }
+}
+
+// minimal json document, enough for the glTF header
+struct json {
+    enum kind_t : uint8_t { null_kind, bool_kind, number_kind, string_kind, array_kind, object_kind };
+
+    kind_t kind = null_kind;
+    double number = 0.0;
+    std::string string;
+
+    // array items, or object values with their keys
+    std::vector<json> items;
+    std::vector<std::string> keys;
+
+    const json &operator[](const char *key) const {
+        static const json none;
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (keys[i] == key) {
+                return items[i];
+            }
+        }
+        return none;
+    }
+
+    const json &operator[](size_t index) const {
+        static const json none;
+        return (kind == array_kind && index < items.size()) ? items[index] : none;
+    }
+
+    inline bool valid() const { return kind != null_kind; }
+    inline size_t size() const { return kind == array_kind ? items.size() : 0; }
+    inline double number_or(double def) const { return kind == number_kind ? number : def; }
+    inline bool bool_or(bool def) const { return kind == bool_kind ? number != 0.0 : def; }
+};
+
+// recursive descent json parser
+class json_parser {
+public:
+    json_parser(const char *text, size_t length) : _p(text), _end(text + length) {}
+
+    bool parse(json &out) {
+        if (!value(out, 0)) {
+            return false;
+        }
+        skip();
+        return _p == _end || *_p == '\0';
+    }
+
+private:
+    void skip() {
+        while (_p < _end && (*_p == ' ' || *_p == '\t' || *_p == '\n' || *_p == '\r')) {
+            _p++;
+        }
+    }
+
+    bool literal(const char *word) {
+        const size_t n = std::strlen(word);
+        if (static_cast<size_t>(_end - _p) < n || std::strncmp(_p, word, n) != 0) {
+            return false;
+        }
+        _p += n;
+        return true;
+    }
+
+    bool string(std::string &out) {
+        if (_p >= _end || *_p != '"') {
+            return false;
+        }
+        _p++;
+        while (_p < _end && *_p != '"') {
+            char c = *_p++;
+            if (c == '\\') {
+                if (_p >= _end) {
+                    return false;
+                }
+                c = *_p++;
+                switch (c) {
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'n': c = '\n'; break;
+                case 'r': c = '\r'; break;
+                case 't': c = '\t'; break;
+                case 'u': {
+                    if (_end - _p < 4) {
+                        return false;
+                    }
+                    const char hex[5] = { _p[0], _p[1], _p[2], _p[3], 0 };
+                    const auto code = static_cast<uint32_t>(std::strtoul(hex, nullptr, 16));
+                    _p += 4;
+                    if (code < 0x80) {
+                        out += static_cast<char>(code);
+                    } else if (code < 0x800) {
+                        out += static_cast<char>(0xC0 | (code >> 6));
+                        out += static_cast<char>(0x80 | (code & 0x3F));
+                    } else {
+                        out += static_cast<char>(0xE0 | (code >> 12));
+                        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                        out += static_cast<char>(0x80 | (code & 0x3F));
+                    }
+                    continue;
+                }
+                default: break;
+                }
+            }
+            out += c;
+        }
+        if (_p >= _end) {
+            return false;
+        }
+        _p++;
+        return true;
+    }
+
+    bool value(json &out, int depth) {
+        skip();
+        if (_p >= _end || depth > 64) {
+            return false;
+        }
+        switch (*_p) {
+        case '{': {
+            _p++;
+            out.kind = json::object_kind;
+            skip();
+            if (_p < _end && *_p == '}') {
+                _p++;
+                return true;
+            }
+            for (;;) {
+                skip();
+                out.keys.emplace_back();
+                if (!string(out.keys.back())) {
+                    return false;
+                }
+                skip();
+                if (_p >= _end || *_p++ != ':') {
+                    return false;
+                }
+                out.items.emplace_back();
+                if (!value(out.items.back(), depth + 1)) {
+                    return false;
+                }
+                skip();
+                if (_p < _end && *_p == ',') {
+                    _p++;
+                    continue;
+                }
+                return _p < _end && *_p++ == '}';
+            }
+        }
+        case '[': {
+            _p++;
+            out.kind = json::array_kind;
+            skip();
+            if (_p < _end && *_p == ']') {
+                _p++;
+                return true;
+            }
+            for (;;) {
+                out.items.emplace_back();
+                if (!value(out.items.back(), depth + 1)) {
+                    return false;
+                }
+                skip();
+                if (_p < _end && *_p == ',') {
+                    _p++;
+                    continue;
+                }
+                return _p < _end && *_p++ == ']';
+            }
+        }
+        case '"':
+            out.kind = json::string_kind;
+            return string(out.string);
+        case 't':
+            out.kind = json::bool_kind;
+            out.number = 1.0;
+            return literal("true");
+        case 'f':
+            out.kind = json::bool_kind;
+            return literal("false");
+        case 'n':
+            return literal("null");
+        default: {
+            // strtod stops at the first character after the number
+            char buffer[64];
+            size_t n = 0;
+            while (_p + n < _end && n < sizeof(buffer) - 1 && std::strchr("+-.eE0123456789", _p[n])) {
+                buffer[n] = _p[n];
+                n++;
+            }
+            buffer[n] = '\0';
+            char *stop = nullptr;
+            out.number = std::strtod(buffer, &stop);
+            if (n == 0 || stop != buffer + n) {
+                return false;
+            }
+            out.kind = json::number_kind;
+            _p += n;
+            return true;
+        }
+        }
+    }
+
+    const char *_p;
+    const char *_end;
+};
+
+// array item by a json index value
+inline const json &item(const json &array, const json &index) {
+    return array[index.number_or(-1.0) >= 0.0 ? static_cast<size_t>(index.number) : ~size_t(0)];
+}
+
+inline int type_components(const std::string &type) {
+    if (type == "SCALAR") return 1;
+    if (type == "VEC2") return 2;
+    if (type == "VEC3") return 3;
+    if (type == "VEC4") return 4;
+    return 0;
+}
+
+// smallest component count of a semantic, and its default value
+inline int semantic_components(falcon::gfx::vertex_semantic semantic) {
+    switch (semantic) {
+    case falcon::gfx::vertex_semantic::texcoord: return 2;
+    default: return 3;
+    }
+}
+
+inline float semantic_default(falcon::gfx::vertex_semantic semantic, int component) {
+    switch (semantic) {
+    case falcon::gfx::vertex_semantic::normal: return component == 2 ? 1.f : 0.f;
+    case falcon::gfx::vertex_semantic::color: return 1.f;
+    default: return 0.f;
+    }
+}
+
+} // namespace
+
+namespace falcon::gfx {
+
+void gltf_loader::setup(const gltf_loader_desc &desc) {
+    shutdown();
+
+    _desc = desc;
+    _desc.chunk_size = std::max(_desc.chunk_size, 1024);
+    _desc.num_chunks = std::max(_desc.num_chunks, 1);
+    for (int i = 0; i < _desc.num_chunks; i++) {
+        _chunks.push_back(std::make_unique<chunk>());
+        _chunks.back()->data.reserve(_desc.chunk_size + 256);
+    }
+    _next_chunk = 0;
+    _stats = {};
+    _valid = true;
+}
+
+void gltf_loader::shutdown() {
+    if (!_valid) {
+        return;
+    }
+
+    // cancel fetches and let sokol_fetch deliver the final callbacks
+    bool fetching = false;
+    for (auto &r : _requests) {
+        if (r->fetching && sfetch_valid()) {
+            sfetch_cancel(r->fetch);
+            fetching = true;
+        }
+    }
+    while (fetching && sfetch_valid()) {
+        sfetch_dowork();
+        fetching = std::any_of(_requests.begin(), _requests.end(), [](const auto &r) { return r->fetching; });
+        if (fetching) {
+            std::this_thread::yield();
+        }
+    }
+
+    // workers still reference requests and chunks
+    for (auto &r : _requests) {
+        while (!r->chunks.done() || !r->packing.done()) {
+            std::this_thread::yield();
+        }
+    }
+    for (auto &c : _chunks) {
+        while (!c->counter.done()) {
+            std::this_thread::yield();
+        }
+    }
+
+    _requests.clear();
+    _free_requests.clear();
+    _chunks.clear();
+    _valid = false;
+}
+
+gltf_handle gltf_loader::load(const char *path) {
+    if (!_valid || !path) {
+        return {};
+    }
+
+    // get a slot
+    uint32_t index = 0;
+    if (!_free_requests.empty()) {
+        index = _free_requests.back();
+        _free_requests.pop_back();
+    }
+    else if (_requests.size() < slot_mask) {
+        index = static_cast<uint32_t>(_requests.size());
+        _requests.push_back(std::make_unique<request>());
+    }
+    else {
+        return {};
+    }
+
+    request &r = *_requests[index];
+    r.generation = static_cast<uint16_t>(r.generation + 1);
+    if (r.generation == 0) r.generation = 1;
+    r.state = gltf_state::loading;
+    r.buffer.resize(_desc.chunk_size);
+    const gltf_handle h = { make_id(index, r.generation) };
+
+    // fetch in chunks into the request buffer
+    const fetch_user_data user_data = { this, h.id };
+    sfetch_request_t req{};
+    req.channel = static_cast<uint32_t>(_desc.channel);
+    req.path = path;
+    req.callback = fetch_callback;
+    req.buffer_ptr = r.buffer.data();
+    req.buffer_size = static_cast<uint32_t>(r.buffer.size());
+    req.chunk_size = static_cast<uint32_t>(r.buffer.size());
+    req.user_data_ptr = &user_data;
+    req.user_data_size = sizeof(user_data);
+    r.fetch = sfetch_send(req);
+    r.fetching = sfetch_handle_valid(r.fetch);
+    if (!r.fetching) {
+        fail(r, "fetch request failed");
+    }
+    return h;
+}
+
+void gltf_loader::update() {
+    if (!_valid) {
+        return;
+    }
+
+    _stats.num_loading = 0;
+    _stats.num_done = 0;
+    _stats.num_failed = 0;
+    for (size_t i = 0; i < _requests.size(); i++) {
+        request &r = *_requests[i];
+        if (r.state == gltf_state::invalid) {
+            continue;
+        }
+        const bool idle = !r.fetching && r.chunks.done() && r.packing.done();
+
+        // recycle released requests once nothing references them
+        if (r.released) {
+            if (idle) {
+                const uint16_t generation = r.generation;
+                _requests[i] = std::make_unique<request>();
+                _requests[i]->generation = generation;
+                _free_requests.push_back(static_cast<uint32_t>(i));
+            }
+            continue;
+        }
+
+        // all chunks converted: pack on a worker
+        if (r.state == gltf_state::loading && r.finished && r.chunks.done()) {
+            r.state = gltf_state::processing;
+            r.carry = {};
+            auto job = [this, &r] { pack(r); };
+            if (_desc.jobs) {
+                _desc.jobs->submit(job, &r.packing);
+            }
+            else {
+                job();
+            }
+        }
+        if (r.state == gltf_state::processing && r.packing.done()) {
+            r.state = r.error.empty() ? gltf_state::done : gltf_state::failed;
+            r.staging_bytes = 0;
+        }
+
+        // drop staging data of failed loads
+        if (r.state == gltf_state::failed && idle && r.staging_bytes > 0) {
+            r.primitives = {};
+            r.streams = {};
+            r.model = {};
+            r.staging_bytes = 0;
+        }
+
+        switch (r.state) {
+        case gltf_state::loading:
+        case gltf_state::processing: _stats.num_loading++; break;
+        case gltf_state::done: _stats.num_done++; break;
+        case gltf_state::failed: _stats.num_failed++; break;
+        default: break;
+        }
+    }
+    update_staging();
+}
+
+gltf_state gltf_loader::state(gltf_handle h) const {
+    const request *r = lookup(h);
+    return (r && !r->released) ? r->state : gltf_state::invalid;
+}
+
+const char *gltf_loader::error(gltf_handle h) const {
+    const request *r = lookup(h);
+    return (r && !r->released && r->state == gltf_state::failed) ? r->error.c_str() : "";
+}
+
+bool gltf_loader::take(gltf_handle h, gltf_model &out) {
+    request *r = lookup(h);
+    if (!r || r->released || r->state != gltf_state::done) {
+        return false;
+    }
+    out = std::move(r->model);
+    r->model = {};
+    r->released = true;
+    return true;
+}
+
+void gltf_loader::release(gltf_handle h) {
+    request *r = lookup(h);
+    if (!r || r->released) {
+        return;
+    }
+    if (r->fetching) {
+        sfetch_cancel(r->fetch);
+    }
+    r->released = true;
+}
+
+void gltf_loader::fetch_callback(const sfetch_response_t *response) {
+    const auto *user_data = static_cast<const fetch_user_data *>(response->user_data);
+    gltf_loader *self = user_data->loader;
+    request *r = self->lookup({ user_data->id });
+    if (!r) {
+        return;
+    }
+
+    if (response->fetched && r->state == gltf_state::loading && !r->released) {
+        self->_stats.bytes_fetched += response->fetched_size;
+        self->feed(*r, static_cast<const uint8_t *>(response->buffer_ptr), response->fetched_size);
+    }
+    if (response->finished) {
+        r->fetching = false;
+        if (r->state != gltf_state::loading || r->released) {
+            return;
+        }
+        if (response->failed) {
+            const bool missing = (response->error_code == SFETCH_ERROR_FILE_NOT_FOUND);
+            self->fail(*r, response->cancelled ? "cancelled" : (missing ? "file not found" : "fetch failed"));
+        }
+        else if (r->streams.empty() && r->json_length > 0 && r->head.size() >= glb_header_size + r->json_length) {
+            r->finished = true;
+        }
+        else if (!r->in_bin || r->bin_received < r->bin_length) {
+            self->fail(*r, "unexpected end of file");
+        }
+        else {
+            r->finished = true;
+        }
+    }
+}
+
+void gltf_loader::feed(request &r, const uint8_t *data, uint32_t size) {
+    while (size > 0 && r.state == gltf_state::loading) {
+        // binary chunk: convert on workers
+        if (r.in_bin) {
+            const uint32_t n = std::min(size, r.bin_length - r.bin_received);
+            if (n == 0) {
+                break;
+            }
+            convert(r, data, n);
+            data += n;
+            size -= n;
+            continue;
+        }
+
+        // header, json and binary chunk header are gathered in head
+        const size_t have = r.head.size();
+        size_t need = glb_header_size;
+        if (have >= glb_header_size) {
+            need = (have < glb_header_size + r.json_length) ? glb_header_size + r.json_length : glb_header_size + r.json_length + 8;
+        }
+        const uint32_t n = std::min(size, static_cast<uint32_t>(need - have));
+        r.head.insert(r.head.end(), data, data + n);
+        data += n;
+        size -= n;
+        if (r.head.size() < need) {
+            break;
+        }
+
+        if (need == glb_header_size) {
+            if (read_u32(&r.head[0]) != glb_magic || read_u32(&r.head[4]) != 2 || read_u32(&r.head[16]) != glb_json) {
+                fail(r, "not a binary glTF 2.0 file");
+                return;
+            }
+            r.json_length = read_u32(&r.head[12]);
+            if (r.json_length == 0) {
+                fail(r, "empty json chunk");
+                return;
+            }
+        }
+        else if (need == glb_header_size + r.json_length) {
+            if (!parse(r, reinterpret_cast<const char *>(&r.head[glb_header_size]), r.json_length)) {
+                return;
+            }
+        }
+        else {
+            const uint8_t *header = &r.head[glb_header_size + r.json_length];
+            if (read_u32(header + 4) != glb_bin) {
+                fail(r, "missing binary chunk");
+                return;
+            }
+            r.bin_length = read_u32(header);
+            r.in_bin = true;
+            r.head = {};
+        }
+    }
+}
+
+bool gltf_loader::parse(request &r, const char *text, uint32_t length) {
+    json root;
+    if (!json_parser(text, length).parse(root) || root.kind != json::object_kind) {
+        fail(r, "invalid json");
+        return false;
+    }
+
+    const json &meshes = root["meshes"];
+    const json &accessors = root["accessors"];
+    const json &views = root["bufferViews"];
+    const json &buffer = root["buffers"][size_t(0)];
+    const uint32_t buffer_length = static_cast<uint32_t>(buffer["byteLength"].number_or(0.0));
+
+    // accessor to stream, returns the element count or -1 on error
+    auto add_stream = [&](const json &accessor, int primitive, int attribute, int min_components) -> int {
+        const json &a = item(accessors, accessor);
+        if (!a.valid()) {
+            fail(r, "invalid accessor");
+            return -1;
+        }
+        if (a["sparse"].valid()) {
+            fail(r, "sparse accessors are not supported");
+            return -1;
+        }
+        stream s{};
+        s.primitive = primitive;
+        s.attribute = attribute;
+        s.component_type = static_cast<int>(a["componentType"].number_or(0.0));
+        s.components = type_components(a["type"].string);
+        s.normalized = a["normalized"].bool_or(false);
+        s.count = static_cast<uint32_t>(a["count"].number_or(0.0));
+        s.size = static_cast<uint32_t>(component_size(s.component_type) * s.components);
+        if (s.size == 0 || s.components < min_components || (attribute < 0 && s.components != 1)) {
+            fail(r, "unsupported accessor format");
+            return -1;
+        }
+
+        // accessors without buffer view are all zeros
+        const json &view = item(views, a["bufferView"]);
+        if (view.valid() && s.count > 0) {
+            if (view["buffer"].number_or(0.0) != 0.0 || buffer["uri"].valid()) {
+                fail(r, "external buffers are not supported");
+                return -1;
+            }
+            const auto view_offset = static_cast<uint32_t>(view["byteOffset"].number_or(0.0));
+            const auto view_length = static_cast<uint32_t>(view["byteLength"].number_or(0.0));
+            s.offset = view_offset + static_cast<uint32_t>(a["byteOffset"].number_or(0.0));
+            s.stride = static_cast<uint32_t>(view["byteStride"].number_or(s.size));
+            const uint64_t end = s.offset + static_cast<uint64_t>(s.count - 1) * s.stride + s.size;
+            if (s.stride < s.size || end > static_cast<uint64_t>(view_offset) + view_length || end > buffer_length) {
+                fail(r, "accessor out of range");
+                return -1;
+            }
+            r.max_element = std::max(r.max_element, s.size);
+            r.streams.push_back(s);
+        }
+
+        staging &st = r.primitives[primitive];
+        if (attribute < 0) {
+            st.indices.assign(s.count, 0);
+        }
+        else {
+            st.attributes[attribute].assign(static_cast<size_t>(s.count) * s.components, 0.f);
+            st.components[attribute] = s.components;
+        }
+        r.staging_bytes += (attribute < 0) ? s.count * 4 : static_cast<int64_t>(s.count) * s.components * 4;
+        return static_cast<int>(s.count);
+    };
+
+    for (size_t m = 0; m < meshes.size(); m++) {
+        const json &primitives = meshes[m]["primitives"];
+        for (size_t p = 0; p < primitives.size(); p++) {
+            const json &prim = primitives[p];
+            if (prim["mode"].number_or(4.0) != 4.0) {
+                fail(r, "only triangle primitives are supported");
+                return false;
+            }
+            const int index = static_cast<int>(r.primitives.size());
+            r.primitives.emplace_back();
+            r.primitives.back().attributes.resize(_desc.num_attributes);
+            r.primitives.back().components.assign(_desc.num_attributes, 0);
+            r.primitives.back().num_vertices = -1;
+            r.model.primitives.emplace_back();
+            r.model.primitives.back().mesh = static_cast<int>(m);
+
+            // requested attributes, all with the same vertex count
+            const json &attributes = prim["attributes"];
+            for (int a = 0; a < _desc.num_attributes; a++) {
+                const gltf_attribute &attr = _desc.attributes[a];
+                const json &accessor = attributes[attr.name ? attr.name : ""];
+                if (!accessor.valid()) {
+                    continue;
+                }
+                const int count = add_stream(accessor, index, a, semantic_components(attr.semantic));
+                if (count < 0) {
+                    return false;
+                }
+                int &num_vertices = r.primitives[index].num_vertices;
+                if (num_vertices >= 0 && num_vertices != count) {
+                    fail(r, "attribute counts differ");
+                    return false;
+                }
+                num_vertices = count;
+            }
+            if (r.primitives[index].num_vertices < 0) {
+                const json &position = item(accessors, attributes["POSITION"]);
+                r.primitives[index].num_vertices = static_cast<int>(position["count"].number_or(0.0));
+            }
+
+            const json &indices = prim["indices"];
+            if (indices.valid() && add_stream(indices, index, -1, 1) < 0) {
+                return false;
+            }
+        }
+    }
+
+    // convert streams in binary chunk order
+    std::sort(r.streams.begin(), r.streams.end(), [](const stream &a, const stream &b) { return a.offset < b.offset; });
+    update_staging();
+    return true;
+}
+
+void gltf_loader::convert(request &r, const uint8_t *data, uint32_t size) {
+    chunk &c = acquire_chunk();
+
+    // window: carried tail of the previous chunk + new bytes
+    const uint32_t begin = r.bin_received;
+    const uint32_t end = begin + size;
+    const uint32_t window_begin = begin - static_cast<uint32_t>(r.carry.size());
+    c.data.assign(r.carry.begin(), r.carry.end());
+    c.data.insert(c.data.end(), data, data + size);
+
+    // an element ending in the next chunk starts at most max_element bytes back
+    const size_t keep = std::min<size_t>(r.max_element, c.data.size());
+    r.carry.assign(c.data.end() - keep, c.data.end());
+    r.bin_received = end;
+
+    r.chunks.value.fetch_add(1, std::memory_order_relaxed);
+    auto job = [&r, &c, window_begin, begin, end] {
+        for (const stream &s : r.streams) {
+            if (s.offset >= end) {
+                break;
+            }
+            convert_range(r, s, c.data.data(), window_begin, begin, end);
+        }
+        r.chunks.value.fetch_sub(1, std::memory_order_release);
+    };
+    if (_desc.jobs) {
+        _desc.jobs->submit(job, &c.counter);
+    }
+    else {
+        job();
+    }
+}
+
+void gltf_loader::convert_range(request &r, const stream &s, const uint8_t *window, uint32_t window_begin, uint32_t begin, uint32_t end) {
+    // elements whose last byte lies in (begin, end]
+    const uint64_t first_end = static_cast<uint64_t>(s.offset) + s.size;
+    if (end < first_end) {
+        return;
+    }
+    const uint32_t first = (begin < first_end) ? 0 : static_cast<uint32_t>((begin - first_end) / s.stride + 1);
+    const uint32_t last = std::min<uint32_t>(s.count, static_cast<uint32_t>((end - first_end) / s.stride + 1));
+    if (first >= last) {
+        return;
+    }
+
+    staging &st = r.primitives[s.primitive];
+    const int csize = component_size(s.component_type);
+    for (uint32_t i = first; i < last; i++) {
+        const uint8_t *src = window + (s.offset + static_cast<size_t>(i) * s.stride - window_begin);
+        if (s.attribute < 0) {
+            st.indices[i] = read_index(src, s.component_type);
+            continue;
+        }
+        float *dst = &st.attributes[s.attribute][static_cast<size_t>(i) * s.components];
+        for (int c = 0; c < s.components; c++) {
+            dst[c] = read_float(src + c * csize, s.component_type, s.normalized);
+        }
+    }
+}
+
+void gltf_loader::pack(request &r) {
+    for (size_t p = 0; p < r.primitives.size(); p++) {
+        staging &st = r.primitives[p];
+        gltf_primitive &out = r.model.primitives[p];
+        const int num_vertices = std::max(st.num_vertices, 0);
+
+        vertex_pack_desc desc;
+        desc.num_vertices = num_vertices;
+        desc.num_sources = _desc.num_attributes;
+        for (int a = 0; a < _desc.num_attributes; a++) {
+            const gltf_attribute &attr = _desc.attributes[a];
+            auto &data = st.attributes[a];
+            int components = st.components[a];
+            if (data.empty()) {
+                components = (attr.semantic == vertex_semantic::color) ? 4 : semantic_components(attr.semantic);
+                data.resize(static_cast<size_t>(num_vertices) * components);
+                for (size_t i = 0; i < data.size(); i++) {
+                    data[i] = semantic_default(attr.semantic, static_cast<int>(i % components));
+                }
+            }
+            desc.sources[a] = { attr.semantic, attr.attr, data.data(), components, 0 };
+        }
+        out.vertices = pack_vertices(desc);
+
+        // unindexed primitives get a trivial index list
+        out.indices = std::move(st.indices);
+        if (out.indices.empty()) {
+            out.indices.resize(num_vertices);
+            for (int i = 0; i < num_vertices; i++) {
+                out.indices[i] = static_cast<uint32_t>(i);
+            }
+        }
+        for (uint32_t i : out.indices) {
+            if (i >= static_cast<uint32_t>(num_vertices)) {
+                r.error = "index out of range";
+                break;
+            }
+        }
+        st = {};
+    }
+    r.primitives = {};
+    r.streams = {};
+}
+
+void gltf_loader::fail(request &r, const char *message) {
+    r.state = gltf_state::failed;
+    r.error = message;
+    if (r.fetching) {
+        sfetch_cancel(r.fetch);
+    }
+}
+
+gltf_loader::chunk &gltf_loader::acquire_chunk() {
+    // chunks are used round robin, so the next one is the oldest
+    chunk &c = *_chunks[_next_chunk];
+    _next_chunk = (_next_chunk + 1) % static_cast<int>(_chunks.size());
+    if (_desc.jobs) {
+        _desc.jobs->wait(c.counter);
+    }
+    return c;
+}
+
+gltf_loader::request *gltf_loader::lookup(gltf_handle h) const {
+    const uint32_t index = (h.id & slot_mask);
+    if (index == 0 || index > _requests.size()) {
+        return nullptr;
+    }
+    request *r = _requests[index - 1].get();
+    if (r->state == gltf_state::invalid || r->generation != (h.id >> slot_bits)) {
+        return nullptr;
+    }
+    return r;
+}
+
+void gltf_loader::update_staging() {
+    int64_t bytes = 0;
+    for (const auto &c : _chunks) {
+        bytes += static_cast<int64_t>(c->data.capacity());
+    }
+    for (const auto &r : _requests) {
+        if (r->state == gltf_state::loading || r->state == gltf_state::processing) {
+            bytes += static_cast<int64_t>(r->buffer.size() + r->head.capacity() + r->carry.capacity()) + r->staging_bytes;
+        }
+    }
+    _stats.staging_bytes = bytes;
+    _stats.peak_staging_bytes = std::max(_stats.peak_staging_bytes, bytes);
+}
+
+} // namespace falcon::gfx
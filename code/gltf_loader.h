@@ -0,0 +1,251 @@
+#ifndef FALCON_GLTF_LOADER_H_
+#define FALCON_GLTF_LOADER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "sokol_fetch.h"
+#include "sokol_gfx.h"
+
+#include "job_system.h"
+#include "vertex_packing.h"
+
+namespace falcon::gfx {
+
+// load handle (slot index + generation, 0 is invalid)
+struct gltf_handle {
+    uint32_t id;
+};
+
+// vertex attribute requested from every primitive
+struct gltf_attribute {
+    // glTF attribute name ("POSITION", "NORMAL", "COLOR_0", "TEXCOORD_0")
+    const char *name = nullptr;
+
+    // packed format
+    vertex_semantic semantic = vertex_semantic::position;
+
+    // shader attribute slot (the ATTR_vs_* constant generated by sokol-shdc)
+    int attr = -1;
+};
+
+// gltf loader description
+struct gltf_loader_desc {
+    // vertex format of all loaded primitives, missing attributes are filled
+    // with defaults (white colour, +z normal, zero otherwise)
+    gltf_attribute attributes[SG_MAX_VERTEX_ATTRIBUTES];
+    int num_attributes = 0;
+
+    // worker threads for accessor conversion and packing (nullptr: inline)
+    job_system *jobs = nullptr;
+
+    // fetch chunk size and number of chunks in flight to workers
+    int chunk_size = 64 * 1024;
+    int num_chunks = 4;
+
+    // sokol_fetch channel
+    int channel = 0;
+};
+
+// load state
+enum class gltf_state : uint8_t {
+    invalid,
+    loading,
+    processing,
+    done,
+    failed,
+};
+
+// one triangle primitive, ready for make_vertex_buffer/make_index_buffer
+struct gltf_primitive {
+    // index of the glTF mesh
+    int mesh = 0;
+
+    // packed vertices with layout and dequantization constants
+    packed_vertices vertices;
+
+    // triangle list
+    std::vector<uint32_t> indices;
+};
+
+// loaded model
+struct gltf_model {
+    std::vector<gltf_primitive> primitives;
+};
+
+// gltf loader statistics
+struct gltf_loader_stats {
+    int num_loading;
+    int num_done;
+    int num_failed;
+    int64_t bytes_fetched;
+
+    // staging memory (chunks, json, float streams) now and at most
+    int64_t staging_bytes;
+    int64_t peak_staging_bytes;
+};
+
+// streaming binary glTF 2.0 (.glb) loader on sokol_fetch
+//
+// the file is fetched in chunks. the JSON chunk is parsed on the main thread,
+// every following chunk is handed to a worker which converts the accessor
+// elements ending inside it to float streams, so only num_chunks chunks are
+// buffered at any time. once the file is complete, primitives are packed with
+// pack_vertices on a worker. update() has to be called once per frame.
+//
+// only embedded buffers are supported: external or data uri buffers, sparse
+// accessors and non-triangle primitives fail the load. node transforms are
+// ignored, primitives are returned in mesh space.
+class gltf_loader {
+public:
+    // ctor
+    gltf_loader() = default;
+
+    // dtor
+    ~gltf_loader() { shutdown(); }
+
+    gltf_loader(const gltf_loader &) = delete;
+    gltf_loader &operator=(const gltf_loader &) = delete;
+
+    // set the vertex format and chunk buffers
+    void setup(const gltf_loader_desc &desc);
+
+    // cancel loads and wait for workers
+    void shutdown();
+
+    // start loading a file
+    gltf_handle load(const char *path);
+
+    // finish processed loads
+    void update();
+
+    // get state of a load
+    gltf_state state(gltf_handle h) const;
+
+    // get error message of a failed load
+    const char *error(gltf_handle h) const;
+
+    // move the model of a finished load out and release the handle
+    bool take(gltf_handle h, gltf_model &out);
+
+    // release a handle (cancels a running load)
+    void release(gltf_handle h);
+
+    // get statistics
+    inline const gltf_loader_stats &stats() const { return _stats; }
+
+private:
+    // accessor conversion into a float or index stream
+    struct stream {
+        // primitive and requested attribute (-1: indices)
+        int primitive;
+        int attribute;
+
+        // element layout in the binary chunk
+        uint32_t offset;
+        uint32_t stride;
+        uint32_t size;
+        uint32_t count;
+        int component_type;
+        int components;
+        bool normalized;
+    };
+
+    // primitive staging data
+    struct staging {
+        std::vector<std::vector<float>> attributes;
+        std::vector<int> components;
+        std::vector<uint32_t> indices;
+        int num_vertices;
+    };
+
+    // one load
+    struct request {
+        uint16_t generation = 0;
+        gltf_state state = gltf_state::invalid;
+        bool released = false;
+        std::string error;
+
+        // fetch
+        sfetch_handle_t fetch{};
+        std::vector<uint8_t> buffer;
+        bool fetching = false;
+
+        // header and json chunk
+        std::vector<uint8_t> head;
+        uint32_t json_length = 0;
+        uint32_t bin_length = 0;
+        bool in_bin = false;
+
+        // binary chunk
+        uint32_t bin_received = 0;
+        uint32_t max_element = 0;
+        std::vector<uint8_t> carry;
+        std::vector<stream> streams;
+
+        // conversion and packing
+        std::vector<staging> primitives;
+        int64_t staging_bytes = 0;
+        gltf_model model;
+        job_counter chunks;
+        job_counter packing;
+        bool finished = false;
+    };
+
+    // chunk handed to a worker
+    struct chunk {
+        std::vector<uint8_t> data;
+        job_counter counter;
+    };
+
+    // sokol_fetch callback
+    static void fetch_callback(const sfetch_response_t *response);
+
+    // consume fetched bytes
+    void feed(request &r, const uint8_t *data, uint32_t size);
+
+    // parse json and create streams
+    bool parse(request &r, const char *json, uint32_t length);
+
+    // hand binary bytes to a worker
+    void convert(request &r, const uint8_t *data, uint32_t size);
+
+    // convert the elements of a stream ending in (begin, end] of the binary chunk
+    static void convert_range(request &r, const stream &s, const uint8_t *window, uint32_t window_begin, uint32_t begin, uint32_t end);
+
+    // pack staged primitives
+    void pack(request &r);
+
+    // fail a load
+    void fail(request &r, const char *message);
+
+    // get a free chunk, waits for the oldest if all are in flight
+    chunk &acquire_chunk();
+
+    // find request from handle
+    request *lookup(gltf_handle h) const;
+
+    // recount staging memory
+    void update_staging();
+
+    // description
+    gltf_loader_desc _desc;
+    bool _valid = false;
+
+    // requests (stable addresses for callbacks and jobs)
+    std::vector<std::unique_ptr<request>> _requests;
+    std::vector<uint32_t> _free_requests;
+
+    // chunk ring
+    std::vector<std::unique_ptr<chunk>> _chunks;
+    int _next_chunk = 0;
+
+    // statistics
+    gltf_loader_stats _stats{};
+};
+
+} // namespace falcon::gfx
+
+#endif // FALCON_GLTF_LOADER_H_
@@ -0,0 +1,64 @@
+// sokol_app entry points without a window, for test runs against the
+// sokol_gfx dummy backend (FALCON_HEADLESS, sokol_app is then not compiled)
+#if defined(FALCON_HEADLESS)
+
+#include "sokol_app.h"
+#include "sokol_gfx.h"
+#include "sokol_glue.h"
+
+namespace {
+
+// framebuffer size from the app description
+int _width = 640;
+int _height = 480;
+
+// set by sapp_request_quit/sapp_quit, checked after every frame
+bool _quit = false;
+
+} // namespace
+
+void sapp_run(const sapp_desc *desc) {
+    _width = (desc->width > 0) ? desc->width : 640;
+    _height = (desc->height > 0) ? desc->height : 480;
+    _quit = false;
+
+    // frames until the app quits (bench_frames or the end of a replay)
+    if (desc->init_userdata_cb) {
+        desc->init_userdata_cb(desc->user_data);
+    }
+    while (!_quit) {
+        if (desc->frame_userdata_cb) {
+            desc->frame_userdata_cb(desc->user_data);
+        }
+    }
+    if (desc->cleanup_userdata_cb) {
+        desc->cleanup_userdata_cb(desc->user_data);
+    }
+}
+
+int sapp_width(void) {
+    return _width;
+}
+
+int sapp_height(void) {
+    return _height;
+}
+
+bool sapp_gles2(void) {
+    return false;
+}
+
+void sapp_request_quit(void) {
+    _quit = true;
+}
+
+void sapp_quit(void) {
+    _quit = true;
+}
+
+sg_context_desc sapp_sgcontext(void) {
+    // the dummy backend has no context
+    return {};
+}
+
+#endif // FALCON_HEADLESS
@@ -0,0 +1,107 @@
+#include "input.h"
+
+namespace falcon {
+
+namespace {
+
+// bitset ranges
+inline bool valid_key(int key) {
+    return key > 0 && key < SAPP_MAX_KEYCODES;
+}
+
+inline bool valid_button(int button) {
+    return button >= 0 && button < SAPP_MAX_MOUSEBUTTONS;
+}
+
+} // namespace
+
+bool input_system::handle(const sapp_event *ev) {
+    input_snapshot &s = _state;
+    s.num_events++;
+    s.modifiers = ev->modifiers;
+
+    switch (ev->type) {
+    case SAPP_EVENTTYPE_KEY_DOWN:
+        if (valid_key(ev->key_code) && !ev->key_repeat) {
+            s.keys_down.set(ev->key_code);
+            s.keys_pressed.set(ev->key_code);
+        }
+        return true;
+
+    case SAPP_EVENTTYPE_KEY_UP:
+        if (valid_key(ev->key_code)) {
+            s.keys_down.reset(ev->key_code);
+            s.keys_released.set(ev->key_code);
+        }
+        return true;
+
+    case SAPP_EVENTTYPE_MOUSE_DOWN:
+        if (valid_button(ev->mouse_button)) {
+            s.buttons_down.set(ev->mouse_button);
+            s.buttons_pressed.set(ev->mouse_button);
+        }
+        return true;
+
+    case SAPP_EVENTTYPE_MOUSE_UP:
+        if (valid_button(ev->mouse_button)) {
+            s.buttons_down.reset(ev->mouse_button);
+            s.buttons_released.set(ev->mouse_button);
+        }
+        return true;
+
+    case SAPP_EVENTTYPE_MOUSE_MOVE:
+        // the first position has no previous one to move from
+        if (_has_mouse) {
+            s.mouse_dx += ev->mouse_x - s.mouse_x;
+            s.mouse_dy += ev->mouse_y - s.mouse_y;
+        }
+        s.mouse_x = ev->mouse_x;
+        s.mouse_y = ev->mouse_y;
+        _has_mouse = true;
+        s.num_coalesced++;
+        return false;
+
+    case SAPP_EVENTTYPE_MOUSE_SCROLL:
+        s.scroll_x += ev->scroll_x;
+        s.scroll_y += ev->scroll_y;
+        s.num_coalesced++;
+        return false;
+
+    case SAPP_EVENTTYPE_MOUSE_LEAVE:
+        _has_mouse = false;
+        return true;
+
+    case SAPP_EVENTTYPE_ICONIFIED:
+    case SAPP_EVENTTYPE_SUSPENDED:
+        reset();
+        return true;
+
+    default:
+        return true;
+    }
+}
+
+void input_system::publish(input_snapshot &out) {
+    out = _state;
+
+    // per-frame parts start over
+    _state.keys_pressed.reset();
+    _state.keys_released.reset();
+    _state.buttons_pressed.reset();
+    _state.buttons_released.reset();
+    _state.mouse_dx = 0.0f;
+    _state.mouse_dy = 0.0f;
+    _state.scroll_x = 0.0f;
+    _state.scroll_y = 0.0f;
+    _state.num_events = 0;
+    _state.num_coalesced = 0;
+}
+
+void input_system::reset() {
+    _state.keys_released |= _state.keys_down;
+    _state.buttons_released |= _state.buttons_down;
+    _state.keys_down.reset();
+    _state.buttons_down.reset();
+}
+
+} // namespace falcon
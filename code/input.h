@@ -0,0 +1,88 @@
+#ifndef FALCON_INPUT_H_
+#define FALCON_INPUT_H_
+
+#include <bitset>
+#include <cstdint>
+
+#include "sokol_app.h"
+
+namespace falcon {
+
+// input state of one frame
+//
+// a plain value: published once per frame and not modified afterwards, so
+// workers can read it without locking.
+struct input_snapshot {
+    // keys held, and keys that went down or up during the frame
+    std::bitset<SAPP_MAX_KEYCODES> keys_down;
+    std::bitset<SAPP_MAX_KEYCODES> keys_pressed;
+    std::bitset<SAPP_MAX_KEYCODES> keys_released;
+
+    // same for mouse buttons
+    std::bitset<SAPP_MAX_MOUSEBUTTONS> buttons_down;
+    std::bitset<SAPP_MAX_MOUSEBUTTONS> buttons_pressed;
+    std::bitset<SAPP_MAX_MOUSEBUTTONS> buttons_released;
+
+    // last mouse position, movement and scrolling summed over the frame
+    float mouse_x = 0.0f;
+    float mouse_y = 0.0f;
+    float mouse_dx = 0.0f;
+    float mouse_dy = 0.0f;
+    float scroll_x = 0.0f;
+    float scroll_y = 0.0f;
+
+    // SAPP_MODIFIER_* of the last event
+    uint32_t modifiers = 0;
+
+    // events received and how many of them were move or scroll events
+    int num_events = 0;
+    int num_coalesced = 0;
+
+    // key queries
+    inline bool down(sapp_keycode key) const { return valid_key(key) && keys_down[key]; }
+    inline bool pressed(sapp_keycode key) const { return valid_key(key) && keys_pressed[key]; }
+    inline bool released(sapp_keycode key) const { return valid_key(key) && keys_released[key]; }
+
+    // mouse button queries
+    inline bool down(sapp_mousebutton button) const { return valid_button(button) && buttons_down[button]; }
+    inline bool pressed(sapp_mousebutton button) const { return valid_button(button) && buttons_pressed[button]; }
+    inline bool released(sapp_mousebutton button) const { return valid_button(button) && buttons_released[button]; }
+
+private:
+    static inline bool valid_key(int key) { return key > 0 && key < SAPP_MAX_KEYCODES; }
+    static inline bool valid_button(int button) { return button >= 0 && button < SAPP_MAX_MOUSEBUTTONS; }
+};
+
+// accumulates sapp events into per-frame snapshots
+//
+// key and button events update the state bitsets, move and scroll events are
+// summed. a key pressed and released within one frame shows up in both
+// pressed and released but not in down. held keys and buttons are released
+// when the window is iconified or suspended, as their up events get lost.
+class input_system {
+public:
+    // ctor
+    input_system() = default;
+
+    input_system(const input_system &) = delete;
+    input_system &operator=(const input_system &) = delete;
+
+    // add an event, returns false for move and scroll events which are only
+    // accumulated
+    bool handle(const sapp_event *ev);
+
+    // write the state of the frame and start the next one
+    void publish(input_snapshot &out);
+
+    // release all keys and buttons
+    void reset();
+
+private:
+    // state of the frame being collected
+    input_snapshot _state;
+    bool _has_mouse = false;
+};
+
+} // namespace falcon
+
+#endif // FALCON_INPUT_H_
@@ -0,0 +1,220 @@
+#include "input_recorder.h"
+
+#include <algorithm>
+
+namespace falcon {
+
+namespace {
+
+// file header
+struct header {
+    char magic[4];
+    uint32_t version;
+    uint32_t event_size;
+    uint32_t seed;
+};
+
+// touch point of an event record
+struct touch_record {
+    uint64_t identifier;
+    float pos_x, pos_y;
+    uint32_t changed;
+    uint32_t padding;
+};
+
+// the sapp_event fields used by falcon, in a layout independent of sokol_app
+struct event_record {
+    uint32_t type;
+    uint32_t key_code;
+    uint32_t char_code;
+    uint32_t key_repeat;
+    uint32_t modifiers;
+    int32_t mouse_button;
+    float mouse_x, mouse_y;
+    float scroll_x, scroll_y;
+    int32_t window_width, window_height;
+    int32_t framebuffer_width, framebuffer_height;
+    int32_t num_touches;
+    uint32_t padding;
+    touch_record touches[8];
+};
+
+// frame record, followed by num_events events
+struct frame_header {
+    double dt;
+    uint32_t num_events;
+    uint32_t padding;
+};
+
+constexpr char magic[4] = { 'F', 'R', 'E', 'C' };
+constexpr uint32_t version = 2;
+constexpr int max_touches = static_cast<int>(sizeof(event_record::touches) / sizeof(touch_record));
+
+// convert an event to a record
+event_record to_record(const sapp_event &ev) {
+    event_record r{};
+    r.type = static_cast<uint32_t>(ev.type);
+    r.key_code = static_cast<uint32_t>(ev.key_code);
+    r.char_code = ev.char_code;
+    r.key_repeat = ev.key_repeat ? 1 : 0;
+    r.modifiers = ev.modifiers;
+    r.mouse_button = static_cast<int32_t>(ev.mouse_button);
+    r.mouse_x = ev.mouse_x;
+    r.mouse_y = ev.mouse_y;
+    r.scroll_x = ev.scroll_x;
+    r.scroll_y = ev.scroll_y;
+    r.window_width = ev.window_width;
+    r.window_height = ev.window_height;
+    r.framebuffer_width = ev.framebuffer_width;
+    r.framebuffer_height = ev.framebuffer_height;
+    r.num_touches = std::min(ev.num_touches, max_touches);
+    for (int i = 0; i < r.num_touches; i++) {
+        r.touches[i] = { static_cast<uint64_t>(ev.touches[i].identifier), ev.touches[i].pos_x, ev.touches[i].pos_y, ev.touches[i].changed ? 1u : 0u, 0 };
+    }
+    return r;
+}
+
+// convert a record back to an event
+sapp_event to_event(const event_record &r) {
+    sapp_event ev{};
+    ev.type = static_cast<sapp_event_type>(r.type);
+    ev.key_code = static_cast<sapp_keycode>(r.key_code);
+    ev.char_code = r.char_code;
+    ev.key_repeat = r.key_repeat != 0;
+    ev.modifiers = r.modifiers;
+    ev.mouse_button = static_cast<sapp_mousebutton>(r.mouse_button);
+    ev.mouse_x = r.mouse_x;
+    ev.mouse_y = r.mouse_y;
+    ev.scroll_x = r.scroll_x;
+    ev.scroll_y = r.scroll_y;
+    ev.window_width = r.window_width;
+    ev.window_height = r.window_height;
+    ev.framebuffer_width = r.framebuffer_width;
+    ev.framebuffer_height = r.framebuffer_height;
+    ev.num_touches = std::min<int>(std::min<int>(r.num_touches, max_touches), SAPP_MAX_TOUCHPOINTS);
+    for (int i = 0; i < ev.num_touches; i++) {
+        ev.touches[i].identifier = static_cast<uintptr_t>(r.touches[i].identifier);
+        ev.touches[i].pos_x = r.touches[i].pos_x;
+        ev.touches[i].pos_y = r.touches[i].pos_y;
+        ev.touches[i].changed = r.touches[i].changed != 0;
+    }
+    return ev;
+}
+
+} // namespace
+
+bool input_recorder::record(const char *path, uint32_t seed) {
+    stop();
+
+    _file = fopen(path, "wb");
+    if (!_file) {
+        return fail("cannot open file for writing");
+    }
+    const header h{ { magic[0], magic[1], magic[2], magic[3] }, version, static_cast<uint32_t>(sizeof(event_record)), seed };
+    if (fwrite(&h, sizeof(h), 1, _file) != 1) {
+        return fail("cannot write header");
+    }
+    _mode = recorder_mode::record;
+    _seed = seed;
+    return true;
+}
+
+bool input_recorder::replay(const char *path) {
+    stop();
+
+    _file = fopen(path, "rb");
+    if (!_file) {
+        return fail("file not found");
+    }
+    header h{};
+    if (fread(&h, sizeof(h), 1, _file) != 1 || !std::equal(magic, magic + 4, h.magic)) {
+        return fail("not a recording");
+    }
+    if (h.version != version || h.event_size != sizeof(event_record)) {
+        return fail("recorded with a different version");
+    }
+    _mode = recorder_mode::replay;
+    _seed = h.seed;
+    _totals = {};
+    return true;
+}
+
+void input_recorder::stop() {
+    if (_file) {
+        fclose(_file);
+        _file = nullptr;
+    }
+    _mode = recorder_mode::off;
+    _events.clear();
+}
+
+void input_recorder::add_event(const sapp_event *ev) {
+    if (_mode == recorder_mode::record) {
+        _events.push_back(*ev);
+    }
+}
+
+void input_recorder::end_frame(double dt) {
+    if (_mode != recorder_mode::record) {
+        return;
+    }
+    const frame_header f{ dt, static_cast<uint32_t>(_events.size()), 0 };
+    fwrite(&f, sizeof(f), 1, _file);
+    for (const sapp_event &ev : _events) {
+        const event_record r = to_record(ev);
+        fwrite(&r, sizeof(r), 1, _file);
+    }
+    _events.clear();
+}
+
+bool input_recorder::next_frame(double &dt, std::vector<sapp_event> &events) {
+    if (_mode != recorder_mode::replay) {
+        return false;
+    }
+    frame_header f{};
+    if (fread(&f, sizeof(f), 1, _file) != 1) {
+        return false;
+    }
+    events.clear();
+    for (uint32_t i = 0; i < f.num_events; i++) {
+        event_record r{};
+        if (fread(&r, sizeof(r), 1, _file) != 1) {
+            return false;
+        }
+        events.push_back(to_event(r));
+    }
+    dt = f.dt;
+    return true;
+}
+
+void input_recorder::account(double frame_ms, double update_ms, double render_ms) {
+    _totals.min_frame_ms = (_totals.num_frames > 0) ? std::min(_totals.min_frame_ms, frame_ms) : frame_ms;
+    _totals.max_frame_ms = std::max(_totals.max_frame_ms, frame_ms);
+    _totals.num_frames++;
+    _totals.frame_ms += frame_ms;
+    _totals.update_ms += update_ms;
+    _totals.render_ms += render_ms;
+}
+
+replay_stats input_recorder::stats() const {
+    replay_stats s = _totals;
+    if (s.num_frames > 0) {
+        const double n = static_cast<double>(s.num_frames);
+        s.frame_ms /= n;
+        s.update_ms /= n;
+        s.render_ms /= n;
+    }
+    return s;
+}
+
+bool input_recorder::fail(const char *message) {
+    if (_file) {
+        fclose(_file);
+        _file = nullptr;
+    }
+    _mode = recorder_mode::off;
+    _error = message;
+    return false;
+}
+
+} // namespace falcon
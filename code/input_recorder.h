@@ -0,0 +1,101 @@
+#ifndef FALCON_INPUT_RECORDER_H_
+#define FALCON_INPUT_RECORDER_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "sokol_app.h"
+
+namespace falcon {
+
+// recorder mode
+enum class recorder_mode : uint8_t {
+    off,
+    record,
+    replay,
+};
+
+// replay statistics (cpu time inside frame_cb of drawn frames)
+struct replay_stats {
+    int num_frames;
+    double frame_ms;
+    double min_frame_ms;
+    double max_frame_ms;
+    double update_ms;
+    double render_ms;
+};
+
+// records sapp events and frame deltas to a file and plays them back
+//
+// the file starts with the random seed of the run, followed by one record per
+// frame: the delta time and the events delivered before that frame. events
+// are stored as fixed-size records of the sapp_event fields falcon reads, so
+// recordings do not depend on the sapp_event layout and can be checked in.
+// event types and key codes keep sokol's values, numbers are stored in
+// native byte order (little endian on all supported targets).
+class input_recorder {
+public:
+    // ctor
+    input_recorder() = default;
+
+    // dtor
+    ~input_recorder() { stop(); }
+
+    input_recorder(const input_recorder &) = delete;
+    input_recorder &operator=(const input_recorder &) = delete;
+
+    // start recording into a file
+    bool record(const char *path, uint32_t seed);
+
+    // start replaying a file
+    bool replay(const char *path);
+
+    // close the file
+    void stop();
+
+    // add an event of the next frame (record)
+    void add_event(const sapp_event *ev);
+
+    // write the frame with its events (record)
+    void end_frame(double dt);
+
+    // read the next frame, false at the end of the file (replay)
+    bool next_frame(double &dt, std::vector<sapp_event> &events);
+
+    // add the cost of a replayed frame
+    void account(double frame_ms, double update_ms, double render_ms);
+
+    // get mode
+    inline recorder_mode mode() const { return _mode; }
+
+    // get seed of the recording
+    inline uint32_t seed() const { return _seed; }
+
+    // get error message of a failed record() or replay()
+    inline const char *error() const { return _error.c_str(); }
+
+    // get replay statistics, averages over num_frames
+    replay_stats stats() const;
+
+private:
+    // fail with a message
+    bool fail(const char *message);
+
+    // file
+    FILE *_file = nullptr;
+    recorder_mode _mode = recorder_mode::off;
+    uint32_t _seed = 0;
+    std::string _error;
+
+    // events of the frame being recorded
+    std::vector<sapp_event> _events;
+
+    // replay totals
+    replay_stats _totals{};
+};
+
+} // namespace falcon
+
+#endif // FALCON_INPUT_RECORDER_H_
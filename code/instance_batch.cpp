@@ -0,0 +1,241 @@
+#include "instance_batch.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace falcon::gfx {
+
+void instance_batch::setup(const instance_batch_desc &desc) {
+    shutdown();
+
+    _desc = desc;
+
+    sg_buffer_desc buffer_desc{};
+    buffer_desc.type = SG_BUFFERTYPE_VERTEXBUFFER;
+    buffer_desc.usage = SG_USAGE_STREAM;
+    buffer_desc.size = _desc.instance_size * _desc.max_instances;
+    buffer_desc.label = _desc.label;
+    _buffer = sg_make_buffer(&buffer_desc);
+
+    _records.reserve(_desc.max_instances);
+    _instances.reserve(static_cast<size_t>(_desc.instance_size) * _desc.max_instances);
+    _staging.reserve(_instances.capacity());
+}
+
+void instance_batch::shutdown() {
+    if (_buffer.id != SG_INVALID_ID) {
+        sg_destroy_buffer(_buffer);
+        _buffer = {};
+    }
+    _records.clear();
+    _instances.clear();
+    _staging.clear();
+    _bindings.clear();
+    _uniform_data.clear();
+    _uniform_blocks.clear();
+    _uniform_sets.clear();
+    _uniform_lookup.clear();
+    _current_uniforms = 0;
+    _num_draws = 0;
+    _num_dropped = 0;
+    _frame = ~0ull;
+    _frame_instances = 0;
+    _stats = {};
+}
+
+void instance_batch::uniforms(sg_shader_stage stage, int ub_index, const void *data, int num_bytes) {
+    // start a new set from the current one, replacing the same slot
+    const size_t data_size = _uniform_data.size();
+    uniform_set set{ static_cast<uint32_t>(_uniform_blocks.size()), 0 };
+    if (_current_uniforms > 0) {
+        const auto current = _uniform_sets[_current_uniforms - 1];
+        for (uint32_t i = 0; i < current.count; i++) {
+            const auto block = _uniform_blocks[current.first + i];
+            if (block.stage != stage || block.ub_index != ub_index) {
+                _uniform_blocks.push_back(block);
+                set.count++;
+            }
+        }
+    }
+
+    const auto offset = static_cast<uint32_t>(_uniform_data.size());
+    _uniform_data.insert(_uniform_data.end(), static_cast<const uint8_t *>(data), static_cast<const uint8_t *>(data) + num_bytes);
+    _uniform_blocks.push_back({ stage, ub_index, offset, num_bytes });
+    set.count++;
+    std::sort(_uniform_blocks.begin() + set.first, _uniform_blocks.end(), [](const uniform_block &a, const uniform_block &b) {
+        return (a.stage != b.stage) ? a.stage < b.stage : a.ub_index < b.ub_index;
+    });
+
+    // an equal set exists, drop the copy
+    const uint64_t h = hash(set);
+    const auto range = _uniform_lookup.equal_range(h);
+    for (auto i = range.first; i != range.second; ++i) {
+        if (equal(_uniform_sets[i->second], set)) {
+            _uniform_blocks.resize(set.first);
+            _uniform_data.resize(data_size);
+            _current_uniforms = i->second + 1;
+            return;
+        }
+    }
+    _uniform_sets.push_back(set);
+    _current_uniforms = static_cast<uint32_t>(_uniform_sets.size());
+    _uniform_lookup.emplace(h, _current_uniforms - 1);
+}
+
+void instance_batch::draw(sg_pipeline pip, const sg_bindings &bindings, int base_element, int num_elements, const void *instance_data) {
+    if (_frame != frame_index()) {
+        begin_frame();
+    }
+    _num_draws++;
+
+    // the stream buffer holds max_instances for all flushes of the frame
+    if (_frame_instances + static_cast<int>(_records.size()) >= _desc.max_instances) {
+        _num_dropped++;
+        return;
+    }
+
+    const auto order = static_cast<uint32_t>(_records.size());
+    _records.push_back({ pip.id, intern(bindings), _current_uniforms, base_element, num_elements, order });
+
+    auto *data = static_cast<const uint8_t *>(instance_data);
+    _instances.insert(_instances.end(), data, data + _desc.instance_size);
+}
+
+void instance_batch::flush() {
+    _stats = {};
+    _stats.num_draws = _num_draws;
+    _stats.num_dropped = _num_dropped;
+    _num_draws = 0;
+    _num_dropped = 0;
+
+    if (!_records.empty()) {
+        // group identical draws, keep submission order inside a group
+        std::sort(_records.begin(), _records.end(), [](const record &a, const record &b) {
+            if (a.pipeline != b.pipeline) return a.pipeline < b.pipeline;
+            if (a.bindings != b.bindings) return a.bindings < b.bindings;
+            if (a.uniforms != b.uniforms) return a.uniforms < b.uniforms;
+            if (a.base_element != b.base_element) return a.base_element < b.base_element;
+            if (a.num_elements != b.num_elements) return a.num_elements < b.num_elements;
+            return a.order < b.order;
+        });
+
+        // gather instance data in batch order, one append for the whole flush
+        const size_t size = static_cast<size_t>(_desc.instance_size);
+        _staging.resize(_records.size() * size);
+        for (size_t i = 0; i < _records.size(); i++) {
+            std::memcpy(&_staging[i * size], &_instances[_records[i].order * size], size);
+        }
+        const int base_offset = sg_append_buffer(_buffer, _staging.data(), static_cast<int>(_staging.size()));
+        _frame_instances += static_cast<int>(_records.size());
+
+        // emit one instanced draw per group
+        uint32_t current_pipeline = SG_INVALID_ID;
+        uint32_t current_uniforms = 0;
+        for (size_t first = 0; first < _records.size();) {
+            const auto &r = _records[first];
+            size_t last = first + 1;
+            while (last < _records.size()
+                && _records[last].pipeline == r.pipeline
+                && _records[last].bindings == r.bindings
+                && _records[last].uniforms == r.uniforms
+                && _records[last].base_element == r.base_element
+                && _records[last].num_elements == r.num_elements) {
+                last++;
+            }
+
+            if (r.pipeline != current_pipeline) {
+                sg_apply_pipeline({ r.pipeline });
+                current_pipeline = r.pipeline;
+                current_uniforms = 0;
+            }
+            if (r.uniforms != current_uniforms && r.uniforms > 0) {
+                const auto &set = _uniform_sets[r.uniforms - 1];
+                for (uint32_t i = 0; i < set.count; i++) {
+                    const auto &block = _uniform_blocks[set.first + i];
+                    sg_apply_uniforms(block.stage, block.ub_index, &_uniform_data[block.offset], block.num_bytes);
+                }
+                current_uniforms = r.uniforms;
+            }
+
+            auto bindings = _bindings[r.bindings];
+            bindings.vertex_buffers[_desc.instance_buffer_slot] = _buffer;
+            bindings.vertex_buffer_offsets[_desc.instance_buffer_slot] = base_offset + static_cast<int>(first * size);
+            sg_apply_bindings(&bindings);
+            sg_draw(r.base_element, r.num_elements, static_cast<int>(last - first));
+
+            _stats.num_batches++;
+            _stats.num_instances += static_cast<int>(last - first);
+            first = last;
+        }
+    }
+
+    // reset for the next pass
+    _records.clear();
+    _instances.clear();
+    _bindings.clear();
+    _uniform_data.clear();
+    _uniform_blocks.clear();
+    _uniform_sets.clear();
+    _uniform_lookup.clear();
+    _current_uniforms = 0;
+}
+
+void instance_batch::begin_frame() {
+    _frame = frame_index();
+    _frame_instances = 0;
+}
+
+void instance_batch::configure_layout(sg_pipeline_desc &desc, int buffer_slot, int first_attr, int num_vec4_attrs) {
+    desc.layout.buffers[buffer_slot].step_func = SG_VERTEXSTEP_PER_INSTANCE;
+    for (int i = 0; i < num_vec4_attrs; i++) {
+        auto &attr = desc.layout.attrs[first_attr + i];
+        attr.buffer_index = buffer_slot;
+        attr.offset = i * 16;
+        attr.format = SG_VERTEXFORMAT_FLOAT4;
+    }
+}
+
+uint32_t instance_batch::intern(const sg_bindings &bindings) {
+    // draws usually come in runs with the same bindings, search backwards
+    for (size_t i = _bindings.size(); i > 0; i--) {
+        if (std::memcmp(&_bindings[i - 1], &bindings, sizeof(sg_bindings)) == 0) {
+            return static_cast<uint32_t>(i - 1);
+        }
+    }
+    _bindings.push_back(bindings);
+    return static_cast<uint32_t>(_bindings.size() - 1);
+}
+
+uint64_t instance_batch::hash(const uniform_set &set) const {
+    // fnv-1a over slots and data
+    uint64_t h = 14695981039346656037ull;
+    auto mix = [&h](const uint8_t *p, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            h = (h ^ p[i]) * 1099511628211ull;
+        }
+    };
+    for (uint32_t i = 0; i < set.count; i++) {
+        const auto &block = _uniform_blocks[set.first + i];
+        const int slot[2] = { static_cast<int>(block.stage), block.ub_index };
+        mix(reinterpret_cast<const uint8_t *>(slot), sizeof(slot));
+        mix(&_uniform_data[block.offset], static_cast<size_t>(block.num_bytes));
+    }
+    return h;
+}
+
+bool instance_batch::equal(const uniform_set &a, const uniform_set &b) const {
+    if (a.count != b.count) {
+        return false;
+    }
+    for (uint32_t i = 0; i < a.count; i++) {
+        const auto &x = _uniform_blocks[a.first + i];
+        const auto &y = _uniform_blocks[b.first + i];
+        if (x.stage != y.stage || x.ub_index != y.ub_index || x.num_bytes != y.num_bytes
+            || std::memcmp(&_uniform_data[x.offset], &_uniform_data[y.offset], x.num_bytes) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace falcon::gfx
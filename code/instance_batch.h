@@ -0,0 +1,159 @@
+#ifndef FALCON_INSTANCE_BATCH_H_
+#define FALCON_INSTANCE_BATCH_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "sokol_gfx.h"
+
+#include "gfx.h"
+
+namespace falcon::gfx {
+
+// instance batch description
+struct instance_batch_desc {
+    // per-instance data size in bytes (e.g. 64 for a mat4)
+    int instance_size = 64;
+
+    // instance capacity per frame
+    int max_instances = 16 * 1024;
+
+    // vertex buffer slot receiving the per-instance stream
+    int instance_buffer_slot = 1;
+
+    // debug label
+    const char *label = nullptr;
+};
+
+// instance batch statistics (reset by flush, dropped draws include those
+// over the per-frame capacity)
+struct instance_batch_stats {
+    int num_draws;
+    int num_batches;
+    int num_instances;
+    int num_dropped;
+};
+
+// collects draws and merges those sharing pipeline, bindings, uniforms and
+// element range into one instanced draw
+//
+// per-draw data (usually the model transform) is packed into a stream buffer
+// bound at instance_buffer_slot, the pipeline has to read it with
+// SG_VERTEXSTEP_PER_INSTANCE (see configure_layout). draws are grouped,
+// so order is only preserved between draws of the same group.
+class instance_batch {
+public:
+    // ctor
+    instance_batch() = default;
+
+    // dtor
+    ~instance_batch() { shutdown(); }
+
+    instance_batch(const instance_batch &) = delete;
+    instance_batch &operator=(const instance_batch &) = delete;
+
+    // create the instance stream buffer
+    void setup(const instance_batch_desc &desc);
+
+    // destroy the instance stream buffer
+    void shutdown();
+
+    // set a uniform block for the following draws, a set of blocks equal to
+    // an earlier one reuses it so the draws still merge
+    void uniforms(sg_shader_stage stage, int ub_index, const void *data, int num_bytes);
+
+    // record a draw with its per-instance data
+    void draw(sg_pipeline pip, const sg_bindings &bindings, int base_element, int num_elements, const void *instance_data);
+
+    // emit the recorded draws into the current pass, may be called once per
+    // pass as long as the frame stays within max_instances
+    void flush();
+
+    // start counting instances of a new frame, happens on its own on the
+    // first draw of the next application frame
+    void begin_frame();
+
+    // add per-instance vec4 attributes to a pipeline layout
+    static void configure_layout(sg_pipeline_desc &desc, int buffer_slot, int first_attr, int num_vec4_attrs);
+
+    // get instance stream buffer
+    inline sg_buffer buffer() const { return _buffer; }
+
+    // get statistics of the last flush
+    inline const instance_batch_stats &stats() const { return _stats; }
+
+private:
+    // recorded draw
+    struct record {
+        uint32_t pipeline;
+        uint32_t bindings;
+        uint32_t uniforms;
+        int base_element;
+        int num_elements;
+        uint32_t order;
+    };
+
+    // uniform block
+    struct uniform_block {
+        sg_shader_stage stage;
+        int ub_index;
+        uint32_t offset;
+        int num_bytes;
+    };
+
+    // uniform set (all blocks bound at a time)
+    struct uniform_set {
+        uint32_t first;
+        uint32_t count;
+    };
+
+    // find or add bindings
+    uint32_t intern(const sg_bindings &bindings);
+
+    // hash and compare uniform sets (blocks are sorted by stage and slot)
+    uint64_t hash(const uniform_set &set) const;
+    bool equal(const uniform_set &a, const uniform_set &b) const;
+
+    // description
+    instance_batch_desc _desc;
+
+    // instance stream
+    sg_buffer _buffer{};
+
+    // recorded draws
+    std::vector<record> _records;
+
+    // per-instance data in record order
+    std::vector<uint8_t> _instances;
+
+    // per-instance data in batch order
+    std::vector<uint8_t> _staging;
+
+    // unique bindings
+    std::vector<sg_bindings> _bindings;
+
+    // uniform data
+    std::vector<uint8_t> _uniform_data;
+    std::vector<uniform_block> _uniform_blocks;
+    std::vector<uniform_set> _uniform_sets;
+    std::unordered_multimap<uint64_t, uint32_t> _uniform_lookup;
+
+    // set of the following draws (index + 1, 0: none)
+    uint32_t _current_uniforms = 0;
+
+    // counters of the pending flush
+    int _num_draws = 0;
+    int _num_dropped = 0;
+
+    // instances appended to the stream buffer this frame
+    uint64_t _frame = ~0ull;
+    int _frame_instances = 0;
+
+    // statistics
+    instance_batch_stats _stats{};
+};
+
+} // namespace falcon::gfx
+
+#endif // FALCON_INSTANCE_BATCH_H_
@@ -0,0 +1,123 @@
+#include "job_system.h"
+
+#include <algorithm>
+
+namespace falcon {
+
+void job_system::setup(int num_threads) {
+    shutdown();
+
+    if (num_threads <= 0) {
+        num_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+    }
+
+    _running = true;
+    _threads.reserve(num_threads);
+    for (int i = 0; i < num_threads; i++) {
+        _threads.emplace_back([this] { worker(); });
+    }
+}
+
+void job_system::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _running = false;
+    }
+    _condition.notify_all();
+    for (auto &thread : _threads) {
+        thread.join();
+    }
+    _threads.clear();
+
+    // run whatever is left on this thread
+    while (run_one()) {}
+}
+
+void job_system::submit(std::function<void()> fn, job_counter *counter) {
+    if (counter) {
+        counter->value.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // no workers: run inline
+    if (_threads.empty()) {
+        job j{ std::move(fn), counter };
+        execute(j);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _queue.push_back({ std::move(fn), counter });
+    }
+    _condition.notify_one();
+}
+
+void job_system::wait(job_counter &counter) {
+    while (!counter.done()) {
+        if (!run_one()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void job_system::parallel_for(int count, int chunk_size, const std::function<void(int, int)> &fn) {
+    if (count <= 0) {
+        return;
+    }
+    chunk_size = std::max(1, chunk_size);
+    if (count <= chunk_size || _threads.empty()) {
+        fn(0, count);
+        return;
+    }
+
+    job_counter counter;
+    for (int begin = chunk_size; begin < count; begin += chunk_size) {
+        const int end = std::min(count, begin + chunk_size);
+        submit([&fn, begin, end] { fn(begin, end); }, &counter);
+    }
+
+    // first chunk on the calling thread
+    fn(0, std::min(count, chunk_size));
+    wait(counter);
+}
+
+void job_system::worker() {
+    for (;;) {
+        job j;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this] { return !_running || !_queue.empty(); });
+            if (_queue.empty()) {
+                return;
+            }
+            j = std::move(_queue.front());
+            _queue.pop_front();
+        }
+        execute(j);
+    }
+}
+
+bool job_system::run_one() {
+    job j;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_queue.empty()) {
+            return false;
+        }
+        j = std::move(_queue.front());
+        _queue.pop_front();
+    }
+    execute(j);
+    return true;
+}
+
+void job_system::execute(job &j) {
+    if (j.fn) {
+        j.fn();
+    }
+    if (j.counter) {
+        j.counter->value.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+} // namespace falcon
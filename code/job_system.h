@@ -0,0 +1,83 @@
+#ifndef FALCON_JOB_SYSTEM_H_
+#define FALCON_JOB_SYSTEM_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace falcon {
+
+// counter of unfinished jobs
+struct job_counter {
+    std::atomic<int> value{ 0 };
+
+    // check completion
+    inline bool done() const { return value.load(std::memory_order_acquire) == 0; }
+};
+
+// worker thread pool
+//
+// waiting threads execute queued jobs instead of blocking, so jobs may submit
+// and wait for other jobs.
+class job_system {
+public:
+    // ctor
+    job_system() = default;
+
+    // dtor
+    ~job_system() { shutdown(); }
+
+    job_system(const job_system &) = delete;
+    job_system &operator=(const job_system &) = delete;
+
+    // start worker threads (0: one less than hardware threads)
+    void setup(int num_threads = 0);
+
+    // stop worker threads, queued jobs are executed first
+    void shutdown();
+
+    // queue a job, counter is decremented when it finished
+    void submit(std::function<void()> job, job_counter *counter = nullptr);
+
+    // wait until counter reaches zero
+    void wait(job_counter &counter);
+
+    // run fn(begin, end) over [0, count) in chunks and wait
+    void parallel_for(int count, int chunk_size, const std::function<void(int, int)> &fn);
+
+    // get number of worker threads
+    inline int num_threads() const { return static_cast<int>(_threads.size()); }
+
+private:
+    // queued job
+    struct job {
+        std::function<void()> fn;
+        job_counter *counter;
+    };
+
+    // worker thread main
+    void worker();
+
+    // pop and run one job if any
+    bool run_one();
+
+    // run job and signal counter
+    static void execute(job &j);
+
+    // workers
+    std::vector<std::thread> _threads;
+
+    // queue
+    std::deque<job> _queue;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    bool _running = false;
+};
+
+} // namespace falcon
+
+#endif // FALCON_JOB_SYSTEM_H_
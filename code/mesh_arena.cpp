@@ -0,0 +1,348 @@
+#include "mesh_arena.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// handle layout
+constexpr uint32_t slot_bits = 16;
+constexpr uint32_t slot_mask = (1u << slot_bits) - 1;
+
+inline uint32_t make_id(uint32_t index, uint16_t generation) {
+    return (static_cast<uint32_t>(generation) << slot_bits) | ((index + 1) & slot_mask);
+}
+
+} // namespace
+
+namespace falcon::gfx {
+
+void mesh_arena::setup(const mesh_arena_desc &desc) {
+    shutdown();
+
+    _desc = desc;
+    if (_desc.index_type != SG_INDEXTYPE_UINT32) {
+        _desc.index_type = SG_INDEXTYPE_UINT16;
+        _desc.max_vertices = std::min(_desc.max_vertices, 0x10000);
+    }
+
+    // shadow copies
+    _vertices.assign(static_cast<size_t>(_desc.max_vertices) * _desc.vertex_stride, 0);
+    _indices.assign(static_cast<size_t>(_desc.max_indices) * index_size(), 0);
+
+    // everything is free
+    _free_vertices.push_back({ 0, _desc.max_vertices });
+    _free_indices.push_back({ 0, _desc.max_indices });
+
+    // dynamic buffers, rewritten by flush()
+    {
+        sg_buffer_desc buffer_desc{};
+        buffer_desc.type = SG_BUFFERTYPE_VERTEXBUFFER;
+        buffer_desc.usage = SG_USAGE_DYNAMIC;
+        buffer_desc.size = static_cast<int>(_vertices.size());
+        buffer_desc.label = _desc.label;
+        _vertex_buffer = sg_make_buffer(&buffer_desc);
+    }
+    {
+        sg_buffer_desc buffer_desc{};
+        buffer_desc.type = SG_BUFFERTYPE_INDEXBUFFER;
+        buffer_desc.usage = SG_USAGE_DYNAMIC;
+        buffer_desc.size = static_cast<int>(_indices.size());
+        buffer_desc.label = _desc.label;
+        _index_buffer = sg_make_buffer(&buffer_desc);
+    }
+}
+
+void mesh_arena::shutdown() {
+    if (_vertex_buffer.id != SG_INVALID_ID) {
+        sg_destroy_buffer(_vertex_buffer);
+        _vertex_buffer = {};
+    }
+    if (_index_buffer.id != SG_INVALID_ID) {
+        sg_destroy_buffer(_index_buffer);
+        _index_buffer = {};
+    }
+    _vertices.clear();
+    _indices.clear();
+    _free_vertices.clear();
+    _free_indices.clear();
+    _slots.clear();
+    _free_slots.clear();
+    _dirty = false;
+    _stats = {};
+}
+
+mesh mesh_arena::alloc(const void *vertices, int num_vertices, const void *indices, int num_indices) {
+    if (!vertices || !indices || (num_vertices <= 0) || (num_indices <= 0)) {
+        return {};
+    }
+
+    // find space, defragment once if the free spans are too small
+    int base_vertex = alloc_span(_free_vertices, num_vertices);
+    int base_element = (base_vertex >= 0) ? alloc_span(_free_indices, num_indices) : -1;
+    if (base_element < 0) {
+        if (base_vertex >= 0) {
+            free_span(_free_vertices, base_vertex, num_vertices);
+        }
+        if ((_desc.max_vertices - _stats.used_vertices < num_vertices)
+            || (_desc.max_indices - _stats.used_indices < num_indices)) {
+            return {};
+        }
+        compact();
+        base_vertex = alloc_span(_free_vertices, num_vertices);
+        base_element = alloc_span(_free_indices, num_indices);
+        if ((base_vertex < 0) || (base_element < 0)) {
+            return {};
+        }
+    }
+
+    // get a slot
+    uint32_t index = 0;
+    if (!_free_slots.empty()) {
+        index = _free_slots.back();
+        _free_slots.pop_back();
+    }
+    else if (_slots.size() < slot_mask) {
+        index = static_cast<uint32_t>(_slots.size());
+        _slots.push_back({});
+    }
+    else {
+        free_span(_free_vertices, base_vertex, num_vertices);
+        free_span(_free_indices, base_element, num_indices);
+        return {};
+    }
+
+    auto &s = _slots[index];
+    s.generation = static_cast<uint16_t>(s.generation + 1);
+    if (s.generation == 0) s.generation = 1;
+    s.used = true;
+    s.range = { base_vertex, num_vertices, base_element, num_indices };
+
+    // copy data to shadow
+    std::memcpy(
+        &_vertices[static_cast<size_t>(base_vertex) * _desc.vertex_stride],
+        vertices,
+        static_cast<size_t>(num_vertices) * _desc.vertex_stride
+    );
+    write_indices(base_element, indices, num_indices, base_vertex);
+    _dirty = true;
+
+    _stats.num_meshes++;
+    _stats.used_vertices += num_vertices;
+    _stats.used_indices += num_indices;
+    _stats.free_vertex_spans = static_cast<int>(_free_vertices.size());
+    _stats.free_index_spans = static_cast<int>(_free_indices.size());
+
+    return { make_id(index, s.generation) };
+}
+
+void mesh_arena::free(mesh m) {
+    auto *s = const_cast<slot *>(lookup(m));
+    if (!s) {
+        return;
+    }
+    free_span(_free_vertices, s->range.base_vertex, s->range.num_vertices);
+    free_span(_free_indices, s->range.base_element, s->range.num_elements);
+
+    _stats.num_meshes--;
+    _stats.used_vertices -= s->range.num_vertices;
+    _stats.used_indices -= s->range.num_elements;
+    _stats.free_vertex_spans = static_cast<int>(_free_vertices.size());
+    _stats.free_index_spans = static_cast<int>(_free_indices.size());
+
+    s->used = false;
+    s->range = {};
+    _free_slots.push_back(static_cast<uint32_t>(s - _slots.data()));
+}
+
+bool mesh_arena::valid(mesh m) const {
+    return lookup(m) != nullptr;
+}
+
+mesh_range mesh_arena::range(mesh m) const {
+    if (auto *s = lookup(m)) {
+        return s->range;
+    }
+    return {};
+}
+
+void mesh_arena::compact() {
+    std::vector<slot *> live;
+    live.reserve(_slots.size());
+    for (auto &s : _slots) {
+        if (s.used) live.push_back(&s);
+    }
+
+    // slide vertices down, fix up the indices referencing them
+    std::sort(live.begin(), live.end(), [](auto *a, auto *b) {
+        return a->range.base_vertex < b->range.base_vertex;
+    });
+    int vertex_offset = 0;
+    for (auto *s : live) {
+        auto &r = s->range;
+        if (r.base_vertex != vertex_offset) {
+            std::memmove(
+                &_vertices[static_cast<size_t>(vertex_offset) * _desc.vertex_stride],
+                &_vertices[static_cast<size_t>(r.base_vertex) * _desc.vertex_stride],
+                static_cast<size_t>(r.num_vertices) * _desc.vertex_stride
+            );
+            rebase_indices(r.base_element, r.num_elements, vertex_offset - r.base_vertex);
+            r.base_vertex = vertex_offset;
+        }
+        vertex_offset += r.num_vertices;
+    }
+
+    // slide indices down
+    std::sort(live.begin(), live.end(), [](auto *a, auto *b) {
+        return a->range.base_element < b->range.base_element;
+    });
+    int index_offset = 0;
+    for (auto *s : live) {
+        auto &r = s->range;
+        if (r.base_element != index_offset) {
+            std::memmove(
+                &_indices[static_cast<size_t>(index_offset) * index_size()],
+                &_indices[static_cast<size_t>(r.base_element) * index_size()],
+                static_cast<size_t>(r.num_elements) * index_size()
+            );
+            r.base_element = index_offset;
+        }
+        index_offset += r.num_elements;
+    }
+
+    // one free span at the tail
+    _free_vertices.clear();
+    if (vertex_offset < _desc.max_vertices) {
+        _free_vertices.push_back({ vertex_offset, _desc.max_vertices - vertex_offset });
+    }
+    _free_indices.clear();
+    if (index_offset < _desc.max_indices) {
+        _free_indices.push_back({ index_offset, _desc.max_indices - index_offset });
+    }
+
+    _dirty = true;
+    _stats.num_compactions++;
+    _stats.free_vertex_spans = static_cast<int>(_free_vertices.size());
+    _stats.free_index_spans = static_cast<int>(_free_indices.size());
+}
+
+void mesh_arena::flush() {
+    if (!_dirty) {
+        return;
+    }
+
+    // dynamic buffers can only be updated once per frame and always from the start,
+    // so only the part up to the last used element is uploaded
+    const int vertex_bytes = used_end(_free_vertices, _desc.max_vertices) * _desc.vertex_stride;
+    const int index_bytes = used_end(_free_indices, _desc.max_indices) * index_size();
+    if (vertex_bytes > 0) {
+        sg_update_buffer(_vertex_buffer, _vertices.data(), vertex_bytes);
+    }
+    if (index_bytes > 0) {
+        sg_update_buffer(_index_buffer, _indices.data(), index_bytes);
+    }
+
+    _dirty = false;
+    _stats.num_uploads++;
+    _stats.uploaded_bytes += vertex_bytes + index_bytes;
+}
+
+void mesh_arena::apply(sg_bindings &bindings, int vertex_buffer_slot) const {
+    bindings.vertex_buffers[vertex_buffer_slot] = _vertex_buffer;
+    bindings.vertex_buffer_offsets[vertex_buffer_slot] = 0;
+    bindings.index_buffer = _index_buffer;
+    bindings.index_buffer_offset = 0;
+}
+
+void mesh_arena::draw(mesh m, int num_instances) const {
+    if (auto *s = lookup(m)) {
+        sg_draw(s->range.base_element, s->range.num_elements, num_instances);
+    }
+}
+
+int mesh_arena::alloc_span(std::vector<span> &spans, int count) {
+    for (auto it = spans.begin(); it != spans.end(); ++it) {
+        if (it->count >= count) {
+            const int offset = it->offset;
+            it->offset += count;
+            it->count -= count;
+            if (it->count == 0) {
+                spans.erase(it);
+            }
+            return offset;
+        }
+    }
+    return -1;
+}
+
+void mesh_arena::free_span(std::vector<span> &spans, int offset, int count) {
+    auto it = std::lower_bound(spans.begin(), spans.end(), offset, [](const span &s, int offset) {
+        return s.offset < offset;
+    });
+    it = spans.insert(it, { offset, count });
+
+    // merge with next
+    if ((it + 1) != spans.end() && (it->offset + it->count) == (it + 1)->offset) {
+        it->count += (it + 1)->count;
+        spans.erase(it + 1);
+    }
+
+    // merge with previous
+    if (it != spans.begin() && ((it - 1)->offset + (it - 1)->count) == it->offset) {
+        (it - 1)->count += it->count;
+        spans.erase(it);
+    }
+}
+
+int mesh_arena::used_end(const std::vector<span> &spans, int capacity) {
+    if (!spans.empty() && (spans.back().offset + spans.back().count) == capacity) {
+        return spans.back().offset;
+    }
+    return capacity;
+}
+
+const mesh_arena::slot *mesh_arena::lookup(mesh m) const {
+    const uint32_t index = (m.id & slot_mask);
+    if (index == 0 || index > _slots.size()) {
+        return nullptr;
+    }
+    const auto &s = _slots[index - 1];
+    if (!s.used || s.generation != (m.id >> slot_bits)) {
+        return nullptr;
+    }
+    return &s;
+}
+
+void mesh_arena::write_indices(int base_element, const void *indices, int num_indices, int base_vertex) {
+    if (_desc.index_type == SG_INDEXTYPE_UINT32) {
+        auto *src = static_cast<const uint32_t *>(indices);
+        auto *dst = reinterpret_cast<uint32_t *>(_indices.data()) + base_element;
+        for (int i = 0; i < num_indices; i++) {
+            dst[i] = src[i] + static_cast<uint32_t>(base_vertex);
+        }
+    }
+    else {
+        auto *src = static_cast<const uint16_t *>(indices);
+        auto *dst = reinterpret_cast<uint16_t *>(_indices.data()) + base_element;
+        for (int i = 0; i < num_indices; i++) {
+            dst[i] = static_cast<uint16_t>(src[i] + base_vertex);
+        }
+    }
+}
+
+void mesh_arena::rebase_indices(int base_element, int num_elements, int delta) {
+    if (_desc.index_type == SG_INDEXTYPE_UINT32) {
+        auto *p = reinterpret_cast<uint32_t *>(_indices.data()) + base_element;
+        for (int i = 0; i < num_elements; i++) {
+            p[i] = static_cast<uint32_t>(static_cast<int64_t>(p[i]) + delta);
+        }
+    }
+    else {
+        auto *p = reinterpret_cast<uint16_t *>(_indices.data()) + base_element;
+        for (int i = 0; i < num_elements; i++) {
+            p[i] = static_cast<uint16_t>(p[i] + delta);
+        }
+    }
+}
+
+} // namespace falcon::gfx
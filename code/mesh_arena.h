@@ -0,0 +1,182 @@
+#ifndef FALCON_MESH_ARENA_H_
+#define FALCON_MESH_ARENA_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "sokol_gfx.h"
+
+namespace falcon::gfx {
+
+// mesh handle (slot index + generation, 0 is invalid)
+struct mesh {
+    uint32_t id;
+};
+
+// mesh location inside the shared arena buffers
+struct mesh_range {
+    // first vertex in the shared vertex buffer
+    int base_vertex;
+
+    // number of vertices
+    int num_vertices;
+
+    // first index in the shared index buffer (pass to draw as base_element)
+    int base_element;
+
+    // number of indices
+    int num_elements;
+};
+
+// mesh arena description
+struct mesh_arena_desc {
+    // size of one vertex in bytes
+    int vertex_stride = 0;
+
+    // vertex capacity
+    int max_vertices = 0;
+
+    // index capacity
+    int max_indices = 0;
+
+    // index type (UINT16 limits the arena to 65536 vertices)
+    sg_index_type index_type = SG_INDEXTYPE_UINT16;
+
+    // debug label
+    const char *label = nullptr;
+};
+
+// mesh arena statistics
+struct mesh_arena_stats {
+    int num_meshes;
+    int used_vertices;
+    int used_indices;
+    int free_vertex_spans;
+    int free_index_spans;
+    int num_compactions;
+    int num_uploads;
+    int uploaded_bytes;
+};
+
+// suballocator packing many meshes into one vertex buffer and one index buffer
+//
+// indices are rebased to absolute vertex indices when the mesh is added,
+// so every mesh in the arena is drawn with the same bindings and only
+// base_element/num_elements change per draw.
+class mesh_arena {
+public:
+    // ctor
+    mesh_arena() = default;
+
+    // dtor
+    ~mesh_arena() { shutdown(); }
+
+    mesh_arena(const mesh_arena &) = delete;
+    mesh_arena &operator=(const mesh_arena &) = delete;
+
+    // create the shared buffers
+    void setup(const mesh_arena_desc &desc);
+
+    // destroy the shared buffers and drop all meshes
+    void shutdown();
+
+    // add a mesh (indices are relative to the first of its vertices, same type as the arena)
+    mesh alloc(const void *vertices, int num_vertices, const void *indices, int num_indices);
+
+    // release a mesh
+    void free(mesh m);
+
+    // check mesh handle
+    bool valid(mesh m) const;
+
+    // get mesh location
+    mesh_range range(mesh m) const;
+
+    // move all live meshes to the front of the buffers
+    void compact();
+
+    // upload pending changes (call once per frame before drawing)
+    void flush();
+
+    // set shared vertex/index buffers on bindings
+    void apply(sg_bindings &bindings, int vertex_buffer_slot = 0) const;
+
+    // draw a mesh with the currently applied pipeline and bindings
+    void draw(mesh m, int num_instances = 1) const;
+
+    // get shared vertex buffer
+    inline sg_buffer vertex_buffer() const { return _vertex_buffer; }
+
+    // get shared index buffer
+    inline sg_buffer index_buffer() const { return _index_buffer; }
+
+    // get index type
+    inline sg_index_type index_type() const { return _desc.index_type; }
+
+    // get statistics
+    inline const mesh_arena_stats &stats() const { return _stats; }
+
+private:
+    // free span of elements
+    struct span {
+        int offset;
+        int count;
+    };
+
+    // mesh slot
+    struct slot {
+        uint16_t generation;
+        bool used;
+        mesh_range range;
+    };
+
+    // first-fit allocation from a free list
+    static int alloc_span(std::vector<span> &spans, int count);
+
+    // return a span to a free list and merge neighbours
+    static void free_span(std::vector<span> &spans, int offset, int count);
+
+    // size of one index in bytes
+    inline int index_size() const { return _desc.index_type == SG_INDEXTYPE_UINT32 ? 4 : 2; }
+
+    // end of the used part of a free-list managed range
+    static int used_end(const std::vector<span> &spans, int capacity);
+
+    // find slot from handle
+    const slot *lookup(mesh m) const;
+
+    // add rebased indices to shadow copy
+    void write_indices(int base_element, const void *indices, int num_indices, int base_vertex);
+
+    // shift indices of a range by vertex delta
+    void rebase_indices(int base_element, int num_elements, int delta);
+
+    // description
+    mesh_arena_desc _desc;
+
+    // shared buffers
+    sg_buffer _vertex_buffer{};
+    sg_buffer _index_buffer{};
+
+    // CPU shadow copies (dynamic buffers are rewritten as a whole)
+    std::vector<uint8_t> _vertices;
+    std::vector<uint8_t> _indices;
+
+    // free lists sorted by offset
+    std::vector<span> _free_vertices;
+    std::vector<span> _free_indices;
+
+    // mesh slots
+    std::vector<slot> _slots;
+    std::vector<uint32_t> _free_slots;
+
+    // pending upload
+    bool _dirty = false;
+
+    // statistics
+    mesh_arena_stats _stats{};
+};
+
+} // namespace falcon::gfx
+
+#endif // FALCON_MESH_ARENA_H_
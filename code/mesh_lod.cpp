@@ -0,0 +1,336 @@
+#include "mesh_lod.h"
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+#include <unordered_map>
+
+namespace {
+
+using falcon::math::vec3;
+
+// symmetric 4x4 error quadric with accumulated weight
+struct quadric {
+    double xx, xy, xz, yy, yz, zz, x, y, z, c, w;
+};
+
+void add_plane(quadric &q, const vec3 &n, float d, double weight) {
+    q.xx += weight * n.x * n.x;
+    q.xy += weight * n.x * n.y;
+    q.xz += weight * n.x * n.z;
+    q.yy += weight * n.y * n.y;
+    q.yz += weight * n.y * n.z;
+    q.zz += weight * n.z * n.z;
+    q.x += weight * n.x * d;
+    q.y += weight * n.y * d;
+    q.z += weight * n.z * d;
+    q.c += weight * d * d;
+    q.w += weight;
+}
+
+void add(quadric &a, const quadric &b) {
+    a.xx += b.xx; a.xy += b.xy; a.xz += b.xz;
+    a.yy += b.yy; a.yz += b.yz; a.zz += b.zz;
+    a.x += b.x; a.y += b.y; a.z += b.z;
+    a.c += b.c; a.w += b.w;
+}
+
+// mean squared distance of p to the planes of the quadric
+double evaluate(const quadric &q, const vec3 &p) {
+    const double e = q.xx * p.x * p.x + 2.0 * q.xy * p.x * p.y + 2.0 * q.xz * p.x * p.z +
+                     q.yy * p.y * p.y + 2.0 * q.yz * p.y * p.z + q.zz * p.z * p.z +
+                     2.0 * (q.x * p.x + q.y * p.y + q.z * p.z) + q.c;
+    return std::max(0.0, e) / std::max(q.w, 1e-12);
+}
+
+// collapse candidate
+struct collapse {
+    double cost;
+    uint32_t from;
+    uint32_t to;
+};
+
+inline uint64_t edge_key(uint32_t a, uint32_t b) {
+    return (a < b) ? (static_cast<uint64_t>(a) << 32 | b) : (static_cast<uint64_t>(b) << 32 | a);
+}
+
+} // namespace
+
+namespace falcon::gfx {
+
+float simplify(const float *positions, int stride, int num_vertices,
+               const uint32_t *indices, int num_indices,
+               int target_indices, float target_error,
+               std::vector<uint32_t> &out) {
+    out.assign(indices, indices + num_indices / 3 * 3);
+    if (num_vertices <= 0 || static_cast<int>(out.size()) <= target_indices) {
+        return 0.f;
+    }
+
+    std::vector<vec3> pos(num_vertices);
+    for (int v = 0; v < num_vertices; v++) {
+        const float *p = reinterpret_cast<const float *>(reinterpret_cast<const uint8_t *>(positions) + static_cast<size_t>(v) * stride);
+        pos[v] = { p[0], p[1], p[2] };
+    }
+
+    // errors are relative to the bounding sphere radius (half the box diagonal)
+    vec3 lo = pos[0], hi = pos[0];
+    for (const auto &p : pos) {
+        lo = { std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z) };
+        hi = { std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z) };
+    }
+    const double radius = std::max(1e-6f, math::length(hi - lo) * .5f);
+    const double max_cost = (target_error * radius) * (target_error * radius);
+
+    // lock seam vertices (shared position) and border vertices (edge used once)
+    std::vector<uint8_t> locked(num_vertices, 0);
+    {
+        std::vector<uint32_t> order(num_vertices);
+        for (int v = 0; v < num_vertices; v++) {
+            order[v] = static_cast<uint32_t>(v);
+        }
+        auto less = [&pos](uint32_t a, uint32_t b) {
+            return std::tie(pos[a].x, pos[a].y, pos[a].z) < std::tie(pos[b].x, pos[b].y, pos[b].z);
+        };
+        std::sort(order.begin(), order.end(), less);
+        for (int i = 1; i < num_vertices; i++) {
+            if (!less(order[i - 1], order[i])) {
+                locked[order[i - 1]] = 1;
+                locked[order[i]] = 1;
+            }
+        }
+
+        std::unordered_map<uint64_t, int> edges;
+        edges.reserve(out.size());
+        for (size_t i = 0; i < out.size(); i += 3) {
+            for (int e = 0; e < 3; e++) {
+                edges[edge_key(out[i + e], out[i + (e + 1) % 3])]++;
+            }
+        }
+        for (const auto &[key, count] : edges) {
+            if (count == 1) {
+                locked[key >> 32] = 1;
+                locked[key & 0xFFFFFFFFu] = 1;
+            }
+        }
+    }
+
+    // area weighted plane quadrics
+    std::vector<quadric> quadrics(num_vertices, quadric{});
+    for (size_t i = 0; i < out.size(); i += 3) {
+        const vec3 &a = pos[out[i]], &b = pos[out[i + 1]], &c = pos[out[i + 2]];
+        const vec3 n = math::cross(b - a, c - a);
+        const float area = math::length(n);
+        if (area <= 0.f) {
+            continue;
+        }
+        const vec3 unit = n * (1.f / area);
+        const float d = -math::dot(unit, a);
+        for (int k = 0; k < 3; k++) {
+            add_plane(quadrics[out[i + k]], unit, d, area * .5);
+        }
+    }
+
+    std::vector<uint32_t> remap(num_vertices);
+    std::vector<uint8_t> touched(num_vertices);
+    std::vector<int> adjacency_offset(num_vertices + 1);
+    std::vector<int> adjacency;
+    std::vector<uint64_t> edges;
+    std::vector<collapse> candidates;
+    double error = 0.0;
+
+    while (static_cast<int>(out.size()) > target_indices) {
+        const int num_triangles = static_cast<int>(out.size() / 3);
+
+        // triangles around each vertex
+        std::fill(adjacency_offset.begin(), adjacency_offset.end(), 0);
+        for (const uint32_t v : out) {
+            adjacency_offset[v + 1]++;
+        }
+        for (int v = 0; v < num_vertices; v++) {
+            adjacency_offset[v + 1] += adjacency_offset[v];
+        }
+        adjacency.resize(out.size());
+        {
+            std::vector<int> cursor(adjacency_offset.begin(), adjacency_offset.end() - 1);
+            for (int t = 0; t < num_triangles; t++) {
+                for (int k = 0; k < 3; k++) {
+                    adjacency[cursor[out[t * 3 + k]]++] = t;
+                }
+            }
+        }
+
+        // cheapest direction of every edge
+        edges.clear();
+        for (int t = 0; t < num_triangles; t++) {
+            for (int k = 0; k < 3; k++) {
+                edges.push_back(edge_key(out[t * 3 + k], out[t * 3 + (k + 1) % 3]));
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+        candidates.clear();
+        for (const uint64_t e : edges) {
+            const uint32_t a = static_cast<uint32_t>(e >> 32), b = static_cast<uint32_t>(e & 0xFFFFFFFFu);
+            quadric q = quadrics[a];
+            add(q, quadrics[b]);
+            const double to_b = locked[a] ? 1e300 : evaluate(q, pos[b]);
+            const double to_a = locked[b] ? 1e300 : evaluate(q, pos[a]);
+            if (to_b <= to_a && to_b <= max_cost) {
+                candidates.push_back({ to_b, a, b });
+            } else if (to_a < to_b && to_a <= max_cost) {
+                candidates.push_back({ to_a, b, a });
+            }
+        }
+        if (candidates.empty()) {
+            break;
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const collapse &l, const collapse &r) { return l.cost < r.cost; });
+
+        // collapse independent edges, cheapest first
+        for (int v = 0; v < num_vertices; v++) {
+            remap[v] = static_cast<uint32_t>(v);
+        }
+        std::fill(touched.begin(), touched.end(), 0);
+        int removed = 0;
+        const int needed = (static_cast<int>(out.size()) - target_indices) / 3;
+        for (const auto &c : candidates) {
+            if (removed >= needed) {
+                break;
+            }
+            if (touched[c.from] || touched[c.to]) {
+                continue;
+            }
+
+            // reject collapses that flip a triangle
+            bool flips = false;
+            int collapsed = 0;
+            for (int k = adjacency_offset[c.from]; k < adjacency_offset[c.from + 1] && !flips; k++) {
+                const uint32_t *tri = &out[adjacency[k] * 3];
+                if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) {
+                    collapsed++;
+                    continue;
+                }
+                vec3 p[3], q[3];
+                for (int j = 0; j < 3; j++) {
+                    p[j] = pos[tri[j]];
+                    q[j] = (tri[j] == c.from) ? pos[c.to] : p[j];
+                }
+                const vec3 before = math::cross(p[1] - p[0], p[2] - p[0]);
+                const vec3 after = math::cross(q[1] - q[0], q[2] - q[0]);
+                flips = math::dot(before, after) <= 0.f;
+            }
+            if (flips) {
+                continue;
+            }
+
+            // lock the neighbourhood for this pass
+            for (int k = adjacency_offset[c.from]; k < adjacency_offset[c.from + 1]; k++) {
+                const uint32_t *tri = &out[adjacency[k] * 3];
+                touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = 1;
+            }
+            remap[c.from] = c.to;
+            add(quadrics[c.to], quadrics[c.from]);
+            error = std::max(error, c.cost);
+            removed += collapsed;
+        }
+        if (removed == 0) {
+            break;
+        }
+
+        // apply collapses and drop degenerate triangles
+        size_t n = 0;
+        for (size_t i = 0; i < out.size(); i += 3) {
+            const uint32_t a = remap[out[i]], b = remap[out[i + 1]], c = remap[out[i + 2]];
+            if (a != b && b != c && c != a) {
+                out[n++] = a;
+                out[n++] = b;
+                out[n++] = c;
+            }
+        }
+        out.resize(n);
+    }
+
+    return static_cast<float>(std::sqrt(error) / radius);
+}
+
+lod_mesh build_lods(const float *positions, int stride, int num_vertices,
+                    const uint32_t *indices, int num_indices,
+                    const lod_build_desc &desc, std::vector<uint32_t> &out_indices) {
+    lod_mesh mesh;
+    const int base = static_cast<int>(out_indices.size());
+    num_indices = num_indices / 3 * 3;
+    out_indices.insert(out_indices.end(), indices, indices + num_indices);
+    mesh.levels.push_back({ 0, num_indices, 0.f });
+
+    // every level is simplified from the original, so errors do not accumulate
+    std::vector<uint32_t> level;
+    for (int i = 1; i < desc.max_levels; i++) {
+        const int previous = mesh.levels.back().num_elements;
+        const int target = static_cast<int>(previous * desc.ratio) / 3 * 3;
+        const float error = simplify(positions, stride, num_vertices, indices, num_indices, target, desc.max_error, level);
+        if (level.empty() || static_cast<int>(level.size()) > previous * 9 / 10) {
+            break;
+        }
+        mesh.levels.push_back({ static_cast<int>(out_indices.size()) - base, static_cast<int>(level.size()), error });
+        out_indices.insert(out_indices.end(), level.begin(), level.end());
+    }
+    return mesh;
+}
+
+void lod_selector::setup(const lod_selector_desc &desc) {
+    _desc = desc;
+    _desc.max_pixel_error = std::max(1e-3f, _desc.max_pixel_error);
+    _desc.hysteresis = std::max(0.f, _desc.hysteresis);
+    _levels.clear();
+    _stats = {};
+}
+
+void lod_selector::begin(const math::vec3 &eye, float fov_y, int viewport_height) {
+    _eye = eye;
+    _pixels_per_unit = (viewport_height * .5f) / std::tan(math::radians(fov_y) * .5f);
+    _stats = {};
+}
+
+int lod_selector::coarsest(const lod_mesh &mesh, float size, float limit) {
+    for (int i = static_cast<int>(mesh.levels.size()) - 1; i > 0; i--) {
+        if (mesh.levels[i].error * size <= limit) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+int lod_selector::select(uint32_t id, const lod_mesh &mesh, const math::vec3 &center, float radius) {
+    if (mesh.levels.empty()) {
+        return 0;
+    }
+    if (id >= _levels.size()) {
+        _levels.resize(id + 1, 0xFF);
+    }
+
+    // projected radius in pixels
+    const float distance = math::length(center - _eye) - radius;
+    const float size = (distance > 0.f) ? radius * _pixels_per_unit / distance : 1e30f;
+
+    const float limit = _desc.max_pixel_error;
+    int level = _levels[id];
+    if (level == 0xFF || level >= static_cast<int>(mesh.levels.size())) {
+        level = coarsest(mesh, size, limit);
+    } else {
+        // switch only when leaving the hysteresis band
+        const int strict = coarsest(mesh, size, limit / (1.f + _desc.hysteresis));
+        const int loose = coarsest(mesh, size, limit * (1.f + _desc.hysteresis));
+        const int previous = level;
+        level = std::clamp(level, strict, loose);
+        _stats.num_switches += (level != previous) ? 1 : 0;
+    }
+    _levels[id] = static_cast<uint8_t>(level);
+
+    _stats.num_objects++;
+    _stats.full_triangles += mesh.levels[0].num_elements / 3;
+    _stats.drawn_triangles += mesh.levels[level].num_elements / 3;
+    return level;
+}
+
+} // namespace falcon::gfx
@@ -0,0 +1,119 @@
+#ifndef FALCON_MESH_LOD_H_
+#define FALCON_MESH_LOD_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "vecmath.h"
+
+namespace falcon::gfx {
+
+// simplify a triangle list with quadric error metrics
+//
+// vertices are collapsed onto neighbouring vertices, so the result indexes
+// the same vertex buffer. vertices sharing a position with another vertex
+// (uv or normal seams) and open borders are kept. stops at target_indices or
+// when the next collapse would exceed target_error (relative to the bounding
+// sphere radius of the mesh). returns the reached relative error.
+float simplify(const float *positions, int stride, int num_vertices,
+               const uint32_t *indices, int num_indices,
+               int target_indices, float target_error,
+               std::vector<uint32_t> &out);
+
+// one detail level inside a shared index buffer
+struct lod_level {
+    // first index and index count relative to the mesh's indices
+    int base_element;
+    int num_elements;
+
+    // geometric error relative to the bounding sphere radius
+    float error;
+};
+
+// detail levels of one mesh, finest first
+struct lod_mesh {
+    std::vector<lod_level> levels;
+};
+
+// lod build description
+struct lod_build_desc {
+    // maximum number of levels including the original
+    int max_levels = 5;
+
+    // index count of each level relative to the previous one
+    float ratio = .5f;
+
+    // largest relative error of the coarsest level
+    float max_error = .05f;
+};
+
+// append all levels of a mesh to out_indices (level 0 is the original), so the
+// whole chain can be put into one index buffer or one mesh_arena allocation
+lod_mesh build_lods(const float *positions, int stride, int num_vertices,
+                    const uint32_t *indices, int num_indices,
+                    const lod_build_desc &desc, std::vector<uint32_t> &out_indices);
+
+// lod selector description
+struct lod_selector_desc {
+    // largest tolerated error on screen in pixels
+    float max_pixel_error = 1.f;
+
+    // relative band around a switch threshold in which the current level is kept
+    float hysteresis = .15f;
+};
+
+// lod selector statistics (since begin)
+struct lod_selector_stats {
+    int num_objects;
+    int num_switches;
+    int64_t full_triangles;
+    int64_t drawn_triangles;
+};
+
+// per-object level selection by projected screen size
+//
+// the coarsest level whose error, scaled to the projected size of the
+// object's bounding sphere, stays below max_pixel_error is selected. levels
+// only change once the size leaves the hysteresis band around a threshold,
+// so objects near a threshold do not pop between levels every frame.
+class lod_selector {
+public:
+    // ctor
+    lod_selector() = default;
+
+    lod_selector(const lod_selector &) = delete;
+    lod_selector &operator=(const lod_selector &) = delete;
+
+    // set thresholds and drop object state
+    void setup(const lod_selector_desc &desc);
+
+    // start a frame with the camera (vertical fov in degrees, viewport height in pixels)
+    void begin(const math::vec3 &eye, float fov_y, int viewport_height);
+
+    // select the level of an object by its bounding sphere (ids are chosen by the caller)
+    int select(uint32_t id, const lod_mesh &mesh, const math::vec3 &center, float radius);
+
+    // get statistics
+    inline const lod_selector_stats &stats() const { return _stats; }
+
+private:
+    // coarsest level with error * size <= limit
+    static int coarsest(const lod_mesh &mesh, float size, float limit);
+
+    // description
+    lod_selector_desc _desc;
+
+    // camera
+    math::vec3 _eye = { 0.f, 0.f, 0.f };
+    float _pixels_per_unit = 1.f;
+
+    // current level per object
+    std::vector<uint8_t> _levels;
+
+    // statistics
+    lod_selector_stats _stats{};
+};
+
+} // namespace falcon::gfx
+
+#endif // FALCON_MESH_LOD_H_
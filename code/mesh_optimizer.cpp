@@ -0,0 +1,349 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+
+#include "vecmath.h"
+
+namespace {
+
+using falcon::gfx::vertex_cache_stats;
+using falcon::math::vec3;
+
+// FIFO post-transform cache, a vertex is cached while fewer than size
+// vertices were transformed after it
+class fifo_cache {
+public:
+    fifo_cache(int num_vertices, int size) : _stamps(num_vertices, 0), _size(size), _time(size + 1) {}
+
+    // access a vertex, returns true on a miss
+    inline bool access(uint32_t v) {
+        if (_time - _stamps[v] <= _size) {
+            return false;
+        }
+        _stamps[v] = _time++;
+        return true;
+    }
+
+    // empty the cache
+    inline void flush() { _time += _size + 1; }
+
+private:
+    std::vector<int> _stamps;
+    int _size;
+    int _time;
+};
+
+template <class Index>
+vertex_cache_stats analyze(const Index *indices, int num_indices, int num_vertices, int cache_size) {
+    vertex_cache_stats stats{};
+    num_indices = num_indices / 3 * 3;
+    if (num_indices == 0 || num_vertices <= 0) {
+        return stats;
+    }
+    fifo_cache cache(num_vertices, cache_size);
+    std::vector<uint8_t> used(num_vertices, 0);
+    int num_used = 0;
+    for (int i = 0; i < num_indices; i++) {
+        stats.num_transformed += cache.access(indices[i]) ? 1 : 0;
+        num_used += used[indices[i]] ? 0 : 1;
+        used[indices[i]] = 1;
+    }
+    stats.acmr = static_cast<float>(stats.num_transformed) / (num_indices / 3);
+    stats.atvr = static_cast<float>(stats.num_transformed) / num_used;
+    return stats;
+}
+
+// tipsify (Sander et al. 2007)
+template <class Index>
+void tipsify(Index *dst, const Index *indices, int num_indices, int num_vertices, int cache_size, std::vector<int> *clusters) {
+    const int num_triangles = num_indices / 3;
+    if (clusters) {
+        clusters->clear();
+    }
+    if (num_triangles == 0 || num_vertices <= 0) {
+        return;
+    }
+
+    // triangles around each vertex and live triangle counts
+    std::vector<int> offsets(num_vertices + 1, 0);
+    for (int i = 0; i < num_triangles * 3; i++) {
+        offsets[indices[i] + 1]++;
+    }
+    for (int v = 0; v < num_vertices; v++) {
+        offsets[v + 1] += offsets[v];
+    }
+    std::vector<int> live(num_vertices);
+    for (int v = 0; v < num_vertices; v++) {
+        live[v] = offsets[v + 1] - offsets[v];
+    }
+    std::vector<int> adjacency(num_triangles * 3);
+    {
+        std::vector<int> cursor(offsets.begin(), offsets.end() - 1);
+        for (int t = 0; t < num_triangles; t++) {
+            for (int k = 0; k < 3; k++) {
+                adjacency[cursor[indices[t * 3 + k]]++] = t;
+            }
+        }
+    }
+
+    std::vector<Index> out(num_triangles * 3);
+    std::vector<uint8_t> emitted(num_triangles, 0);
+    std::vector<int> stamps(num_vertices, 0);
+    std::vector<uint32_t> dead_end;
+    std::vector<uint32_t> candidates;
+    int time = cache_size + 1;
+    int num_out = 0;
+    int cursor = 0;
+
+    int fan = indices[0];
+    if (clusters) {
+        clusters->push_back(0);
+    }
+    while (fan >= 0) {
+        // emit all triangles around the fanning vertex
+        candidates.clear();
+        for (int k = offsets[fan]; k < offsets[fan + 1]; k++) {
+            const int t = adjacency[k];
+            if (emitted[t]) {
+                continue;
+            }
+            emitted[t] = 1;
+            for (int j = 0; j < 3; j++) {
+                const Index v = indices[t * 3 + j];
+                out[num_out * 3 + j] = v;
+                dead_end.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (time - stamps[v] > cache_size) {
+                    stamps[v] = time++;
+                }
+            }
+            num_out++;
+        }
+
+        // next fanning vertex: the oldest candidate that stays in cache
+        int next = -1, best = -1;
+        for (const uint32_t v : candidates) {
+            if (live[v] <= 0) {
+                continue;
+            }
+            int priority = 0;
+            if (time - stamps[v] + 2 * live[v] <= cache_size) {
+                priority = time - stamps[v];
+            }
+            if (priority > best) {
+                best = priority;
+                next = static_cast<int>(v);
+            }
+        }
+
+        // dead end: recent vertices first, then the next vertex in order
+        if (next < 0) {
+            while (!dead_end.empty() && next < 0) {
+                const uint32_t v = dead_end.back();
+                dead_end.pop_back();
+                if (live[v] > 0) {
+                    next = static_cast<int>(v);
+                }
+            }
+            while (next < 0 && cursor < num_vertices) {
+                if (live[cursor] > 0) {
+                    next = cursor;
+                }
+                cursor++;
+            }
+            if (next >= 0 && clusters) {
+                clusters->push_back(num_out);
+            }
+        }
+        fan = next;
+    }
+    std::copy(out.begin(), out.begin() + num_out * 3, dst);
+}
+
+template <class Index>
+void overdraw(Index *dst, const Index *indices, int num_indices, const float *positions, int stride, int num_vertices,
+              const std::vector<int> &hard_clusters, int cache_size, float threshold) {
+    const int num_triangles = num_indices / 3;
+    if (num_triangles == 0) {
+        return;
+    }
+    auto position = [positions, stride](uint32_t v) {
+        const float *p = reinterpret_cast<const float *>(reinterpret_cast<const uint8_t *>(positions) + static_cast<size_t>(v) * stride);
+        return vec3{ p[0], p[1], p[2] };
+    };
+
+    // split hard clusters where the running ACMR is already within threshold
+    std::vector<int> clusters;
+    fifo_cache cache(num_vertices, cache_size);
+    std::vector<int> bounds = hard_clusters;
+    if (bounds.empty() || bounds[0] != 0) {
+        bounds.insert(bounds.begin(), 0);
+    }
+    bounds.push_back(num_triangles);
+    for (size_t c = 0; c + 1 < bounds.size(); c++) {
+        const int begin = bounds[c], end = bounds[c + 1];
+        if (begin >= end) {
+            continue;
+        }
+        cache.flush();
+        int misses = 0;
+        for (int i = begin * 3; i < end * 3; i++) {
+            misses += cache.access(indices[i]) ? 1 : 0;
+        }
+        const float cluster_acmr = static_cast<float>(misses) / (end - begin);
+
+        cache.flush();
+        clusters.push_back(begin);
+        int start = begin;
+        misses = 0;
+        for (int t = begin; t < end; t++) {
+            for (int j = 0; j < 3; j++) {
+                misses += cache.access(indices[t * 3 + j]) ? 1 : 0;
+            }
+            if (t + 1 < end && static_cast<float>(misses) / (t + 1 - start) <= cluster_acmr * threshold) {
+                clusters.push_back(t + 1);
+                cache.flush();
+                start = t + 1;
+                misses = 0;
+            }
+        }
+    }
+    clusters.push_back(num_triangles);
+
+    // mesh centroid
+    vec3 mesh_center = { 0.f, 0.f, 0.f };
+    float mesh_area = 0.f;
+    for (int t = 0; t < num_triangles; t++) {
+        const vec3 a = position(indices[t * 3]), b = position(indices[t * 3 + 1]), c = position(indices[t * 3 + 2]);
+        const float area = falcon::math::length(falcon::math::cross(b - a, c - a));
+        mesh_center += (a + b + c) * (area / 3.f);
+        mesh_area += area;
+    }
+    mesh_center = (mesh_area > 0.f) ? mesh_center * (1.f / mesh_area) : mesh_center;
+
+    // sort clusters by how much they face away from the center, outward first
+    struct cluster {
+        int begin, end;
+        float key;
+    };
+    std::vector<cluster> sorted;
+    for (size_t c = 0; c + 1 < clusters.size(); c++) {
+        const int begin = clusters[c], end = clusters[c + 1];
+        vec3 center = { 0.f, 0.f, 0.f }, normal = { 0.f, 0.f, 0.f };
+        float area = 0.f;
+        for (int t = begin; t < end; t++) {
+            const vec3 a = position(indices[t * 3]), b = position(indices[t * 3 + 1]), p = position(indices[t * 3 + 2]);
+            const vec3 n = falcon::math::cross(b - a, p - a);
+            const float ta = falcon::math::length(n);
+            center += (a + b + p) * (ta / 3.f);
+            normal += n;
+            area += ta;
+        }
+        center = (area > 0.f) ? center * (1.f / area) : center;
+
+        // normals of degenerate or closed clusters cancel out, sort them last
+        // instead of with a NaN key
+        const float normal_length = falcon::math::length(normal);
+        const float key = (normal_length > 1e-12f) ? falcon::math::dot(center - mesh_center, normal * (1.f / normal_length)) : -FLT_MAX;
+        sorted.push_back({ begin, end, key });
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const cluster &a, const cluster &b) { return a.key > b.key; });
+
+    std::vector<Index> out;
+    out.reserve(num_triangles * 3);
+    for (const auto &c : sorted) {
+        out.insert(out.end(), indices + c.begin * 3, indices + c.end * 3);
+    }
+    std::copy(out.begin(), out.end(), dst);
+}
+
+template <class Index>
+int vertex_fetch(void *dst, const void *vertices, int num_vertices, int vertex_size, Index *indices, int num_indices) {
+    std::vector<uint32_t> remap(num_vertices, ~0u);
+    auto *out = static_cast<uint8_t *>(dst);
+    const auto *in = static_cast<const uint8_t *>(vertices);
+    uint32_t next = 0;
+    for (int i = 0; i < num_indices; i++) {
+        const Index v = indices[i];
+        if (remap[v] == ~0u) {
+            std::memcpy(out + static_cast<size_t>(next) * vertex_size, in + static_cast<size_t>(v) * vertex_size, vertex_size);
+            remap[v] = next++;
+        }
+        indices[i] = static_cast<Index>(remap[v]);
+    }
+    return static_cast<int>(next);
+}
+
+template <class Index>
+falcon::gfx::mesh_optimize_stats optimize(void *vertices, int num_vertices, int vertex_size, Index *indices, int num_indices,
+                                          const falcon::gfx::mesh_optimize_desc &desc) {
+    falcon::gfx::mesh_optimize_stats stats{};
+    num_indices = num_indices / 3 * 3;
+    stats.num_vertices_before = num_vertices;
+    stats.before = analyze(indices, num_indices, num_vertices, desc.cache_size);
+
+    std::vector<int> clusters;
+    tipsify(indices, indices, num_indices, num_vertices, desc.cache_size, &clusters);
+    if (desc.overdraw) {
+        const float *positions = reinterpret_cast<const float *>(static_cast<const uint8_t *>(vertices) + desc.position_offset);
+        overdraw(indices, indices, num_indices, positions, vertex_size, num_vertices, clusters, desc.cache_size, desc.overdraw_threshold);
+    }
+
+    std::vector<uint8_t> reordered(static_cast<size_t>(num_vertices) * vertex_size);
+    stats.num_vertices_after = vertex_fetch(reordered.data(), vertices, num_vertices, vertex_size, indices, num_indices);
+    std::memcpy(vertices, reordered.data(), static_cast<size_t>(stats.num_vertices_after) * vertex_size);
+
+    stats.after = analyze(indices, num_indices, stats.num_vertices_after, desc.cache_size);
+    return stats;
+}
+
+} // namespace
+
+namespace falcon::gfx {
+
+vertex_cache_stats analyze_vertex_cache(const uint16_t *indices, int num_indices, int num_vertices, int cache_size) {
+    return analyze(indices, num_indices, num_vertices, cache_size);
+}
+
+vertex_cache_stats analyze_vertex_cache(const uint32_t *indices, int num_indices, int num_vertices, int cache_size) {
+    return analyze(indices, num_indices, num_vertices, cache_size);
+}
+
+void optimize_vertex_cache(uint16_t *dst, const uint16_t *indices, int num_indices, int num_vertices, int cache_size, std::vector<int> *clusters) {
+    tipsify(dst, indices, num_indices, num_vertices, cache_size, clusters);
+}
+
+void optimize_vertex_cache(uint32_t *dst, const uint32_t *indices, int num_indices, int num_vertices, int cache_size, std::vector<int> *clusters) {
+    tipsify(dst, indices, num_indices, num_vertices, cache_size, clusters);
+}
+
+void optimize_overdraw(uint16_t *dst, const uint16_t *indices, int num_indices, const float *positions, int stride, int num_vertices,
+                       const std::vector<int> &clusters, int cache_size, float threshold) {
+    overdraw(dst, indices, num_indices, positions, stride, num_vertices, clusters, cache_size, threshold);
+}
+
+void optimize_overdraw(uint32_t *dst, const uint32_t *indices, int num_indices, const float *positions, int stride, int num_vertices,
+                       const std::vector<int> &clusters, int cache_size, float threshold) {
+    overdraw(dst, indices, num_indices, positions, stride, num_vertices, clusters, cache_size, threshold);
+}
+
+int optimize_vertex_fetch(void *dst, const void *vertices, int num_vertices, int vertex_size, uint16_t *indices, int num_indices) {
+    return vertex_fetch(dst, vertices, num_vertices, vertex_size, indices, num_indices);
+}
+
+int optimize_vertex_fetch(void *dst, const void *vertices, int num_vertices, int vertex_size, uint32_t *indices, int num_indices) {
+    return vertex_fetch(dst, vertices, num_vertices, vertex_size, indices, num_indices);
+}
+
+mesh_optimize_stats optimize_mesh(void *vertices, int num_vertices, int vertex_size, uint16_t *indices, int num_indices, const mesh_optimize_desc &desc) {
+    return optimize(vertices, num_vertices, vertex_size, indices, num_indices, desc);
+}
+
+mesh_optimize_stats optimize_mesh(void *vertices, int num_vertices, int vertex_size, uint32_t *indices, int num_indices, const mesh_optimize_desc &desc) {
+    return optimize(vertices, num_vertices, vertex_size, indices, num_indices, desc);
+}
+
+} // namespace falcon::gfx
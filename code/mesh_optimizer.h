@@ -0,0 +1,84 @@
+#ifndef FALCON_MESH_OPTIMIZER_H_
+#define FALCON_MESH_OPTIMIZER_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace falcon::gfx {
+
+// post-transform vertex cache statistics
+struct vertex_cache_stats {
+    // transformed vertices per triangle (0.5 best, 3 worst)
+    float acmr;
+
+    // transformed vertices per referenced vertex (1 best)
+    float atvr;
+
+    // simulated vertex shader invocations
+    int num_transformed;
+};
+
+// simulate a FIFO post-transform cache over a triangle list
+vertex_cache_stats analyze_vertex_cache(const uint16_t *indices, int num_indices, int num_vertices, int cache_size = 16);
+vertex_cache_stats analyze_vertex_cache(const uint32_t *indices, int num_indices, int num_vertices, int cache_size = 16);
+
+// reorder triangles for the vertex cache (tipsify), dst may alias indices,
+// clusters receives the first triangle of every cache-independent run
+void optimize_vertex_cache(uint16_t *dst, const uint16_t *indices, int num_indices, int num_vertices,
+                           int cache_size = 16, std::vector<int> *clusters = nullptr);
+void optimize_vertex_cache(uint32_t *dst, const uint32_t *indices, int num_indices, int num_vertices,
+                           int cache_size = 16, std::vector<int> *clusters = nullptr);
+
+// reorder the clusters of a cache-optimized triangle list so that outward
+// facing clusters come first, splitting clusters where the cache efficiency
+// stays within threshold (e.g. 1.05: ACMR may grow by 5%), dst may alias indices
+void optimize_overdraw(uint16_t *dst, const uint16_t *indices, int num_indices,
+                       const float *positions, int stride, int num_vertices,
+                       const std::vector<int> &clusters, int cache_size = 16, float threshold = 1.05f);
+void optimize_overdraw(uint32_t *dst, const uint32_t *indices, int num_indices,
+                       const float *positions, int stride, int num_vertices,
+                       const std::vector<int> &clusters, int cache_size = 16, float threshold = 1.05f);
+
+// reorder vertices by first use and rewrite indices in place, unused vertices
+// are dropped, returns the new vertex count (dst must not alias vertices)
+int optimize_vertex_fetch(void *dst, const void *vertices, int num_vertices, int vertex_size,
+                          uint16_t *indices, int num_indices);
+int optimize_vertex_fetch(void *dst, const void *vertices, int num_vertices, int vertex_size,
+                          uint32_t *indices, int num_indices);
+
+// mesh optimization description
+struct mesh_optimize_desc {
+    // simulated cache size
+    int cache_size = 16;
+
+    // reorder clusters against overdraw
+    bool overdraw = true;
+
+    // allowed ACMR growth for overdraw ordering
+    float overdraw_threshold = 1.05f;
+
+    // byte offset of the float3 position inside a vertex
+    int position_offset = 0;
+};
+
+// mesh optimization result
+struct mesh_optimize_stats {
+    vertex_cache_stats before;
+    vertex_cache_stats after;
+    int num_vertices_before;
+    int num_vertices_after;
+};
+
+// run cache, overdraw and fetch optimization in place on an indexed mesh,
+// vertices are compacted (the new count is in the result)
+//
+// run this at load or bake time before make_vertex_buffer/make_index_buffer,
+// the rendered result is unchanged apart from triangle order.
+mesh_optimize_stats optimize_mesh(void *vertices, int num_vertices, int vertex_size,
+                                  uint16_t *indices, int num_indices, const mesh_optimize_desc &desc = {});
+mesh_optimize_stats optimize_mesh(void *vertices, int num_vertices, int vertex_size,
+                                  uint32_t *indices, int num_indices, const mesh_optimize_desc &desc = {});
+
+} // namespace falcon::gfx
+
+#endif // FALCON_MESH_OPTIMIZER_H_
@@ -0,0 +1,357 @@
+#include "occlusion_culler.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "sokol_time.h"
+
+namespace {
+
+// tile size in pixels
+constexpr int tile_size = 8;
+
+// smallest clip w of a rasterised vertex, triangles crossing the near plane are skipped
+constexpr float min_w = 1e-4f;
+
+} // namespace
+
+namespace falcon {
+
+void occlusion_culler::setup(const occlusion_culler_desc &desc) {
+    shutdown();
+
+    _desc = desc;
+    _desc.max_triangles = std::max(1, _desc.max_triangles);
+    _desc.chunk_size = std::max(1, _desc.chunk_size);
+    _width = (std::max(tile_size, _desc.width) + tile_size - 1) / tile_size * tile_size;
+    _height = (std::max(tile_size, _desc.height) + tile_size - 1) / tile_size * tile_size;
+    _tiles_x = _width / tile_size;
+    _tiles_y = _height / tile_size;
+
+    for (auto &b : _buffers) {
+        b.depth.assign(_width * _height, 1.f);
+        b.tiles.assign(_tiles_x * _tiles_y, 1.f);
+        b.valid = false;
+    }
+    _front = &_buffers[0];
+    _back = &_buffers[1];
+    _pending.reserve(_desc.max_triangles * 3);
+    _raster_input.reserve(_desc.max_triangles * 3);
+    _raster_triangles.reserve(_desc.max_triangles);
+}
+
+void occlusion_culler::shutdown() {
+    if (_desc.jobs) {
+        _desc.jobs->wait(_raster_counter);
+    }
+    for (auto &b : _buffers) {
+        b.depth.clear();
+        b.tiles.clear();
+        b.valid = false;
+    }
+    _pending.clear();
+    _num_pending_occluders = 0;
+    _raster_input.clear();
+    _raster_triangles.clear();
+    _num_raster_occluders = 0;
+    _visible.clear();
+    _stats = {};
+    _raster_stats = {};
+}
+
+void occlusion_culler::add_occluder(const math::vec3 *positions, const uint16_t *indices, int num_indices, const math::mat4 &model) {
+    add_triangles(positions, indices, num_indices, model);
+}
+
+void occlusion_culler::add_occluder(const math::vec3 *positions, const uint32_t *indices, int num_indices, const math::mat4 &model) {
+    add_triangles(positions, indices, num_indices, model);
+}
+
+template <class Index>
+void occlusion_culler::add_triangles(const math::vec3 *positions, const Index *indices, int num_indices, const math::mat4 &model) {
+    const int capacity = _desc.max_triangles * 3 - static_cast<int>(_pending.size());
+    const int count = std::min(num_indices / 3 * 3, capacity);
+    for (int i = 0; i < count; i++) {
+        _pending.push_back(math::transform_point(model, positions[indices[i]]));
+    }
+    if (count > 0) {
+        _num_pending_occluders++;
+    }
+}
+
+void occlusion_culler::update(const math::mat4 &view_proj) {
+    if (_width == 0) {
+        return;
+    }
+
+    // finish the running rasterisation and make it current
+    if (_desc.jobs) {
+        _desc.jobs->wait(_raster_counter);
+    }
+    if (_back->valid) {
+        std::swap(_front, _back);
+        _stats.num_occluders = _raster_stats.num_occluders;
+        _stats.num_triangles = _raster_stats.num_triangles;
+        _stats.num_rasterized = _raster_stats.num_rasterized;
+        _stats.raster_ms = _raster_stats.raster_ms;
+    }
+
+    // rasterise the added occluders into the back buffer
+    _raster_input.swap(_pending);
+    _pending.clear();
+    _num_raster_occluders = _num_pending_occluders;
+    _num_pending_occluders = 0;
+    _back->view_proj = view_proj;
+    _back->valid = false;
+    if (_desc.jobs) {
+        _desc.jobs->submit([this] { rasterize(*_back); }, &_raster_counter);
+    } else {
+        rasterize(*_back);
+    }
+}
+
+bool occlusion_culler::visible(const math::vec3 &min, const math::vec3 &max) const {
+    return test(*_front, min, max);
+}
+
+const std::vector<uint32_t> &occlusion_culler::cull(const aabb_soa &boxes, const uint32_t *indices, int count) {
+    const uint64_t start = stm_now();
+    count = std::max(0, count);
+
+    const int chunk_size = _desc.chunk_size;
+    const int num_chunks = (count + chunk_size - 1) / chunk_size;
+    _visible.resize(count);
+    _chunk_counts.assign(num_chunks, 0);
+
+    auto fn = [this, &boxes, indices, chunk_size, count](int first_chunk, int end_chunk) {
+        for (int c = first_chunk; c < end_chunk; c++) {
+            const int begin = c * chunk_size;
+            const int end = std::min(count, begin + chunk_size);
+            int n = begin;
+            for (int i = begin; i < end; i++) {
+                const uint32_t index = indices[i];
+                const math::vec3 center = { boxes.center_x[index], boxes.center_y[index], boxes.center_z[index] };
+                const math::vec3 extent = { boxes.extent_x[index], boxes.extent_y[index], boxes.extent_z[index] };
+                if (test(*_front, center - extent, center + extent)) {
+                    _visible[n++] = index;
+                }
+            }
+            _chunk_counts[c] = n - begin;
+        }
+    };
+    if (_desc.jobs) {
+        _desc.jobs->parallel_for(num_chunks, 1, fn);
+    } else {
+        fn(0, num_chunks);
+    }
+
+    // move chunk ranges together
+    int n = 0;
+    for (int c = 0; c < num_chunks; c++) {
+        const int begin = c * chunk_size;
+        if (n != begin && _chunk_counts[c] > 0) {
+            std::memmove(_visible.data() + n, _visible.data() + begin, _chunk_counts[c] * sizeof(uint32_t));
+        }
+        n += _chunk_counts[c];
+    }
+    _visible.resize(n);
+
+    _stats.num_tested = count;
+    _stats.num_culled = count - n;
+    _stats.cull_ms = stm_ms(stm_since(start));
+    return _visible;
+}
+
+void occlusion_culler::rasterize(buffer &b) {
+    const uint64_t start = stm_now();
+
+    // project triangles, skip those crossing the near plane
+    _raster_triangles.clear();
+    const float half_w = _width * .5f, half_h = _height * .5f;
+    for (size_t i = 0; i + 2 < _raster_input.size(); i += 3) {
+        triangle t;
+        bool ok = true;
+        for (int v = 0; v < 3; v++) {
+            const math::vec3 &p = _raster_input[i + v];
+            const math::vec4 c = b.view_proj * math::vec4{ p.x, p.y, p.z, 1.f };
+            if (c.w < min_w) {
+                ok = false;
+                break;
+            }
+            const float inv_w = 1.f / c.w;
+            t.x[v] = (c.x * inv_w + 1.f) * half_w;
+            t.y[v] = (c.y * inv_w + 1.f) * half_h;
+            t.z[v] = (c.z * inv_w + 1.f) * .5f;
+        }
+        if (!ok) {
+            continue;
+        }
+
+        // counter-clockwise, drop degenerate
+        const float area = (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (t.y[1] - t.y[0]) * (t.x[2] - t.x[0]);
+        if (area == 0.f) {
+            continue;
+        }
+        if (area < 0.f) {
+            std::swap(t.x[1], t.x[2]);
+            std::swap(t.y[1], t.y[2]);
+            std::swap(t.z[1], t.z[2]);
+        }
+        _raster_triangles.push_back(t);
+    }
+
+    // one band of tile rows per job
+    auto band = [this, &b](int first_row, int end_row) {
+        const int y0 = first_row * tile_size, y1 = end_row * tile_size;
+        std::fill(b.depth.begin() + y0 * _width, b.depth.begin() + y1 * _width, 1.f);
+        for (const auto &t : _raster_triangles) {
+            rasterize_triangle(b, t, y0, y1);
+        }
+
+        // farthest depth per tile
+        for (int ty = first_row; ty < end_row; ty++) {
+            for (int tx = 0; tx < _tiles_x; tx++) {
+                float farthest = 0.f;
+                for (int y = ty * tile_size; y < (ty + 1) * tile_size; y++) {
+                    const float *row = b.depth.data() + y * _width + tx * tile_size;
+                    for (int x = 0; x < tile_size; x++) {
+                        farthest = std::max(farthest, row[x]);
+                    }
+                }
+                b.tiles[ty * _tiles_x + tx] = farthest;
+            }
+        }
+    };
+    if (_desc.jobs) {
+        _desc.jobs->parallel_for(_tiles_y, 1, band);
+    } else {
+        band(0, _tiles_y);
+    }
+
+    _raster_stats.num_occluders = _num_raster_occluders;
+    _raster_stats.num_triangles = static_cast<int>(_raster_input.size() / 3);
+    _raster_stats.num_rasterized = static_cast<int>(_raster_triangles.size());
+    _raster_stats.raster_ms = stm_ms(stm_since(start));
+    b.valid = true;
+}
+
+void occlusion_culler::rasterize_triangle(buffer &b, const triangle &t, int y0, int y1) const {
+    // pixel bounds, sampled at pixel centers
+    const float min_x = std::min({ t.x[0], t.x[1], t.x[2] });
+    const float max_x = std::max({ t.x[0], t.x[1], t.x[2] });
+    const float min_y = std::min({ t.y[0], t.y[1], t.y[2] });
+    const float max_y = std::max({ t.y[0], t.y[1], t.y[2] });
+    const int px0 = std::max(0, static_cast<int>(min_x)) & ~3;
+    const int px1 = std::min(_width, static_cast<int>(max_x) + 1);
+    const int py0 = std::max(y0, static_cast<int>(min_y));
+    const int py1 = std::min(y1, static_cast<int>(max_y) + 1);
+    if (px0 >= px1 || py0 >= py1) {
+        return;
+    }
+
+    // edge functions e(x, y) = a * x + b * y + c, edge i is opposite vertex i
+    float a[3], bb[3], c[3];
+    for (int i = 0; i < 3; i++) {
+        const int j = (i + 1) % 3, k = (i + 2) % 3;
+        a[i] = t.y[j] - t.y[k];
+        bb[i] = t.x[k] - t.x[j];
+        c[i] = -(a[i] * t.x[j] + bb[i] * t.y[j]);
+    }
+
+    // depth plane from barycentrics, clamped to the vertex range
+    const float area = c[0] + c[1] + c[2];
+    const float inv_area = 1.f / area;
+    const float dzdx = (a[0] * t.z[0] + a[1] * t.z[1] + a[2] * t.z[2]) * inv_area;
+    const float dzdy = (bb[0] * t.z[0] + bb[1] * t.z[1] + bb[2] * t.z[2]) * inv_area;
+    const float z0 = (c[0] * t.z[0] + c[1] * t.z[1] + c[2] * t.z[2]) * inv_area;
+    const float min_z = std::min({ t.z[0], t.z[1], t.z[2] });
+    const float max_z = std::max({ t.z[0], t.z[1], t.z[2] });
+
+    for (int y = py0; y < py1; y++) {
+        const float py = y + .5f;
+        float *row = b.depth.data() + y * _width;
+        const float row_e0 = bb[0] * py + c[0], row_e1 = bb[1] * py + c[1], row_e2 = bb[2] * py + c[2];
+        const float row_z = dzdy * py + z0;
+        int x = px0;
+#if defined(FALCON_MATH_SSE)
+        const __m128 lanes = _mm_setr_ps(.5f, 1.5f, 2.5f, 3.5f);
+        const __m128 zero = _mm_setzero_ps();
+        // px0 and the width are multiples of 4, lanes past px1 fail the edge test
+        for (; x < px1; x += 4) {
+            const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lanes);
+            const __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[0]), px), _mm_set1_ps(row_e0));
+            const __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[1]), px), _mm_set1_ps(row_e1));
+            const __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[2]), px), _mm_set1_ps(row_e2));
+            const __m128 inside = _mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_and_ps(_mm_cmpge_ps(e1, zero), _mm_cmpge_ps(e2, zero)));
+            if (_mm_movemask_ps(inside) == 0) {
+                continue;
+            }
+            __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(dzdx), px), _mm_set1_ps(row_z));
+            z = _mm_min_ps(_mm_max_ps(z, _mm_set1_ps(min_z)), _mm_set1_ps(max_z));
+            const __m128 d = _mm_loadu_ps(row + x);
+            const __m128 nearest = _mm_min_ps(d, z);
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, d)));
+        }
+#endif
+        for (; x < px1; x++) {
+            const float px = x + .5f;
+            if (a[0] * px + row_e0 >= 0.f && a[1] * px + row_e1 >= 0.f && a[2] * px + row_e2 >= 0.f) {
+                const float z = std::min(std::max(dzdx * px + row_z, min_z), max_z);
+                row[x] = std::min(row[x], z);
+            }
+        }
+    }
+}
+
+bool occlusion_culler::test(const buffer &b, const math::vec3 &min, const math::vec3 &max) const {
+    if (!b.valid) {
+        return true;
+    }
+
+    // screen rectangle and nearest depth of the box corners
+    float min_x = 1e30f, min_y = 1e30f, max_x = -1e30f, max_y = -1e30f, near_z = 1.f;
+    for (int i = 0; i < 8; i++) {
+        const math::vec4 p = { (i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z, 1.f };
+        const math::vec4 c = b.view_proj * p;
+        if (c.w < min_w) {
+            return true;
+        }
+        const float inv_w = 1.f / c.w;
+        const float x = (c.x * inv_w + 1.f) * _width * .5f;
+        const float y = (c.y * inv_w + 1.f) * _height * .5f;
+        min_x = std::min(min_x, x);
+        max_x = std::max(max_x, x);
+        min_y = std::min(min_y, y);
+        max_y = std::max(max_y, y);
+        near_z = std::min(near_z, (c.z * inv_w + 1.f) * .5f);
+    }
+    const int x0 = std::max(0, static_cast<int>(min_x));
+    const int x1 = std::min(_width, static_cast<int>(max_x) + 1);
+    const int y0 = std::max(0, static_cast<int>(min_y));
+    const int y1 = std::min(_height, static_cast<int>(max_y) + 1);
+    if (x0 >= x1 || y0 >= y1) {
+        return true;
+    }
+
+    // occluded when the box is behind every covered tile, undecided tiles per pixel
+    for (int ty = y0 / tile_size; ty <= (y1 - 1) / tile_size; ty++) {
+        for (int tx = x0 / tile_size; tx <= (x1 - 1) / tile_size; tx++) {
+            if (b.tiles[ty * _tiles_x + tx] < near_z) {
+                continue;
+            }
+            const int py0 = std::max(y0, ty * tile_size), py1 = std::min(y1, (ty + 1) * tile_size);
+            const int px0 = std::max(x0, tx * tile_size), px1 = std::min(x1, (tx + 1) * tile_size);
+            for (int y = py0; y < py1; y++) {
+                const float *row = b.depth.data() + y * _width;
+                for (int x = px0; x < px1; x++) {
+                    if (row[x] >= near_z) {
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
+
+} // namespace falcon
@@ -0,0 +1,157 @@
+#ifndef FALCON_OCCLUSION_CULLER_H_
+#define FALCON_OCCLUSION_CULLER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "culling.h"
+#include "job_system.h"
+#include "vecmath.h"
+
+namespace falcon {
+
+// occlusion culler description
+struct occlusion_culler_desc {
+    // depth buffer size, width and height are rounded up to multiples of 8
+    int width = 256;
+    int height = 128;
+
+    // occluder triangle capacity per frame
+    int max_triangles = 8 * 1024;
+
+    // workers for rasterisation and tests (null: run on the calling thread)
+    job_system *jobs = nullptr;
+
+    // objects per test job
+    int chunk_size = 4096;
+};
+
+// occlusion culler statistics
+struct occlusion_culler_stats {
+    // of the last finished rasterisation
+    int num_occluders;
+    int num_triangles;
+    int num_rasterized;
+    double raster_ms;
+
+    // of the last cull
+    int num_tested;
+    int num_culled;
+    double cull_ms;
+};
+
+// software occlusion culling against a low resolution hierarchical depth buffer
+//
+// a few large occluders are rasterised with SSE (4 pixels per step) into a
+// small depth buffer that keeps the nearest occluder depth, and every 8x8 tile
+// keeps the farthest depth of its pixels. an object is culled when its nearest
+// depth lies behind every tile it covers, tiles that cannot decide are tested
+// per pixel.
+//
+// rasterisation runs one frame ahead on a worker thread: update() makes the
+// buffer rasterised since the last update current and starts rasterising the
+// occluders added meanwhile, so tests never wait for the rasteriser. tests use
+// the view-projection of the current buffer, i.e. of the previous frame, which
+// can hide an object that becomes visible for one frame.
+class occlusion_culler {
+public:
+    // ctor
+    occlusion_culler() = default;
+
+    // dtor
+    ~occlusion_culler() { shutdown(); }
+
+    occlusion_culler(const occlusion_culler &) = delete;
+    occlusion_culler &operator=(const occlusion_culler &) = delete;
+
+    // allocate depth buffers
+    void setup(const occlusion_culler_desc &desc);
+
+    // wait for rasterisation and free buffers
+    void shutdown();
+
+    // add an occluder for the next update (positions are transformed by model)
+    void add_occluder(const math::vec3 *positions, const uint16_t *indices, int num_indices, const math::mat4 &model);
+    void add_occluder(const math::vec3 *positions, const uint32_t *indices, int num_indices, const math::mat4 &model);
+
+    // finish the running rasterisation and start rasterising the added occluders with view_proj
+    void update(const math::mat4 &view_proj);
+
+    // test a box against the current buffer
+    bool visible(const math::vec3 &min, const math::vec3 &max) const;
+
+    // filter indices (e.g. of frustum_culler) of boxes, returns the visible ones
+    const std::vector<uint32_t> &cull(const aabb_soa &boxes, const uint32_t *indices, int count);
+
+    // get visible indices of the last cull
+    inline const std::vector<uint32_t> &visible() const { return _visible; }
+
+    // get current depth buffer (nearest occluder depth in [0, 1], rows bottom-up)
+    inline const float *depth() const { return _front->valid ? _front->depth.data() : nullptr; }
+    inline int width() const { return _width; }
+    inline int height() const { return _height; }
+
+    // get statistics
+    inline const occlusion_culler_stats &stats() const { return _stats; }
+
+private:
+    // depth buffer with tile maxima
+    struct buffer {
+        std::vector<float> depth;
+        std::vector<float> tiles;
+        math::mat4 view_proj;
+        bool valid = false;
+    };
+
+    // screen space triangle
+    struct triangle {
+        float x[3], y[3], z[3];
+    };
+
+    // append transformed occluder triangles
+    template <class Index>
+    void add_triangles(const math::vec3 *positions, const Index *indices, int num_indices, const math::mat4 &model);
+
+    // rasterise _raster_triangles into buffer (runs on a worker)
+    void rasterize(buffer &b);
+
+    // rasterise one triangle into rows [y0, y1)
+    void rasterize_triangle(buffer &b, const triangle &t, int y0, int y1) const;
+
+    // test box against buffer
+    bool test(const buffer &b, const math::vec3 &min, const math::vec3 &max) const;
+
+    // description
+    occlusion_culler_desc _desc;
+    int _width = 0;
+    int _height = 0;
+    int _tiles_x = 0;
+    int _tiles_y = 0;
+
+    // current buffer for tests and buffer being rasterised
+    buffer _buffers[2];
+    buffer *_front = &_buffers[0];
+    buffer *_back = &_buffers[1];
+    job_counter _raster_counter;
+
+    // occluders added for the next update (world space, 3 per triangle)
+    std::vector<math::vec3> _pending;
+    int _num_pending_occluders = 0;
+
+    // triangles of the running rasterisation
+    std::vector<math::vec3> _raster_input;
+    std::vector<triangle> _raster_triangles;
+    int _num_raster_occluders = 0;
+
+    // visible indices and count per chunk
+    std::vector<uint32_t> _visible;
+    std::vector<int> _chunk_counts;
+
+    // statistics
+    occlusion_culler_stats _stats{};
+    occlusion_culler_stats _raster_stats{};
+};
+
+} // namespace falcon
+
+#endif // FALCON_OCCLUSION_CULLER_H_
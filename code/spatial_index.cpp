@@ -0,0 +1,625 @@
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "sokol_time.h"
+
+namespace {
+
+using falcon::aabb;
+using falcon::math::vec3;
+
+// bounds of an empty child slot
+constexpr float empty_min = 1e30f;
+constexpr float empty_max = -1e30f;
+
+// key of the oversize list
+constexpr uint64_t oversize_key = ~0ull;
+
+// grid coordinate bias and mask (21 bits per axis)
+constexpr int grid_bias = 1 << 20;
+constexpr uint64_t grid_mask = (1ull << 21) - 1;
+
+inline aabb merge(const aabb &a, const aabb &b) {
+    return {
+        { std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z) },
+        { std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z) },
+    };
+}
+
+inline aabb empty_box() {
+    return { { empty_min, empty_min, empty_min }, { empty_max, empty_max, empty_max } };
+}
+
+inline bool overlaps(const aabb &a, const aabb &b) {
+    return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+           a.min.y <= b.max.y && a.max.y >= b.min.y &&
+           a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+// node traversal stack, every level adds at most three entries. trees of
+// usual depth use the inline array, deeper ones the heap.
+class node_stack {
+public:
+    explicit node_stack(int depth) {
+        const size_t size = 3 * static_cast<size_t>(std::max(depth, 1)) + 1;
+        if (size > inline_size) {
+            _heap.resize(size);
+            _data = _heap.data();
+        }
+    }
+
+    inline void push(int index) { _data[_top++] = index; }
+    inline int pop() { return _data[--_top]; }
+    inline bool empty() const { return _top == 0; }
+
+private:
+    static constexpr size_t inline_size = 64;
+    int _inline[inline_size];
+    std::vector<int> _heap;
+    int *_data = _inline;
+    size_t _top = 0;
+};
+
+// cell key of cell coordinates
+inline uint64_t cell_key(int x, int y, int z) {
+    return ((static_cast<uint64_t>(x + grid_bias) & grid_mask) << 42) |
+           ((static_cast<uint64_t>(y + grid_bias) & grid_mask) << 21) |
+           (static_cast<uint64_t>(z + grid_bias) & grid_mask);
+}
+
+// frustum test of a box, 0: outside, 1: intersecting, 2: inside
+inline int classify(const falcon::frustum &f, const aabb &b) {
+    const vec3 c = (b.min + b.max) * .5f;
+    const vec3 e = (b.max - b.min) * .5f;
+    int result = 2;
+    for (const auto &p : f.planes) {
+        const float d = p.x * c.x + p.y * c.y + p.z * c.z + p.w;
+        const float r = std::fabs(p.x) * e.x + std::fabs(p.y) * e.y + std::fabs(p.z) * e.z;
+        if (d + r < 0.f) {
+            return 0;
+        }
+        if (d - r < 0.f) {
+            result = 1;
+        }
+    }
+    return result;
+}
+
+// ray slab test, returns entry distance or -1
+inline float slab(const falcon::ray &r, const vec3 &inv_dir, const aabb &b, float max_t) {
+    float t0 = 0.f, t1 = max_t;
+    for (int axis = 0; axis < 3; axis++) {
+        float near_t = (b.min[axis] - r.origin[axis]) * inv_dir[axis];
+        float far_t = (b.max[axis] - r.origin[axis]) * inv_dir[axis];
+        if (near_t > far_t) {
+            std::swap(near_t, far_t);
+        }
+        t0 = std::max(t0, near_t);
+        t1 = std::min(t1, far_t);
+    }
+    return (t0 <= t1) ? t0 : -1.f;
+}
+
+} // namespace
+
+namespace falcon {
+
+// ---- bvh ----
+
+void bvh::build(const aabb *boxes, int count, int leaf_size) {
+    const uint64_t start = stm_now();
+    clear();
+    count = std::max(0, count);
+    _leaf_size = std::clamp(leaf_size, 1, 0xFFFF);
+
+    _objects.resize(count);
+    _centroids.resize(count);
+    for (int i = 0; i < count; i++) {
+        _objects[i] = static_cast<uint32_t>(i);
+        _centroids[i] = (boxes[i].min + boxes[i].max) * .5f;
+    }
+
+    // split object order first, then copy bounds in tree order and fit nodes
+    _position.assign(count, 0);
+    _leaf.assign(count, 0);
+    _nodes.reserve(count / 2 + 1);
+    if (count > 0) {
+        build_node(0, count, -1, 1);
+    }
+    _bounds.resize(count);
+    for (int i = 0; i < count; i++) {
+        _position[_objects[i]] = static_cast<uint32_t>(i);
+        _bounds[i] = boxes[_objects[i]];
+    }
+    for (int i = static_cast<int>(_nodes.size()) - 1; i >= 0; i--) {
+        for (int slot = 0; slot < 4; slot++) {
+            refit_slot(_nodes[i], slot);
+        }
+    }
+    _marked.assign(_nodes.size(), 0);
+    _centroids.clear();
+    _stats.num_objects = count;
+    _stats.num_nodes = static_cast<int>(_nodes.size());
+    _stats.build_ms = stm_ms(stm_since(start));
+}
+
+void bvh::clear() {
+    _nodes.clear();
+    _objects.clear();
+    _bounds.clear();
+    _position.clear();
+    _leaf.clear();
+    _marked.clear();
+    _stats = {};
+}
+
+int bvh::build_node(int begin, int end, int parent, int depth) {
+    const int index = static_cast<int>(_nodes.size());
+    _nodes.push_back({});
+    _nodes[index].parent = parent;
+    _nodes[index].first = begin;
+    _nodes[index].num = end - begin;
+    _stats.depth = std::max(_stats.depth, depth);
+
+    // median split along the largest centroid extent
+    auto split = [this](int b, int e) {
+        vec3 lo = _centroids[_objects[b]], hi = lo;
+        for (int i = b + 1; i < e; i++) {
+            const vec3 &c = _centroids[_objects[i]];
+            lo = { std::min(lo.x, c.x), std::min(lo.y, c.y), std::min(lo.z, c.z) };
+            hi = { std::max(hi.x, c.x), std::max(hi.y, c.y), std::max(hi.z, c.z) };
+        }
+        const vec3 extent = hi - lo;
+        const int axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z ? 1 : 2);
+        const int mid = b + (e - b) / 2;
+        std::nth_element(_objects.begin() + b, _objects.begin() + mid, _objects.begin() + e, [this, axis](uint32_t l, uint32_t r) {
+            return _centroids[l][axis] < _centroids[r][axis];
+        });
+        return mid;
+    };
+
+    // up to four ranges from two levels of splits
+    int ranges[5] = { begin, end, end, end, end };
+    int num_ranges = 1;
+    if (end - begin > _leaf_size) {
+        const int mid = split(begin, end);
+        ranges[1] = mid;
+        num_ranges = 2;
+        int out[5] = { begin, 0, 0, 0, 0 };
+        int n = 0;
+        for (int r = 0; r < 2; r++) {
+            const int b = ranges[r], e = (r == 0) ? mid : end;
+            if (e - b > _leaf_size) {
+                out[++n] = split(b, e);
+            }
+            out[++n] = e;
+        }
+        num_ranges = n;
+        std::copy(out, out + n + 1, ranges);
+    }
+
+    for (int slot = 0; slot < 4; slot++) {
+        if (slot >= num_ranges) {
+            node &n = _nodes[index];
+            n.child[slot] = -1;
+            n.count[slot] = 0;
+            n.min_x[slot] = n.min_y[slot] = n.min_z[slot] = empty_min;
+            n.max_x[slot] = n.max_y[slot] = n.max_z[slot] = empty_max;
+            continue;
+        }
+        const int b = ranges[slot], e = ranges[slot + 1];
+        if (e - b <= _leaf_size) {
+            node &n = _nodes[index];
+            n.child[slot] = b;
+            n.count[slot] = static_cast<uint16_t>(e - b);
+            for (int i = b; i < e; i++) {
+                _leaf[_objects[i]] = index;
+            }
+        } else {
+            const int child = build_node(b, e, index, depth + 1);
+            node &n = _nodes[index];
+            n.child[slot] = child;
+            n.count[slot] = 0;
+        }
+    }
+    return index;
+}
+
+void bvh::refit_slot(node &n, int slot) const {
+    aabb b = empty_box();
+    if (n.count[slot] > 0) {
+        for (int i = n.child[slot]; i < n.child[slot] + n.count[slot]; i++) {
+            b = merge(b, _bounds[i]);
+        }
+    } else if (n.child[slot] >= 0) {
+        const node &c = _nodes[n.child[slot]];
+        for (int i = 0; i < 4; i++) {
+            b = merge(b, { { c.min_x[i], c.min_y[i], c.min_z[i] }, { c.max_x[i], c.max_y[i], c.max_z[i] } });
+        }
+    }
+    n.min_x[slot] = b.min.x;
+    n.min_y[slot] = b.min.y;
+    n.min_z[slot] = b.min.z;
+    n.max_x[slot] = b.max.x;
+    n.max_y[slot] = b.max.y;
+    n.max_z[slot] = b.max.z;
+}
+
+void bvh::refit(const aabb *boxes) {
+    const uint64_t start = stm_now();
+    for (size_t i = 0; i < _bounds.size(); i++) {
+        _bounds[i] = boxes[_objects[i]];
+    }
+
+    // children follow their parents, so reverse order visits children first
+    for (int i = static_cast<int>(_nodes.size()) - 1; i >= 0; i--) {
+        for (int slot = 0; slot < 4; slot++) {
+            refit_slot(_nodes[i], slot);
+        }
+    }
+    _stats.num_refitted = static_cast<int>(_nodes.size());
+    _stats.refit_ms = stm_ms(stm_since(start));
+}
+
+void bvh::refit(const aabb *boxes, const uint32_t *changed, int num_changed) {
+    const uint64_t start = stm_now();
+
+    // mark leaves and ancestors once
+    _refit_nodes.clear();
+    for (int i = 0; i < num_changed; i++) {
+        const uint32_t object = changed[i];
+        if (object >= _position.size()) {
+            continue;
+        }
+        _bounds[_position[object]] = boxes[object];
+        for (int n = _leaf[object]; n >= 0 && !_marked[n]; n = _nodes[n].parent) {
+            _marked[n] = 1;
+            _refit_nodes.push_back(n);
+        }
+    }
+
+    // deepest first
+    std::sort(_refit_nodes.begin(), _refit_nodes.end(), [](int a, int b) { return a > b; });
+    for (const int n : _refit_nodes) {
+        for (int slot = 0; slot < 4; slot++) {
+            refit_slot(_nodes[n], slot);
+        }
+        _marked[n] = 0;
+    }
+    _stats.num_refitted = static_cast<int>(_refit_nodes.size());
+    _stats.refit_ms = stm_ms(stm_since(start));
+}
+
+int bvh::query(const frustum &f, std::vector<uint32_t> &out) const {
+    const size_t first = out.size();
+    if (_nodes.empty()) {
+        return 0;
+    }
+
+    node_stack stack(_stats.depth);
+    stack.push(0);
+    while (!stack.empty()) {
+        const node &n = _nodes[stack.pop()];
+
+        // masks of children intersecting and inside the frustum
+        int hit = 0, inside = 0;
+#if defined(FALCON_MATH_SSE)
+        const __m128 half = _mm_set1_ps(.5f);
+        const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+        const __m128 lo_x = _mm_load_ps(n.min_x), hi_x = _mm_load_ps(n.max_x);
+        const __m128 lo_y = _mm_load_ps(n.min_y), hi_y = _mm_load_ps(n.max_y);
+        const __m128 lo_z = _mm_load_ps(n.min_z), hi_z = _mm_load_ps(n.max_z);
+        const __m128 cx = _mm_mul_ps(_mm_add_ps(lo_x, hi_x), half), ex = _mm_mul_ps(_mm_sub_ps(hi_x, lo_x), half);
+        const __m128 cy = _mm_mul_ps(_mm_add_ps(lo_y, hi_y), half), ey = _mm_mul_ps(_mm_sub_ps(hi_y, lo_y), half);
+        const __m128 cz = _mm_mul_ps(_mm_add_ps(lo_z, hi_z), half), ez = _mm_mul_ps(_mm_sub_ps(hi_z, lo_z), half);
+        __m128 any = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        __m128 all = any;
+        for (const auto &p : f.planes) {
+            const __m128 px = _mm_set1_ps(p.x), py = _mm_set1_ps(p.y), pz = _mm_set1_ps(p.z);
+            __m128 d = _mm_add_ps(_mm_set1_ps(p.w), _mm_mul_ps(px, cx));
+            d = _mm_add_ps(d, _mm_mul_ps(py, cy));
+            d = _mm_add_ps(d, _mm_mul_ps(pz, cz));
+            __m128 r = _mm_mul_ps(_mm_and_ps(px, abs_mask), ex);
+            r = _mm_add_ps(r, _mm_mul_ps(_mm_and_ps(py, abs_mask), ey));
+            r = _mm_add_ps(r, _mm_mul_ps(_mm_and_ps(pz, abs_mask), ez));
+            any = _mm_and_ps(any, _mm_cmpge_ps(_mm_add_ps(d, r), _mm_setzero_ps()));
+            all = _mm_and_ps(all, _mm_cmpge_ps(_mm_sub_ps(d, r), _mm_setzero_ps()));
+        }
+        hit = _mm_movemask_ps(any);
+        inside = _mm_movemask_ps(all);
+#else
+        for (int slot = 0; slot < 4; slot++) {
+            const aabb b = { { n.min_x[slot], n.min_y[slot], n.min_z[slot] }, { n.max_x[slot], n.max_y[slot], n.max_z[slot] } };
+            const int c = classify(f, b);
+            hit |= (c > 0) << slot;
+            inside |= (c == 2) << slot;
+        }
+#endif
+
+        for (int slot = 0; slot < 4; slot++) {
+            if (!(hit & (1 << slot)) || n.child[slot] < 0) {
+                continue;
+            }
+            if (n.count[slot] > 0) {
+                // leaf, test objects unless the leaf is inside
+                for (int i = n.child[slot]; i < n.child[slot] + n.count[slot]; i++) {
+                    if ((inside & (1 << slot)) || classify(f, _bounds[i]) > 0) {
+                        out.push_back(_objects[i]);
+                    }
+                }
+            } else if (inside & (1 << slot)) {
+                // subtree inside, emit its object range
+                const node &c = _nodes[n.child[slot]];
+                out.insert(out.end(), _objects.begin() + c.first, _objects.begin() + c.first + c.num);
+            } else {
+                stack.push(n.child[slot]);
+            }
+        }
+    }
+    return static_cast<int>(out.size() - first);
+}
+
+int bvh::query(const aabb &box, std::vector<uint32_t> &out) const {
+    const size_t first = out.size();
+    if (_nodes.empty()) {
+        return 0;
+    }
+
+    node_stack stack(_stats.depth);
+    stack.push(0);
+    while (!stack.empty()) {
+        const node &n = _nodes[stack.pop()];
+
+        int hit = 0;
+#if defined(FALCON_MATH_SSE)
+        __m128 m = _mm_and_ps(_mm_cmple_ps(_mm_load_ps(n.min_x), _mm_set1_ps(box.max.x)), _mm_cmpge_ps(_mm_load_ps(n.max_x), _mm_set1_ps(box.min.x)));
+        m = _mm_and_ps(m, _mm_and_ps(_mm_cmple_ps(_mm_load_ps(n.min_y), _mm_set1_ps(box.max.y)), _mm_cmpge_ps(_mm_load_ps(n.max_y), _mm_set1_ps(box.min.y))));
+        m = _mm_and_ps(m, _mm_and_ps(_mm_cmple_ps(_mm_load_ps(n.min_z), _mm_set1_ps(box.max.z)), _mm_cmpge_ps(_mm_load_ps(n.max_z), _mm_set1_ps(box.min.z))));
+        hit = _mm_movemask_ps(m);
+#else
+        for (int slot = 0; slot < 4; slot++) {
+            const aabb b = { { n.min_x[slot], n.min_y[slot], n.min_z[slot] }, { n.max_x[slot], n.max_y[slot], n.max_z[slot] } };
+            hit |= overlaps(b, box) << slot;
+        }
+#endif
+
+        for (int slot = 0; slot < 4; slot++) {
+            if (!(hit & (1 << slot)) || n.child[slot] < 0) {
+                continue;
+            }
+            if (n.count[slot] > 0) {
+                for (int i = n.child[slot]; i < n.child[slot] + n.count[slot]; i++) {
+                    if (overlaps(_bounds[i], box)) {
+                        out.push_back(_objects[i]);
+                    }
+                }
+            } else {
+                stack.push(n.child[slot]);
+            }
+        }
+    }
+    return static_cast<int>(out.size() - first);
+}
+
+bool bvh::raycast(const ray &r, ray_hit &hit) const {
+    hit = { 0, r.max_t };
+    if (_nodes.empty()) {
+        return false;
+    }
+    bool found = false;
+    const vec3 inv_dir = { 1.f / r.direction.x, 1.f / r.direction.y, 1.f / r.direction.z };
+
+    node_stack stack(_stats.depth);
+    stack.push(0);
+    while (!stack.empty()) {
+        const node &n = _nodes[stack.pop()];
+
+        // entry distance per child, closest first
+        alignas(16) float t_near[4];
+        int mask = 0;
+#if defined(FALCON_MATH_SSE)
+        const __m128 ox = _mm_set1_ps(r.origin.x), oy = _mm_set1_ps(r.origin.y), oz = _mm_set1_ps(r.origin.z);
+        const __m128 ix = _mm_set1_ps(inv_dir.x), iy = _mm_set1_ps(inv_dir.y), iz = _mm_set1_ps(inv_dir.z);
+        const __m128 x0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.min_x), ox), ix), x1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.max_x), ox), ix);
+        const __m128 y0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.min_y), oy), iy), y1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.max_y), oy), iy);
+        const __m128 z0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.min_z), oz), iz), z1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.max_z), oz), iz);
+        __m128 t0 = _mm_max_ps(_mm_max_ps(_mm_min_ps(x0, x1), _mm_min_ps(y0, y1)), _mm_max_ps(_mm_min_ps(z0, z1), _mm_setzero_ps()));
+        __m128 t1 = _mm_min_ps(_mm_min_ps(_mm_max_ps(x0, x1), _mm_max_ps(y0, y1)), _mm_min_ps(_mm_max_ps(z0, z1), _mm_set1_ps(hit.t)));
+        mask = _mm_movemask_ps(_mm_cmple_ps(t0, t1));
+        _mm_store_ps(t_near, t0);
+#else
+        for (int slot = 0; slot < 4; slot++) {
+            const aabb b = { { n.min_x[slot], n.min_y[slot], n.min_z[slot] }, { n.max_x[slot], n.max_y[slot], n.max_z[slot] } };
+            t_near[slot] = slab(r, inv_dir, b, hit.t);
+            mask |= (t_near[slot] >= 0.f) << slot;
+        }
+#endif
+
+        // push farthest first so the closest child is visited next
+        int order[4];
+        int num = 0;
+        for (int slot = 0; slot < 4; slot++) {
+            if ((mask & (1 << slot)) && n.child[slot] >= 0) {
+                order[num++] = slot;
+            }
+        }
+        std::sort(order, order + num, [&t_near](int a, int b) { return t_near[a] > t_near[b]; });
+        for (int k = 0; k < num; k++) {
+            const int slot = order[k];
+            if (n.count[slot] == 0) {
+                stack.push(n.child[slot]);
+                continue;
+            }
+            for (int i = n.child[slot]; i < n.child[slot] + n.count[slot]; i++) {
+                const float t = slab(r, inv_dir, _bounds[i], hit.t);
+                if (t >= 0.f && t < hit.t) {
+                    hit = { _objects[i], t };
+                    found = true;
+                }
+            }
+        }
+    }
+    return found;
+}
+
+// ---- loose grid ----
+
+void loose_grid::setup(const loose_grid_desc &desc) {
+    clear();
+    _desc = desc;
+    _desc.cell_size = std::max(1e-3f, _desc.cell_size);
+    _inv_cell_size = 1.f / _desc.cell_size;
+}
+
+void loose_grid::clear() {
+    _objects.clear();
+    _cells.clear();
+    _num_objects = 0;
+    reset_stats();
+}
+
+void loose_grid::update(uint32_t id, const aabb &box) {
+    if (id >= _objects.size()) {
+        _objects.resize(id + 1, object{ {}, 0, 0, false });
+    }
+    object &o = _objects[id];
+
+    // oversize objects bypass the cells
+    const vec3 center = (box.min + box.max) * .5f;
+    const vec3 extent = box.max - box.min;
+    const float limit = _desc.cell_size;
+    const bool oversize = (extent.x > limit || extent.y > limit || extent.z > limit);
+    const int x = coord(center.x), y = coord(center.y), z = coord(center.z);
+    const uint64_t k = oversize ? oversize_key : cell_key(x, y, z);
+
+    o.box = box;
+    if (o.used) {
+        _num_moves++;
+        if (o.cell == k) {
+            return;
+        }
+        unlink(id);
+        _num_cell_changes++;
+    } else {
+        o.used = true;
+        _num_objects++;
+    }
+
+    auto it = _cells.find(k);
+    if (it == _cells.end()) {
+        it = _cells.emplace(k, cell{ x, y, z, {} }).first;
+    }
+    o.cell = k;
+    o.slot = static_cast<uint32_t>(it->second.ids.size());
+    it->second.ids.push_back(id);
+}
+
+void loose_grid::remove(uint32_t id) {
+    if (id >= _objects.size() || !_objects[id].used) {
+        return;
+    }
+    unlink(id);
+    _objects[id].used = false;
+    _num_objects--;
+}
+
+void loose_grid::unlink(uint32_t id) {
+    const object &o = _objects[id];
+    auto it = _cells.find(o.cell);
+    auto &ids = it->second.ids;
+    const uint32_t last = ids.back();
+    ids[o.slot] = last;
+    _objects[last].slot = o.slot;
+    ids.pop_back();
+    if (ids.empty()) {
+        _cells.erase(it);
+    }
+}
+
+void loose_grid::query_cell(const cell &c, const aabb &box, std::vector<uint32_t> &out) const {
+    for (const uint32_t id : c.ids) {
+        if (overlaps(_objects[id].box, box)) {
+            out.push_back(id);
+        }
+    }
+}
+
+int loose_grid::query(const aabb &box, std::vector<uint32_t> &out) const {
+    const size_t first = out.size();
+
+    // cells whose loose bounds (half a cell larger) overlap the box
+    const float h = _desc.cell_size * .5f;
+    const int x0 = coord(box.min.x - h), y0 = coord(box.min.y - h), z0 = coord(box.min.z - h);
+    const int x1 = coord(box.max.x + h), y1 = coord(box.max.y + h), z1 = coord(box.max.z + h);
+    const double range = double(x1 - x0 + 1) * double(y1 - y0 + 1) * double(z1 - z0 + 1);
+
+    if (range <= static_cast<double>(_cells.size())) {
+        for (int cz = z0; cz <= z1; cz++) {
+            for (int cy = y0; cy <= y1; cy++) {
+                for (int cx = x0; cx <= x1; cx++) {
+                    const auto it = _cells.find(cell_key(cx, cy, cz));
+                    if (it != _cells.end()) {
+                        query_cell(it->second, box, out);
+                    }
+                }
+            }
+        }
+        const auto it = _cells.find(oversize_key);
+        if (it != _cells.end()) {
+            query_cell(it->second, box, out);
+        }
+    } else {
+        // fewer occupied cells than covered cells
+        for (const auto &[k, c] : _cells) {
+            if (k == oversize_key || (c.x >= x0 && c.x <= x1 && c.y >= y0 && c.y <= y1 && c.z >= z0 && c.z <= z1)) {
+                query_cell(c, box, out);
+            }
+        }
+    }
+    return static_cast<int>(out.size() - first);
+}
+
+int loose_grid::query(const frustum &f, std::vector<uint32_t> &out) const {
+    const size_t first = out.size();
+    const float s = _desc.cell_size;
+    for (const auto &[k, c] : _cells) {
+        int state = 1;
+        if (k != oversize_key) {
+            const aabb loose = {
+                { (c.x - .5f) * s, (c.y - .5f) * s, (c.z - .5f) * s },
+                { (c.x + 1.5f) * s, (c.y + 1.5f) * s, (c.z + 1.5f) * s },
+            };
+            state = classify(f, loose);
+        }
+        if (state == 2) {
+            out.insert(out.end(), c.ids.begin(), c.ids.end());
+        } else if (state == 1) {
+            for (const uint32_t id : c.ids) {
+                if (classify(f, _objects[id].box) > 0) {
+                    out.push_back(id);
+                }
+            }
+        }
+    }
+    return static_cast<int>(out.size() - first);
+}
+
+loose_grid_stats loose_grid::stats() const {
+    loose_grid_stats s{};
+    s.num_objects = _num_objects;
+    s.num_cells = static_cast<int>(_cells.size());
+    const auto it = _cells.find(oversize_key);
+    s.num_oversize = (it != _cells.end()) ? static_cast<int>(it->second.ids.size()) : 0;
+    s.num_moves = _num_moves;
+    s.num_cell_changes = _num_cell_changes;
+    return s;
+}
+
+void loose_grid::reset_stats() {
+    _num_moves = 0;
+    _num_cell_changes = 0;
+}
+
+} // namespace falcon
@@ -0,0 +1,222 @@
+#ifndef FALCON_SPATIAL_INDEX_H_
+#define FALCON_SPATIAL_INDEX_H_
+
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "culling.h"
+#include "vecmath.h"
+
+namespace falcon {
+
+// axis-aligned box
+struct aabb {
+    math::vec3 min;
+    math::vec3 max;
+};
+
+// ray (direction need not be normalized, hits are reported in units of direction)
+struct ray {
+    math::vec3 origin;
+    math::vec3 direction;
+    float max_t = 1e30f;
+};
+
+// closest ray hit
+struct ray_hit {
+    uint32_t index;
+    float t;
+};
+
+// bounding volume hierarchy statistics
+struct bvh_stats {
+    int num_objects;
+    int num_nodes;
+    int depth;
+    int num_refitted;
+    double build_ms;
+    double refit_ms;
+};
+
+// bounding volume hierarchy with four children per node
+//
+// nodes are stored depth first in one array, each node keeps the bounds of
+// its four children as structure of arrays so one SSE instruction tests all
+// four (see FALCON_MATH_SSE in vecmath.h). objects are sorted so that every
+// subtree covers a contiguous object range, a subtree entirely inside a query
+// is emitted without further tests. moving objects are handled by refitting
+// the bounds of their leaves and ancestors, the tree shape is kept until the
+// next build.
+class bvh {
+public:
+    // ctor
+    bvh() = default;
+
+    bvh(const bvh &) = delete;
+    bvh &operator=(const bvh &) = delete;
+
+    // build over boxes, object i is reported as index i
+    void build(const aabb *boxes, int count, int leaf_size = 4);
+
+    // drop the tree
+    void clear();
+
+    // refit all nodes to boxes (same count and order as build)
+    void refit(const aabb *boxes);
+
+    // refit only the leaves of changed objects and their ancestors
+    void refit(const aabb *boxes, const uint32_t *changed, int num_changed);
+
+    // append indices of objects overlapping the frustum, returns number appended
+    int query(const frustum &f, std::vector<uint32_t> &out) const;
+
+    // append indices of objects overlapping the box, returns number appended
+    int query(const aabb &box, std::vector<uint32_t> &out) const;
+
+    // find the closest object box hit by the ray
+    bool raycast(const ray &r, ray_hit &hit) const;
+
+    // get statistics
+    inline const bvh_stats &stats() const { return _stats; }
+
+private:
+    // node with four children (inner: node index, leaf: first object, empty: -1)
+    struct alignas(16) node {
+        float min_x[4], min_y[4], min_z[4];
+        float max_x[4], max_y[4], max_z[4];
+        int32_t child[4];
+        uint16_t count[4];
+        int32_t parent;
+        int32_t first;
+        int32_t num;
+    };
+
+    // build node over _objects[begin, end), returns node index
+    int build_node(int begin, int end, int parent, int depth);
+
+    // set child slot bounds of node from objects or child node
+    void refit_slot(node &n, int slot) const;
+
+    // description
+    int _leaf_size = 4;
+
+    // nodes, depth first
+    std::vector<node> _nodes;
+
+    // object indices in tree order
+    std::vector<uint32_t> _objects;
+
+    // object bounds in tree order
+    std::vector<aabb> _bounds;
+
+    // build centroids
+    std::vector<math::vec3> _centroids;
+
+    // tree order position and leaf node of each object
+    std::vector<uint32_t> _position;
+    std::vector<int> _leaf;
+
+    // incremental refit scratch
+    std::vector<uint8_t> _marked;
+    std::vector<int> _refit_nodes;
+
+    // statistics
+    bvh_stats _stats{};
+};
+
+// loose grid description
+struct loose_grid_desc {
+    // cell size, objects larger than a cell go to an oversize list
+    float cell_size = 16.f;
+};
+
+// loose grid statistics
+struct loose_grid_stats {
+    int num_objects;
+    int num_cells;
+    int num_oversize;
+    int num_moves;
+    int num_cell_changes;
+};
+
+// hashed loose grid for dynamic objects
+//
+// every object lives in the one cell containing its center, cells are
+// treated as half a cell larger on every side during queries, so a move only
+// touches the grid when the center leaves its cell. ids are chosen by the
+// caller.
+class loose_grid {
+public:
+    // ctor
+    loose_grid() = default;
+
+    loose_grid(const loose_grid &) = delete;
+    loose_grid &operator=(const loose_grid &) = delete;
+
+    // set cell size and drop all objects
+    void setup(const loose_grid_desc &desc);
+
+    // drop all objects
+    void clear();
+
+    // insert or move an object
+    void update(uint32_t id, const aabb &box);
+
+    // remove an object
+    void remove(uint32_t id);
+
+    // append ids of objects overlapping the box, returns number appended
+    int query(const aabb &box, std::vector<uint32_t> &out) const;
+
+    // append ids of objects overlapping the frustum, returns number appended
+    int query(const frustum &f, std::vector<uint32_t> &out) const;
+
+    // get statistics (reset moves with reset_stats)
+    loose_grid_stats stats() const;
+    void reset_stats();
+
+private:
+    // object
+    struct object {
+        aabb box;
+        uint64_t cell;
+        uint32_t slot;
+        bool used;
+    };
+
+    // cell contents
+    struct cell {
+        int x, y, z;
+        std::vector<uint32_t> ids;
+    };
+
+    // cell coordinate
+    inline int coord(float v) const { return static_cast<int>(std::floor(v * _inv_cell_size)); }
+
+    // append ids of the cell overlapping box
+    void query_cell(const cell &c, const aabb &box, std::vector<uint32_t> &out) const;
+
+    // remove id from its cell
+    void unlink(uint32_t id);
+
+    // description
+    loose_grid_desc _desc;
+    float _inv_cell_size = 1.f;
+
+    // objects by id
+    std::vector<object> _objects;
+    int _num_objects = 0;
+
+    // occupied cells
+    std::unordered_map<uint64_t, cell> _cells;
+
+    // statistics
+    int _num_moves = 0;
+    int _num_cell_changes = 0;
+};
+
+} // namespace falcon
+
+#endif // FALCON_SPATIAL_INDEX_H_
@@ -0,0 +1,348 @@
+#include "sprite_batch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+#if defined(SOKOL_GLES3)
+#define FALCON_SPRITE_GLSL_VERSION "#version 300 es\nprecision mediump float;\nprecision mediump sampler2DArray;\n"
+#else
+#define FALCON_SPRITE_GLSL_VERSION "#version 330\n"
+#endif
+
+// vertex shader
+const char *sprite_vs_source =
+    FALCON_SPRITE_GLSL_VERSION
+    "uniform vec4 transform;\n"
+    "layout(location=0) in vec2 position;\n"
+    "layout(location=1) in vec3 texcoord0;\n"
+    "layout(location=2) in vec4 color0;\n"
+    "out vec3 uv;\n"
+    "out vec4 color;\n"
+    "void main() {\n"
+    "    gl_Position = vec4(position * transform.xy + transform.zw, 0.0, 1.0);\n"
+    "    uv = texcoord0;\n"
+    "    color = color0;\n"
+    "}\n";
+
+// fragment shader
+const char *sprite_fs_source =
+    FALCON_SPRITE_GLSL_VERSION
+    "uniform sampler2DArray tex;\n"
+    "in vec3 uv;\n"
+    "in vec4 color;\n"
+    "out vec4 frag_color;\n"
+    "void main() {\n"
+    "    frag_color = texture(tex, uv) * color;\n"
+    "}\n";
+
+// sort key layout: order | blend | array
+constexpr uint32_t array_bits = 14;
+constexpr uint32_t blend_bits = 2;
+
+} // namespace
+
+namespace falcon::gfx {
+
+void sprite_batch::setup(const sprite_batch_desc &desc) {
+    shutdown();
+
+    _desc = desc;
+    _desc.max_layers = std::max(1, std::min<int>(_desc.max_layers, sg_query_limits().max_image_array_layers));
+
+    _sprites.reserve(_desc.max_sprites);
+    _vertices.reserve(static_cast<size_t>(_desc.max_sprites) * 4);
+
+    // stream vertex buffer
+    {
+        sg_buffer_desc buffer_desc{};
+        buffer_desc.type = SG_BUFFERTYPE_VERTEXBUFFER;
+        buffer_desc.usage = SG_USAGE_STREAM;
+        buffer_desc.size = _desc.max_sprites * 4 * static_cast<int>(sizeof(vertex));
+        buffer_desc.label = _desc.label;
+        _vertex_buffer = sg_make_buffer(&buffer_desc);
+    }
+
+    // static quad indices
+    {
+        std::vector<uint32_t> indices(static_cast<size_t>(_desc.max_sprites) * 6);
+        for (uint32_t i = 0, v = 0; i < indices.size(); i += 6, v += 4) {
+            indices[i + 0] = v + 0;
+            indices[i + 1] = v + 1;
+            indices[i + 2] = v + 2;
+            indices[i + 3] = v + 0;
+            indices[i + 4] = v + 2;
+            indices[i + 5] = v + 3;
+        }
+        sg_buffer_desc buffer_desc{};
+        buffer_desc.type = SG_BUFFERTYPE_INDEXBUFFER;
+        buffer_desc.size = static_cast<int>(indices.size() * sizeof(uint32_t));
+        buffer_desc.content = indices.data();
+        buffer_desc.label = _desc.label;
+        _index_buffer = sg_make_buffer(&buffer_desc);
+    }
+
+    // shader
+    {
+        sg_shader_desc shader_desc{};
+        shader_desc.attrs[0].name = "position";
+        shader_desc.attrs[1].name = "texcoord0";
+        shader_desc.attrs[2].name = "color0";
+        shader_desc.vs.source = sprite_vs_source;
+        shader_desc.vs.uniform_blocks[0].size = 4 * sizeof(float);
+        shader_desc.vs.uniform_blocks[0].uniforms[0].name = "transform";
+        shader_desc.vs.uniform_blocks[0].uniforms[0].type = SG_UNIFORMTYPE_FLOAT4;
+        shader_desc.fs.source = sprite_fs_source;
+        shader_desc.fs.images[0].name = "tex";
+        shader_desc.fs.images[0].type = SG_IMAGETYPE_ARRAY;
+        shader_desc.label = _desc.label;
+        _shader = sg_make_shader(&shader_desc);
+    }
+
+    // one pipeline per blend mode
+    for (int i = 0; i < static_cast<int>(sprite_blend::num); i++) {
+        sg_pipeline_desc pipeline_desc{};
+        pipeline_desc.shader = _shader;
+        pipeline_desc.index_type = SG_INDEXTYPE_UINT32;
+        pipeline_desc.layout.attrs[0].format = SG_VERTEXFORMAT_FLOAT2;
+        pipeline_desc.layout.attrs[1].format = SG_VERTEXFORMAT_FLOAT3;
+        pipeline_desc.layout.attrs[2].format = SG_VERTEXFORMAT_UBYTE4N;
+        switch (static_cast<sprite_blend>(i)) {
+        case sprite_blend::alpha:
+            pipeline_desc.blend.enabled = true;
+            pipeline_desc.blend.src_factor_rgb = SG_BLENDFACTOR_SRC_ALPHA;
+            pipeline_desc.blend.dst_factor_rgb = SG_BLENDFACTOR_ONE_MINUS_SRC_ALPHA;
+            break;
+        case sprite_blend::additive:
+            pipeline_desc.blend.enabled = true;
+            pipeline_desc.blend.src_factor_rgb = SG_BLENDFACTOR_SRC_ALPHA;
+            pipeline_desc.blend.dst_factor_rgb = SG_BLENDFACTOR_ONE;
+            break;
+        default:
+            break;
+        }
+        pipeline_desc.label = _desc.label;
+        _pipelines[i] = sg_make_pipeline(&pipeline_desc);
+    }
+}
+
+void sprite_batch::shutdown() {
+    for (auto &pip : _pipelines) {
+        if (pip.id != SG_INVALID_ID) {
+            sg_destroy_pipeline(pip);
+            pip = {};
+        }
+    }
+    if (_shader.id != SG_INVALID_ID) {
+        sg_destroy_shader(_shader);
+        _shader = {};
+    }
+    if (_index_buffer.id != SG_INVALID_ID) {
+        sg_destroy_buffer(_index_buffer);
+        _index_buffer = {};
+    }
+    if (_vertex_buffer.id != SG_INVALID_ID) {
+        sg_destroy_buffer(_vertex_buffer);
+        _vertex_buffer = {};
+    }
+    for (auto &array : _arrays) {
+        if (array.image.id != SG_INVALID_ID) {
+            sg_destroy_image(array.image);
+        }
+    }
+    _arrays.clear();
+    _sprites.clear();
+    _num_dropped = 0;
+    _frame = ~0ull;
+    _frame_sprites = 0;
+    _stats = {};
+}
+
+sprite_texture sprite_batch::add_texture(int width, int height, const void *pixels) {
+    // find an unbuilt array with the same size and a free layer
+    size_t index = 0;
+    for (; index < _arrays.size(); index++) {
+        const auto &array = _arrays[index];
+        if (array.image.id == SG_INVALID_ID
+            && array.width == width
+            && array.height == height
+            && array.num_layers < _desc.max_layers) {
+            break;
+        }
+    }
+    if (index == _arrays.size()) {
+        if (index >= (1u << array_bits)) {
+            return {};
+        }
+        _arrays.push_back({ width, height, 0, {}, {} });
+    }
+
+    auto &array = _arrays[index];
+    const size_t layer_size = static_cast<size_t>(width) * height * 4;
+    array.pixels.resize(layer_size * (array.num_layers + 1));
+    std::memcpy(&array.pixels[layer_size * array.num_layers], pixels, layer_size);
+    return { static_cast<uint16_t>(index), static_cast<uint16_t>(array.num_layers++) };
+}
+
+void sprite_batch::build() {
+    for (auto &array : _arrays) {
+        if (array.image.id != SG_INVALID_ID) {
+            continue;
+        }
+        sg_image_desc image_desc{};
+        image_desc.type = SG_IMAGETYPE_ARRAY;
+        image_desc.width = array.width;
+        image_desc.height = array.height;
+        image_desc.layers = array.num_layers;
+        image_desc.pixel_format = SG_PIXELFORMAT_RGBA8;
+        image_desc.min_filter = _desc.filter;
+        image_desc.mag_filter = _desc.filter;
+        image_desc.wrap_u = SG_WRAP_CLAMP_TO_EDGE;
+        image_desc.wrap_v = SG_WRAP_CLAMP_TO_EDGE;
+        image_desc.content.subimage[0][0].ptr = array.pixels.data();
+        image_desc.content.subimage[0][0].size = static_cast<int>(array.pixels.size());
+        image_desc.label = _desc.label;
+        array.image = sg_make_image(&image_desc);
+
+        // pixels live on the GPU now
+        array.pixels.clear();
+        array.pixels.shrink_to_fit();
+    }
+}
+
+void sprite_batch::texture_size(sprite_texture texture, int &width, int &height) const {
+    if (texture.array < _arrays.size()) {
+        width = _arrays[texture.array].width;
+        height = _arrays[texture.array].height;
+    }
+    else {
+        width = height = 0;
+    }
+}
+
+void sprite_batch::flush(int width, int height) {
+    _stats = {};
+    _stats.num_sprites = static_cast<int>(_sprites.size());
+    _stats.num_dropped = _num_dropped;
+    _stats.num_arrays = static_cast<int>(_arrays.size());
+    _num_dropped = 0;
+
+    if (_sprites.empty()) {
+        return;
+    }
+
+    sort();
+    write_vertices();
+    const int base_offset = sg_append_buffer(
+        _vertex_buffer,
+        _vertices.data(),
+        static_cast<int>(_vertices.size() * sizeof(vertex))
+    );
+    _frame_sprites += static_cast<int>(_sprites.size());
+
+    // pixels to clip space, origin top-left
+    const float transform[4] = { 2.f / width, -2.f / height, -1.f, 1.f };
+
+    sg_bindings bindings{};
+    bindings.vertex_buffers[0] = _vertex_buffer;
+    bindings.vertex_buffer_offsets[0] = base_offset;
+    bindings.index_buffer = _index_buffer;
+
+    // one draw per run of equal keys
+    uint32_t current_blend = ~0u;
+    const size_t count = _order.size();
+    for (size_t first = 0; first < count;) {
+        const uint32_t key = _keys[_order[first]];
+        size_t last = first + 1;
+        while (last < count && _keys[_order[last]] == key) {
+            last++;
+        }
+
+        const uint32_t array = key & ((1u << array_bits) - 1);
+        const uint32_t blend = (key >> array_bits) & ((1u << blend_bits) - 1);
+        if (array < _arrays.size() && _arrays[array].image.id != SG_INVALID_ID) {
+            if (blend != current_blend) {
+                sg_apply_pipeline(_pipelines[blend]);
+                sg_apply_uniforms(SG_SHADERSTAGE_VS, 0, transform, sizeof(transform));
+                current_blend = blend;
+            }
+            bindings.fs_images[0] = _arrays[array].image;
+            sg_apply_bindings(&bindings);
+            sg_draw(static_cast<int>(first * 6), static_cast<int>((last - first) * 6), 1);
+            _stats.num_draws++;
+        }
+        first = last;
+    }
+
+    _sprites.clear();
+}
+
+void sprite_batch::sort() {
+    const size_t count = _sprites.size();
+    _keys.resize(count);
+    _order.resize(count);
+    _temp.resize(count);
+
+    for (size_t i = 0; i < count; i++) {
+        const auto &s = _sprites[i];
+        _keys[i] = (static_cast<uint32_t>(s.order) << (array_bits + blend_bits))
+            | (static_cast<uint32_t>(s.blend) << array_bits)
+            | s.texture.array;
+        _order[i] = static_cast<uint32_t>(i);
+    }
+
+    // stable LSD radix sort, 8 bits per pass, skipping passes with a single bucket
+    for (uint32_t shift = 0; shift < 24; shift += 8) {
+        uint32_t counts[256] = {};
+        for (size_t i = 0; i < count; i++) {
+            counts[(_keys[i] >> shift) & 0xFF]++;
+        }
+        if (counts[(_keys[0] >> shift) & 0xFF] == count) {
+            continue;
+        }
+        uint32_t offset = 0;
+        for (auto &c : counts) {
+            const uint32_t n = c;
+            c = offset;
+            offset += n;
+        }
+        for (size_t i = 0; i < count; i++) {
+            const uint32_t index = _order[i];
+            _temp[counts[(_keys[index] >> shift) & 0xFF]++] = index;
+        }
+        _order.swap(_temp);
+    }
+}
+
+void sprite_batch::write_vertices() {
+    _vertices.resize(_order.size() * 4);
+    vertex *v = _vertices.data();
+    for (const uint32_t index : _order) {
+        const auto &s = _sprites[index];
+        const float layer = static_cast<float>(s.texture.layer);
+        if (s.rotation == 0.f) {
+            const float x0 = s.x, y0 = s.y;
+            const float x1 = s.x + s.width, y1 = s.y + s.height;
+            v[0] = { x0, y0, s.u0, s.v0, layer, s.color };
+            v[1] = { x1, y0, s.u1, s.v0, layer, s.color };
+            v[2] = { x1, y1, s.u1, s.v1, layer, s.color };
+            v[3] = { x0, y1, s.u0, s.v1, layer, s.color };
+        }
+        else {
+            const float c = std::cos(s.rotation), sn = std::sin(s.rotation);
+            const float hw = s.width * .5f, hh = s.height * .5f;
+            const float cx = s.x + hw, cy = s.y + hh;
+            const float ax = c * hw, ay = sn * hw;
+            const float bx = -sn * hh, by = c * hh;
+            v[0] = { cx - ax - bx, cy - ay - by, s.u0, s.v0, layer, s.color };
+            v[1] = { cx + ax - bx, cy + ay - by, s.u1, s.v0, layer, s.color };
+            v[2] = { cx + ax + bx, cy + ay + by, s.u1, s.v1, layer, s.color };
+            v[3] = { cx - ax + bx, cy - ay + by, s.u0, s.v1, layer, s.color };
+        }
+        v += 4;
+    }
+}
+
+} // namespace falcon::gfx
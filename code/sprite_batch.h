@@ -0,0 +1,195 @@
+#ifndef FALCON_SPRITE_BATCH_H_
+#define FALCON_SPRITE_BATCH_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "sokol_gfx.h"
+
+#include "gfx.h"
+
+namespace falcon::gfx {
+
+// sprite texture (array image + layer)
+struct sprite_texture {
+    uint16_t array;
+    uint16_t layer;
+};
+
+// sprite blend mode
+enum class sprite_blend : uint8_t {
+    alpha,
+    additive,
+    opaque,
+    num,
+};
+
+// sprite
+struct sprite {
+    // top-left position in pixels
+    float x = 0.f, y = 0.f;
+
+    // size in pixels
+    float width = 0.f, height = 0.f;
+
+    // rotation in radians around the center
+    float rotation = 0.f;
+
+    // texture rect
+    float u0 = 0.f, v0 = 0.f, u1 = 1.f, v1 = 1.f;
+
+    // color (0xAABBGGRR)
+    uint32_t color = 0xFFFFFFFF;
+
+    // texture
+    sprite_texture texture{};
+
+    // blend mode
+    sprite_blend blend = sprite_blend::alpha;
+
+    // draw order, lower orders are drawn first
+    uint8_t order = 0;
+};
+
+// sprite batch description
+struct sprite_batch_desc {
+    // sprite capacity per frame
+    int max_sprites = 128 * 1024;
+
+    // texture layers per array image (clamped to device limit)
+    int max_layers = 64;
+
+    // texture filter
+    sg_filter filter = SG_FILTER_LINEAR;
+
+    // debug label
+    const char *label = nullptr;
+};
+
+// sprite batch statistics (of the last flush, dropped sprites include those
+// over the per-frame capacity)
+struct sprite_batch_stats {
+    int num_sprites;
+    int num_dropped;
+    int num_draws;
+    int num_arrays;
+};
+
+// 2D sprite renderer
+//
+// textures of the same size are packed into layers of SG_IMAGETYPE_ARRAY images,
+// so sprites are only split into separate draws by texture array, blend mode and
+// order. all vertices of a frame are written into one stream buffer.
+class sprite_batch {
+public:
+    // ctor
+    sprite_batch() = default;
+
+    // dtor
+    ~sprite_batch() { shutdown(); }
+
+    sprite_batch(const sprite_batch &) = delete;
+    sprite_batch &operator=(const sprite_batch &) = delete;
+
+    // create buffers, shader and pipelines
+    void setup(const sprite_batch_desc &desc);
+
+    // destroy all resources
+    void shutdown();
+
+    // register an RGBA8 texture (before build)
+    sprite_texture add_texture(int width, int height, const void *pixels);
+
+    // create array images from registered textures
+    void build();
+
+    // get texture size
+    void texture_size(sprite_texture texture, int &width, int &height) const;
+
+    // queue a sprite, the stream buffer holds max_sprites for all flushes
+    // of the frame
+    inline void draw(const sprite &s) {
+        if (_frame != frame_index()) {
+            begin_frame();
+        }
+        if (_frame_sprites + static_cast<int>(_sprites.size()) < _desc.max_sprites) {
+            _sprites.push_back(s);
+        }
+        else {
+            _num_dropped++;
+        }
+    }
+
+    // draw queued sprites into the current pass with a pixel projection
+    void flush(int width, int height);
+
+    // start counting sprites of a new frame, happens on its own on the first
+    // draw of the next application frame
+    inline void begin_frame() {
+        _frame = frame_index();
+        _frame_sprites = 0;
+    }
+
+    // get statistics
+    inline const sprite_batch_stats &stats() const { return _stats; }
+
+private:
+    // vertex
+    struct vertex {
+        float x, y;
+        float u, v, layer;
+        uint32_t color;
+    };
+
+    // texture array
+    struct texture_array {
+        int width;
+        int height;
+        int num_layers;
+        std::vector<uint8_t> pixels;
+        sg_image image;
+    };
+
+    // sort sprites by key
+    void sort();
+
+    // write vertices for sprites
+    void write_vertices();
+
+    // description
+    sprite_batch_desc _desc;
+
+    // resources
+    sg_buffer _vertex_buffer{};
+    sg_buffer _index_buffer{};
+    sg_shader _shader{};
+    sg_pipeline _pipelines[static_cast<int>(sprite_blend::num)]{};
+
+    // texture arrays
+    std::vector<texture_array> _arrays;
+
+    // queued sprites
+    std::vector<sprite> _sprites;
+
+    // sort state
+    std::vector<uint32_t> _keys;
+    std::vector<uint32_t> _order;
+    std::vector<uint32_t> _temp;
+
+    // vertex staging
+    std::vector<vertex> _vertices;
+
+    // dropped sprites since last flush
+    int _num_dropped = 0;
+
+    // sprites appended to the stream buffer this frame
+    uint64_t _frame = ~0ull;
+    int _frame_sprites = 0;
+
+    // statistics
+    sprite_batch_stats _stats{};
+};
+
+} // namespace falcon::gfx
+
+#endif // FALCON_SPRITE_BATCH_H_
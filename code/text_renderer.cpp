@@ -0,0 +1,518 @@
+#include "text_renderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+#if defined(SOKOL_GLES3)
+#define FALCON_TEXT_GLSL_VERSION "#version 300 es\nprecision mediump float;\n"
+#else
+#define FALCON_TEXT_GLSL_VERSION "#version 330\n"
+#endif
+
+// vertex shader
+const char *text_vs_source =
+    FALCON_TEXT_GLSL_VERSION
+    "uniform vec4 transform;\n"
+    "layout(location=0) in vec2 position;\n"
+    "layout(location=1) in vec2 texcoord0;\n"
+    "layout(location=2) in vec4 color0;\n"
+    "out vec2 uv;\n"
+    "out vec4 color;\n"
+    "void main() {\n"
+    "    gl_Position = vec4(position * transform.xy + transform.zw, 0.0, 1.0);\n"
+    "    uv = texcoord0;\n"
+    "    color = color0;\n"
+    "}\n";
+
+// fragment shader
+const char *text_fs_source =
+    FALCON_TEXT_GLSL_VERSION
+    "uniform sampler2D tex;\n"
+    "in vec2 uv;\n"
+    "in vec4 color;\n"
+    "out vec4 frag_color;\n"
+    "void main() {\n"
+    "    float d = texture(tex, uv).r;\n"
+    "    float w = fwidth(d);\n"
+    "    frag_color = vec4(color.rgb, color.a * smoothstep(0.5 - w, 0.5 + w, d));\n"
+    "}\n";
+
+// decode one UTF-8 codepoint, invalid sequences yield U+FFFD
+uint32_t decode_utf8(const char *&text) {
+    const auto *s = reinterpret_cast<const uint8_t *>(text);
+    uint32_t cp = 0xFFFD;
+    int length = 1;
+    if (s[0] < 0x80) {
+        cp = s[0];
+    }
+    else if ((s[0] & 0xE0) == 0xC0 && (s[1] & 0xC0) == 0x80) {
+        cp = ((s[0] & 0x1Fu) << 6) | (s[1] & 0x3Fu);
+        length = 2;
+    }
+    else if ((s[0] & 0xF0) == 0xE0 && (s[1] & 0xC0) == 0x80 && (s[2] & 0xC0) == 0x80) {
+        cp = ((s[0] & 0x0Fu) << 12) | ((s[1] & 0x3Fu) << 6) | (s[2] & 0x3Fu);
+        length = 3;
+    }
+    else if ((s[0] & 0xF8) == 0xF0 && (s[1] & 0xC0) == 0x80 && (s[2] & 0xC0) == 0x80 && (s[3] & 0xC0) == 0x80) {
+        cp = ((s[0] & 0x07u) << 18) | ((s[1] & 0x3Fu) << 12) | ((s[2] & 0x3Fu) << 6) | (s[3] & 0x3Fu);
+        length = 4;
+    }
+    text += length;
+    return cp;
+}
+
+// 1D squared euclidean distance transform (Felzenszwalb & Huttenlocher)
+void edt_1d(const float *f, float *d, int *v, float *z, int n) {
+    int k = 0;
+    v[0] = 0;
+    z[0] = -std::numeric_limits<float>::infinity();
+    z[1] = std::numeric_limits<float>::infinity();
+    for (int q = 1; q < n; q++) {
+        float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+        while (s <= z[k]) {
+            k--;
+            s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+        }
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = std::numeric_limits<float>::infinity();
+    }
+    k = 0;
+    for (int q = 0; q < n; q++) {
+        while (z[k + 1] < q) {
+            k++;
+        }
+        d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+    }
+}
+
+// 2D squared distance to the nearest pixel where mask is set
+void edt_2d(std::vector<float> &grid, int width, int height) {
+    const int n = std::max(width, height);
+    std::vector<float> f(n), d(n), z(n + 1);
+    std::vector<int> v(n);
+    for (int x = 0; x < width; x++) {
+        for (int y = 0; y < height; y++) f[y] = grid[y * width + x];
+        edt_1d(f.data(), d.data(), v.data(), z.data(), height);
+        for (int y = 0; y < height; y++) grid[y * width + x] = d[y];
+    }
+    for (int y = 0; y < height; y++) {
+        edt_1d(&grid[y * width], d.data(), v.data(), z.data(), width);
+        std::copy(d.begin(), d.begin() + width, grid.begin() + y * width);
+    }
+}
+
+} // namespace
+
+namespace falcon::gfx {
+
+void text_renderer::setup(const text_renderer_desc &desc) {
+    shutdown();
+
+    _desc = desc;
+    _desc.min_bucket = std::max(4, _desc.min_bucket);
+    _desc.max_bucket = std::max(_desc.min_bucket, _desc.max_bucket);
+
+    // glyph atlas
+    {
+        texture_atlas_desc atlas_desc;
+        atlas_desc.width = _desc.atlas_size;
+        atlas_desc.height = _desc.atlas_size;
+        atlas_desc.max_pages = _desc.atlas_pages;
+        atlas_desc.pixel_format = SG_PIXELFORMAT_R8;
+        atlas_desc.label = _desc.label;
+        _atlas.setup(atlas_desc);
+    }
+
+    // stream vertex buffer
+    {
+        sg_buffer_desc buffer_desc{};
+        buffer_desc.type = SG_BUFFERTYPE_VERTEXBUFFER;
+        buffer_desc.usage = SG_USAGE_STREAM;
+        buffer_desc.size = _desc.max_glyphs * 4 * static_cast<int>(sizeof(vertex));
+        buffer_desc.label = _desc.label;
+        _vertex_buffer = sg_make_buffer(&buffer_desc);
+    }
+
+    // static quad indices
+    {
+        std::vector<uint32_t> indices(static_cast<size_t>(_desc.max_glyphs) * 6);
+        for (uint32_t i = 0, v = 0; i < indices.size(); i += 6, v += 4) {
+            indices[i + 0] = v + 0;
+            indices[i + 1] = v + 1;
+            indices[i + 2] = v + 2;
+            indices[i + 3] = v + 0;
+            indices[i + 4] = v + 2;
+            indices[i + 5] = v + 3;
+        }
+        sg_buffer_desc buffer_desc{};
+        buffer_desc.type = SG_BUFFERTYPE_INDEXBUFFER;
+        buffer_desc.size = static_cast<int>(indices.size() * sizeof(uint32_t));
+        buffer_desc.content = indices.data();
+        buffer_desc.label = _desc.label;
+        _index_buffer = sg_make_buffer(&buffer_desc);
+    }
+
+    // shader
+    {
+        sg_shader_desc shader_desc{};
+        shader_desc.attrs[0].name = "position";
+        shader_desc.attrs[1].name = "texcoord0";
+        shader_desc.attrs[2].name = "color0";
+        shader_desc.vs.source = text_vs_source;
+        shader_desc.vs.uniform_blocks[0].size = 4 * sizeof(float);
+        shader_desc.vs.uniform_blocks[0].uniforms[0].name = "transform";
+        shader_desc.vs.uniform_blocks[0].uniforms[0].type = SG_UNIFORMTYPE_FLOAT4;
+        shader_desc.fs.source = text_fs_source;
+        shader_desc.fs.images[0].name = "tex";
+        shader_desc.fs.images[0].type = SG_IMAGETYPE_2D;
+        shader_desc.label = _desc.label;
+        _shader = sg_make_shader(&shader_desc);
+    }
+
+    // alpha blended pipeline
+    {
+        sg_pipeline_desc pipeline_desc{};
+        pipeline_desc.shader = _shader;
+        pipeline_desc.index_type = SG_INDEXTYPE_UINT32;
+        pipeline_desc.layout.attrs[0].format = SG_VERTEXFORMAT_FLOAT2;
+        pipeline_desc.layout.attrs[1].format = SG_VERTEXFORMAT_FLOAT2;
+        pipeline_desc.layout.attrs[2].format = SG_VERTEXFORMAT_UBYTE4N;
+        pipeline_desc.blend.enabled = true;
+        pipeline_desc.blend.src_factor_rgb = SG_BLENDFACTOR_SRC_ALPHA;
+        pipeline_desc.blend.dst_factor_rgb = SG_BLENDFACTOR_ONE_MINUS_SRC_ALPHA;
+        pipeline_desc.label = _desc.label;
+        _pipeline = sg_make_pipeline(&pipeline_desc);
+    }
+}
+
+void text_renderer::shutdown() {
+    // workers write into _results
+    if (_desc.jobs) {
+        _desc.jobs->wait(_pending);
+    }
+
+    if (_pipeline.id != SG_INVALID_ID) {
+        sg_destroy_pipeline(_pipeline);
+        _pipeline = {};
+    }
+    if (_shader.id != SG_INVALID_ID) {
+        sg_destroy_shader(_shader);
+        _shader = {};
+    }
+    if (_index_buffer.id != SG_INVALID_ID) {
+        sg_destroy_buffer(_index_buffer);
+        _index_buffer = {};
+    }
+    if (_vertex_buffer.id != SG_INVALID_ID) {
+        sg_destroy_buffer(_vertex_buffer);
+        _vertex_buffer = {};
+    }
+    _atlas.shutdown();
+    _fonts.clear();
+    _glyphs.clear();
+    _results.clear();
+    _quads.clear();
+    _vertices.clear();
+    _num_dropped = 0;
+    _frame = ~0ull;
+    _upload_frame = ~0ull;
+    _frame_glyphs = 0;
+    _stats = {};
+}
+
+font text_renderer::add_font(const font_desc &desc) {
+    if (!desc.rasterize) {
+        return {};
+    }
+    _fonts.push_back(desc);
+    return { static_cast<uint32_t>(_fonts.size()) };
+}
+
+float text_renderer::draw(font f, const char *text, float x, float y, float size, uint32_t color) {
+    if (f.id == 0 || f.id > _fonts.size() || !text) {
+        return 0.f;
+    }
+    if (_frame != frame_index()) {
+        begin_frame();
+    }
+    const uint32_t font_index = f.id - 1;
+    const auto &desc = _fonts[font_index];
+    const int b = bucket(size);
+    const float scale = size / b;
+
+    float pen_x = x, pen_y = y, max_x = x;
+    uint32_t previous = 0;
+    while (*text) {
+        const uint32_t cp = decode_utf8(text);
+        if (cp == '\n') {
+            max_x = std::max(max_x, pen_x);
+            pen_x = x;
+            pen_y += desc.line_height * size;
+            previous = 0;
+            continue;
+        }
+        if (previous && desc.kerning) {
+            pen_x += desc.kerning(previous, cp, b) * scale;
+        }
+        previous = cp;
+
+        const glyph *g = request(font_index, cp, b);
+        if (!g || g->state != glyph_state::ready) {
+            // placeholder advance until the glyph is rasterised
+            pen_x += (g && g->state == glyph_state::failed) ? 0.f : size * .5f;
+            continue;
+        }
+        if (g->entry.id != 0) {
+            if (_frame_glyphs + static_cast<int>(_quads.size()) >= _desc.max_glyphs) {
+                _num_dropped++;
+            }
+            else {
+                const float x0 = pen_x + g->bearing_x * scale;
+                const float y0 = pen_y + g->bearing_y * scale;
+                _quads.push_back({ g->entry, x0, y0, x0 + g->width * scale, y0 + g->height * scale, color });
+            }
+        }
+        pen_x += g->advance * scale;
+    }
+    return std::max(max_x, pen_x) - x;
+}
+
+float text_renderer::measure(font f, const char *text, float size) {
+    if (f.id == 0 || f.id > _fonts.size() || !text) {
+        return 0.f;
+    }
+    const uint32_t font_index = f.id - 1;
+    const auto &desc = _fonts[font_index];
+    const int b = bucket(size);
+    const float scale = size / b;
+
+    float width = 0.f, max_width = 0.f;
+    uint32_t previous = 0;
+    while (*text) {
+        const uint32_t cp = decode_utf8(text);
+        if (cp == '\n') {
+            max_width = std::max(max_width, width);
+            width = 0.f;
+            previous = 0;
+            continue;
+        }
+        if (previous && desc.kerning) {
+            width += desc.kerning(previous, cp, b) * scale;
+        }
+        previous = cp;
+        const glyph *g = request(font_index, cp, b);
+        if (g && g->state == glyph_state::ready) {
+            width += g->advance * scale;
+        }
+        else if (!g || g->state == glyph_state::pending) {
+            width += size * .5f;
+        }
+    }
+    return std::max(max_width, width);
+}
+
+void text_renderer::flush(int width, int height) {
+    // mark queued glyphs as used first, the atlas never repacks or evicts
+    // pages used in this frame while new glyphs are added
+    for (const auto &q : _quads) {
+        _atlas.use(q.entry);
+    }
+
+    // glyphs finished since last frame go into the atlas on the first flush
+    // of a frame, followed by its one upload. later flushes only use glyphs
+    // that are already uploaded.
+    int num_rasterized = 0;
+    if (_upload_frame != frame_index()) {
+        _upload_frame = frame_index();
+        num_rasterized = collect();
+        _atlas.flush();
+    }
+
+    _stats = {};
+    _stats.num_glyphs = static_cast<int>(_quads.size());
+    _stats.num_dropped = _num_dropped;
+    _stats.num_cached = static_cast<int>(_glyphs.size());
+    _stats.num_pending = _pending.value.load(std::memory_order_relaxed);
+    _stats.num_rasterized = num_rasterized;
+    _num_dropped = 0;
+
+    // sort quads into atlas pages
+    for (const auto &q : _quads) {
+        const atlas_region r = _atlas.region(q.entry);
+        if (r.image.id == SG_INVALID_ID) {
+            continue;
+        }
+        if (static_cast<int>(_vertices.size()) <= r.page) {
+            _vertices.resize(r.page + 1);
+        }
+        auto &v = _vertices[r.page];
+        v.push_back({ q.x0, q.y0, r.u0, r.v0, q.color });
+        v.push_back({ q.x1, q.y0, r.u1, r.v0, q.color });
+        v.push_back({ q.x1, q.y1, r.u1, r.v1, q.color });
+        v.push_back({ q.x0, q.y1, r.u0, r.v1, q.color });
+    }
+    _quads.clear();
+
+    // all pages into one stream
+    _staging.clear();
+    for (const auto &v : _vertices) {
+        _staging.insert(_staging.end(), v.begin(), v.end());
+    }
+    if (_staging.empty()) {
+        return;
+    }
+    const int base_offset = sg_append_buffer(_vertex_buffer, _staging.data(), static_cast<int>(_staging.size() * sizeof(vertex)));
+    _frame_glyphs += static_cast<int>(_staging.size() / 4);
+
+    // pixels to clip space, origin top-left
+    const float transform[4] = { 2.f / width, -2.f / height, -1.f, 1.f };
+    sg_apply_pipeline(_pipeline);
+    sg_apply_uniforms(SG_SHADERSTAGE_VS, 0, transform, sizeof(transform));
+
+    sg_bindings bindings{};
+    bindings.vertex_buffers[0] = _vertex_buffer;
+    bindings.vertex_buffer_offsets[0] = base_offset;
+    bindings.index_buffer = _index_buffer;
+
+    // one draw per atlas page
+    int first = 0;
+    for (size_t page = 0; page < _vertices.size(); page++) {
+        const int num_quads = static_cast<int>(_vertices[page].size() / 4);
+        if (num_quads > 0) {
+            bindings.fs_images[0] = _atlas.image(static_cast<int>(page));
+            sg_apply_bindings(&bindings);
+            sg_draw(first * 6, num_quads * 6, 1);
+            _stats.num_draws++;
+        }
+        first += num_quads;
+        _vertices[page].clear();
+    }
+}
+
+uint64_t text_renderer::make_key(uint32_t font_index, uint32_t codepoint, int bucket) {
+    return (static_cast<uint64_t>(font_index) << 40) | (static_cast<uint64_t>(bucket) << 24) | codepoint;
+}
+
+int text_renderer::bucket(float size) const {
+    int b = _desc.min_bucket;
+    while (b < size && b < _desc.max_bucket) {
+        b *= 2;
+    }
+    return std::min(b, _desc.max_bucket);
+}
+
+const text_renderer::glyph *text_renderer::request(uint32_t font_index, uint32_t codepoint, int bucket) {
+    const uint64_t key = make_key(font_index, codepoint, bucket);
+    auto it = _glyphs.find(key);
+    if (it != _glyphs.end()) {
+        // evicted from the atlas, rasterise again
+        if (it->second.state != glyph_state::ready || it->second.entry.id == 0 || _atlas.valid(it->second.entry)) {
+            return &it->second;
+        }
+        _glyphs.erase(it);
+    }
+
+    glyph &g = _glyphs[key];
+    g = {};
+    g.state = glyph_state::pending;
+
+    auto job = [this, key, codepoint, bucket, desc = _fonts[font_index], spread = _desc.sdf_spread] {
+        result r{ key, false, {} };
+        r.ok = rasterize(desc, codepoint, bucket, spread, r.bitmap);
+        std::lock_guard<std::mutex> lock(_results_mutex);
+        _results.push_back(std::move(r));
+    };
+    if (_desc.jobs) {
+        _desc.jobs->submit(std::move(job), &_pending);
+    }
+    else {
+        job();
+    }
+    return &g;
+}
+
+bool text_renderer::rasterize(const font_desc &desc, uint32_t codepoint, int bucket, int spread, glyph_bitmap &out) {
+    glyph_bitmap coverage;
+    if (!desc.rasterize(codepoint, bucket, coverage)) {
+        return false;
+    }
+    out.advance = coverage.advance;
+    if (coverage.width <= 0 || coverage.height <= 0) {
+        return true;
+    }
+
+    // distance field with spread pixels of border
+    const int w = coverage.width + spread * 2;
+    const int h = coverage.height + spread * 2;
+    constexpr float far = 1e20f;
+    std::vector<float> to_inside(static_cast<size_t>(w) * h, far);
+    std::vector<float> to_outside(static_cast<size_t>(w) * h, 0.f);
+    for (int y = 0; y < coverage.height; y++) {
+        for (int x = 0; x < coverage.width; x++) {
+            if (coverage.coverage[y * coverage.width + x] >= 128) {
+                const size_t i = static_cast<size_t>(y + spread) * w + (x + spread);
+                to_inside[i] = 0.f;
+                to_outside[i] = far;
+            }
+        }
+    }
+    edt_2d(to_inside, w, h);
+    edt_2d(to_outside, w, h);
+
+    out.width = w;
+    out.height = h;
+    out.bearing_x = coverage.bearing_x - spread;
+    out.bearing_y = coverage.bearing_y - spread;
+    out.coverage.resize(static_cast<size_t>(w) * h);
+    const float scale = .5f / spread;
+    for (size_t i = 0; i < out.coverage.size(); i++) {
+        const float distance = std::sqrt(to_outside[i]) - std::sqrt(to_inside[i]);
+        const float value = std::clamp(.5f + distance * scale, 0.f, 1.f);
+        out.coverage[i] = static_cast<uint8_t>(value * 255.f + .5f);
+    }
+    return true;
+}
+
+int text_renderer::collect() {
+    int count = 0;
+    std::vector<result> results;
+    {
+        std::lock_guard<std::mutex> lock(_results_mutex);
+        results.swap(_results);
+    }
+
+    for (auto &r : results) {
+        auto it = _glyphs.find(r.key);
+        if (it == _glyphs.end()) {
+            continue;
+        }
+        auto &g = it->second;
+        if (!r.ok) {
+            g.state = glyph_state::failed;
+            continue;
+        }
+        g.bearing_x = r.bitmap.bearing_x;
+        g.bearing_y = r.bitmap.bearing_y;
+        g.advance = r.bitmap.advance;
+        g.width = r.bitmap.width;
+        g.height = r.bitmap.height;
+        if (g.width > 0 && g.height > 0) {
+            g.entry = _atlas.add(g.width, g.height, r.bitmap.coverage.data());
+            if (g.entry.id == 0) {
+                // atlas full of recently used glyphs, retry on next request
+                _glyphs.erase(it);
+                continue;
+            }
+        }
+        g.state = glyph_state::ready;
+        count++;
+    }
+    return count;
+}
+
+} // namespace falcon::gfx
@@ -0,0 +1,237 @@
+#ifndef FALCON_TEXT_RENDERER_H_
+#define FALCON_TEXT_RENDERER_H_
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "sokol_gfx.h"
+
+#include "gfx.h"
+#include "job_system.h"
+#include "texture_atlas.h"
+
+namespace falcon::gfx {
+
+// font handle (index + 1, 0 is invalid)
+struct font {
+    uint32_t id;
+};
+
+// rasterised glyph coverage
+struct glyph_bitmap {
+    // coverage size in pixels (0 for blank glyphs)
+    int width = 0;
+    int height = 0;
+
+    // offset from pen position to the top-left of the bitmap (y down)
+    float bearing_x = 0.f;
+    float bearing_y = 0.f;
+
+    // pen advance
+    float advance = 0.f;
+
+    // 8-bit coverage, width * height
+    std::vector<uint8_t> coverage;
+};
+
+// font description
+struct font_desc {
+    // rasterise a glyph at pixel size, called from worker threads (must be thread-safe)
+    std::function<bool(uint32_t codepoint, int pixel_size, glyph_bitmap &out)> rasterize;
+
+    // kerning between two codepoints at pixel size (optional)
+    std::function<float(uint32_t left, uint32_t right, int pixel_size)> kerning;
+
+    // line advance relative to pixel size
+    float line_height = 1.2f;
+};
+
+// text renderer description
+struct text_renderer_desc {
+    // glyph capacity per frame
+    int max_glyphs = 16 * 1024;
+
+    // atlas page size
+    int atlas_size = 1024;
+
+    // atlas page limit
+    int atlas_pages = 2;
+
+    // distance field spread in pixels of the rasterised glyph
+    int sdf_spread = 4;
+
+    // smallest and largest rasterised size, requested sizes are rounded up to powers of two
+    int min_bucket = 16;
+    int max_bucket = 64;
+
+    // workers for rasterisation (null: rasterise on flush)
+    job_system *jobs = nullptr;
+
+    // debug label
+    const char *label = nullptr;
+};
+
+// text renderer statistics (of the last flush, dropped glyphs include those
+// over the per-frame capacity)
+struct text_renderer_stats {
+    int num_glyphs;
+    int num_draws;
+    int num_cached;
+    int num_pending;
+    int num_rasterized;
+    int num_dropped;
+};
+
+// signed distance field text renderer
+//
+// glyphs are rasterised by the font callback on worker threads, converted to
+// distance fields and cached in an R8 texture atlas per (font, codepoint,
+// size bucket). one distance field serves every size within its bucket. all
+// strings of a frame go into one stream buffer, with one draw per atlas page.
+// glyphs that are still being rasterised are skipped until they are ready.
+class text_renderer {
+public:
+    // ctor
+    text_renderer() = default;
+
+    // dtor
+    ~text_renderer() { shutdown(); }
+
+    text_renderer(const text_renderer &) = delete;
+    text_renderer &operator=(const text_renderer &) = delete;
+
+    // create atlas, buffers and pipeline
+    void setup(const text_renderer_desc &desc);
+
+    // wait for workers and destroy all resources
+    void shutdown();
+
+    // register a font
+    font add_font(const font_desc &desc);
+
+    // queue an UTF-8 string at pen position (baseline), returns the advance
+    // width. the stream buffer holds max_glyphs for all flushes of the frame.
+    float draw(font f, const char *text, float x, float y, float size, uint32_t color = 0xFFFFFFFF);
+
+    // measure an UTF-8 string with the currently cached glyphs
+    float measure(font f, const char *text, float size);
+
+    // draw queued text into the current pass with a pixel projection, the
+    // first flush of a frame also adds finished glyphs and uploads the atlas
+    void flush(int width, int height);
+
+    // start counting glyphs of a new frame, happens on its own on the first
+    // draw of the next application frame
+    inline void begin_frame() {
+        _frame = frame_index();
+        _frame_glyphs = 0;
+    }
+
+    // get statistics
+    inline const text_renderer_stats &stats() const { return _stats; }
+
+    // get the atlas
+    inline const texture_atlas &atlas() const { return _atlas; }
+
+private:
+    // vertex
+    struct vertex {
+        float x, y;
+        float u, v;
+        uint32_t color;
+    };
+
+    // glyph state
+    enum class glyph_state : uint8_t {
+        pending,
+        ready,
+        failed,
+    };
+
+    // cached glyph
+    struct glyph {
+        glyph_state state;
+        atlas_entry entry;
+
+        // metrics at bucket size, including spread
+        float bearing_x, bearing_y, advance;
+        int width, height;
+    };
+
+    // queued glyph quad, resolved against the atlas on flush
+    struct quad {
+        atlas_entry entry;
+        float x0, y0, x1, y1;
+        uint32_t color;
+    };
+
+    // finished rasterisation
+    struct result {
+        uint64_t key;
+        bool ok;
+        glyph_bitmap bitmap;
+    };
+
+    // cache key
+    static uint64_t make_key(uint32_t font_index, uint32_t codepoint, int bucket);
+
+    // size bucket for requested size
+    int bucket(float size) const;
+
+    // get cached glyph or start rasterising it
+    const glyph *request(uint32_t font_index, uint32_t codepoint, int bucket);
+
+    // rasterise and convert to distance field
+    static bool rasterize(const font_desc &desc, uint32_t codepoint, int bucket, int spread, glyph_bitmap &out);
+
+    // move finished glyphs into the atlas, returns number of added glyphs
+    int collect();
+
+    // description
+    text_renderer_desc _desc;
+
+    // fonts
+    std::vector<font_desc> _fonts;
+
+    // glyph cache
+    std::unordered_map<uint64_t, glyph> _glyphs;
+
+    // glyph atlas
+    texture_atlas _atlas;
+
+    // finished rasterisations from workers
+    std::vector<result> _results;
+    std::mutex _results_mutex;
+    job_counter _pending;
+
+    // queued glyphs
+    std::vector<quad> _quads;
+    int _num_dropped = 0;
+
+    // glyphs appended to the stream buffer this frame
+    uint64_t _frame = ~0ull;
+    int _frame_glyphs = 0;
+
+    // frame of the last atlas upload
+    uint64_t _upload_frame = ~0ull;
+
+    // vertices per atlas page
+    std::vector<std::vector<vertex>> _vertices;
+    std::vector<vertex> _staging;
+
+    // resources
+    sg_buffer _vertex_buffer{};
+    sg_buffer _index_buffer{};
+    sg_shader _shader{};
+    sg_pipeline _pipeline{};
+
+    // statistics
+    text_renderer_stats _stats{};
+};
+
+} // namespace falcon::gfx
+
+#endif // FALCON_TEXT_RENDERER_H_
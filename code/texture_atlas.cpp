@@ -0,0 +1,382 @@
+#include "texture_atlas.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#include "sokol_time.h"
+
+#include "gfx.h"
+
+namespace {
+
+// handle layout
+constexpr uint32_t slot_bits = 16;
+constexpr uint32_t slot_mask = (1u << slot_bits) - 1;
+
+inline uint32_t make_id(uint32_t index, uint16_t generation) {
+    return (static_cast<uint32_t>(generation) << slot_bits) | ((index + 1) & slot_mask);
+}
+
+} // namespace
+
+namespace falcon::gfx {
+
+void texture_atlas::setup(const texture_atlas_desc &desc) {
+    shutdown();
+
+    _desc = desc;
+    _desc.max_pages = std::max(1, _desc.max_pages);
+    _desc.padding = std::max(0, _desc.padding);
+    _desc.min_eviction_age = std::max(1, _desc.min_eviction_age);
+    _bpp = (_desc.pixel_format == SG_PIXELFORMAT_R8) ? 1 : 4;
+}
+
+void texture_atlas::shutdown() {
+    for (auto &p : _pages) {
+        if (p.image.id != SG_INVALID_ID) {
+            sg_destroy_image(p.image);
+        }
+    }
+    _pages.clear();
+    _slots.clear();
+    _free_slots.clear();
+    _stats = {};
+}
+
+atlas_entry texture_atlas::add(int width, int height, const void *pixels) {
+    const int padded_width = width + _desc.padding;
+    const int padded_height = height + _desc.padding;
+    if (!pixels || width <= 0 || height <= 0 || padded_width > _desc.width || padded_height > _desc.height) {
+        return {};
+    }
+
+    // get a slot first, so a failed add does not evict anything
+    uint32_t index = 0;
+    if (!_free_slots.empty()) {
+        index = _free_slots.back();
+        _free_slots.pop_back();
+    }
+    else if (_slots.size() < slot_mask) {
+        index = static_cast<uint32_t>(_slots.size());
+        _slots.push_back({});
+    }
+    else {
+        return {};
+    }
+
+    const uint64_t frame = frame_index();
+    int page_index = -1, x = 0, y = 0;
+
+    // try existing pages
+    for (size_t i = 0; i < _pages.size() && page_index < 0; i++) {
+        if (insert(_pages[i], padded_width, padded_height, x, y)) {
+            page_index = static_cast<int>(i);
+        }
+    }
+
+    // try a new page
+    if (page_index < 0 && static_cast<int>(_pages.size()) < _desc.max_pages && add_page()) {
+        if (insert(_pages.back(), padded_width, padded_height, x, y)) {
+            page_index = static_cast<int>(_pages.size()) - 1;
+        }
+    }
+
+    // evict from least recently used pages, never from pages used this frame
+    if (page_index < 0) {
+        std::vector<int> order(_pages.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [this](int a, int b) {
+            return _pages[a].last_used < _pages[b].last_used;
+        });
+        for (const int i : order) {
+            if (_pages[i].last_used == frame || !repack(i)) {
+                continue;
+            }
+            if (insert(_pages[i], padded_width, padded_height, x, y)) {
+                page_index = i;
+                break;
+            }
+        }
+    }
+
+    if (page_index < 0) {
+        _free_slots.push_back(index);
+        return {};
+    }
+
+    auto &p = _pages[page_index];
+    blit(p, x, y, width, height, static_cast<const uint8_t *>(pixels), width * _bpp);
+    p.used_area += static_cast<int64_t>(width) * height;
+    p.last_used = frame;
+
+    auto &s = _slots[index];
+    s.generation = static_cast<uint16_t>(s.generation + 1);
+    if (s.generation == 0) s.generation = 1;
+    s.used = true;
+    s.page = page_index;
+    s.x = x;
+    s.y = y;
+    s.width = width;
+    s.height = height;
+    s.last_used = frame;
+    _stats.num_entries++;
+
+    return { make_id(index, s.generation) };
+}
+
+void texture_atlas::remove(atlas_entry entry) {
+    auto *s = const_cast<slot *>(lookup(entry));
+    if (!s) {
+        return;
+    }
+
+    // the area is reclaimed by the next repack of the page
+    _pages[s->page].used_area -= static_cast<int64_t>(s->width) * s->height;
+    s->used = false;
+    _free_slots.push_back(static_cast<uint32_t>(s - _slots.data()));
+    _stats.num_entries--;
+}
+
+bool texture_atlas::valid(atlas_entry entry) const {
+    return lookup(entry) != nullptr;
+}
+
+atlas_region texture_atlas::use(atlas_entry entry) {
+    auto *s = const_cast<slot *>(lookup(entry));
+    if (!s) {
+        return {};
+    }
+    s->last_used = frame_index();
+    _pages[s->page].last_used = s->last_used;
+    return make_region(*s);
+}
+
+atlas_region texture_atlas::region(atlas_entry entry) const {
+    if (auto *s = lookup(entry)) {
+        return make_region(*s);
+    }
+    return {};
+}
+
+void texture_atlas::flush() {
+    const uint64_t start = stm_now();
+    const uint64_t frame = frame_index();
+    for (auto &p : _pages) {
+        if (!p.dirty || p.uploaded == frame) {
+            continue;
+        }
+        sg_image_content content{};
+        content.subimage[0][0].ptr = p.pixels.data();
+        content.subimage[0][0].size = static_cast<int>(p.pixels.size());
+        sg_update_image(p.image, &content);
+        p.dirty = false;
+        p.uploaded = frame;
+
+        _stats.num_uploads++;
+        _stats.uploaded_bytes += static_cast<int64_t>(p.pixels.size());
+    }
+    _stats.upload_ms += stm_ms(stm_since(start));
+}
+
+const texture_atlas_stats &texture_atlas::stats() const {
+    int64_t used = 0;
+    for (const auto &p : _pages) {
+        used += p.used_area;
+    }
+    const int64_t total = static_cast<int64_t>(_desc.width) * _desc.height * static_cast<int64_t>(_pages.size());
+    _stats.num_pages = static_cast<int>(_pages.size());
+    _stats.efficiency = total > 0 ? static_cast<float>(static_cast<double>(used) / total) : 0.f;
+    return _stats;
+}
+
+bool texture_atlas::add_page() {
+    sg_image_desc image_desc{};
+    image_desc.width = _desc.width;
+    image_desc.height = _desc.height;
+    image_desc.usage = SG_USAGE_DYNAMIC;
+    image_desc.pixel_format = _desc.pixel_format;
+    image_desc.min_filter = _desc.filter;
+    image_desc.mag_filter = _desc.filter;
+    image_desc.wrap_u = SG_WRAP_CLAMP_TO_EDGE;
+    image_desc.wrap_v = SG_WRAP_CLAMP_TO_EDGE;
+    image_desc.label = _desc.label;
+    const sg_image image = sg_make_image(&image_desc);
+    if (image.id == SG_INVALID_ID) {
+        return false;
+    }
+
+    page p{};
+    p.image = image;
+    p.pixels.assign(static_cast<size_t>(_desc.width) * _desc.height * _bpp, 0);
+    p.skyline.push_back({ 0, 0, _desc.width });
+    p.last_used = frame_index();
+    p.uploaded = ~0ull;
+    _pages.push_back(std::move(p));
+    return true;
+}
+
+bool texture_atlas::fit(const page &p, int width, int height, int &out_x, int &out_y, size_t &out_index) const {
+    int best_y = _desc.height;
+    int best_x = 0;
+    size_t best_index = p.skyline.size();
+    for (size_t i = 0; i < p.skyline.size(); i++) {
+        const int x = p.skyline[i].x;
+        if (x + width > _desc.width) {
+            break;
+        }
+
+        // highest segment under the rect
+        int y = 0;
+        int remaining = width;
+        for (size_t j = i; remaining > 0; j++) {
+            y = std::max(y, p.skyline[j].y);
+            remaining -= p.skyline[j].width;
+        }
+        if (y + height <= _desc.height && y < best_y) {
+            best_y = y;
+            best_x = x;
+            best_index = i;
+        }
+    }
+    if (best_index == p.skyline.size()) {
+        return false;
+    }
+    out_x = best_x;
+    out_y = best_y;
+    out_index = best_index;
+    return true;
+}
+
+bool texture_atlas::insert(page &p, int width, int height, int &out_x, int &out_y) {
+    size_t index = 0;
+    if (!fit(p, width, height, out_x, out_y, index)) {
+        return false;
+    }
+
+    // new segment on top of the rect
+    p.skyline.insert(p.skyline.begin() + index, { out_x, out_y + height, width });
+
+    // cut away the segments it covers
+    for (size_t i = index + 1; i < p.skyline.size();) {
+        auto &seg = p.skyline[i];
+        const int end = out_x + width;
+        if (seg.x >= end) {
+            break;
+        }
+        const int shrink = end - seg.x;
+        if (seg.width <= shrink) {
+            p.skyline.erase(p.skyline.begin() + i);
+            continue;
+        }
+        seg.x += shrink;
+        seg.width -= shrink;
+        break;
+    }
+
+    // merge neighbours at the same height
+    for (size_t i = 0; i + 1 < p.skyline.size();) {
+        if (p.skyline[i].y == p.skyline[i + 1].y) {
+            p.skyline[i].width += p.skyline[i + 1].width;
+            p.skyline.erase(p.skyline.begin() + i + 1);
+        }
+        else {
+            i++;
+        }
+    }
+    return true;
+}
+
+bool texture_atlas::repack(int page_index) {
+    auto &p = _pages[page_index];
+    const uint64_t frame = frame_index();
+
+    // split into old and young entries, tallest first packs best
+    std::vector<uint32_t> entries, evicted;
+    for (uint32_t i = 0; i < _slots.size(); i++) {
+        const auto &s = _slots[i];
+        if (!s.used || s.page != page_index) {
+            continue;
+        }
+        if (s.last_used + static_cast<uint64_t>(_desc.min_eviction_age) <= frame) {
+            evicted.push_back(i);
+        }
+        else {
+            entries.push_back(i);
+        }
+    }
+    std::sort(entries.begin(), entries.end(), [this](uint32_t a, uint32_t b) {
+        return _slots[a].height > _slots[b].height;
+    });
+
+    // place the young entries on an empty skyline first
+    page packed{};
+    packed.skyline.push_back({ 0, 0, _desc.width });
+    std::vector<segment> positions(entries.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+        const auto &s = _slots[entries[i]];
+        if (!insert(packed, s.width + _desc.padding, s.height + _desc.padding, positions[i].x, positions[i].y)) {
+            return false;
+        }
+    }
+
+    for (const uint32_t i : evicted) {
+        _slots[i].used = false;
+        _free_slots.push_back(i);
+        _stats.num_entries--;
+        _stats.num_evictions++;
+    }
+
+    // move pixels from the old copy
+    std::vector<uint8_t> old_pixels(p.pixels.size(), 0);
+    old_pixels.swap(p.pixels);
+    p.skyline.swap(packed.skyline);
+    p.used_area = 0;
+    p.dirty = true;
+
+    const int pitch = _desc.width * _bpp;
+    for (size_t i = 0; i < entries.size(); i++) {
+        auto &s = _slots[entries[i]];
+        const int x = positions[i].x, y = positions[i].y;
+        blit(p, x, y, s.width, s.height, &old_pixels[static_cast<size_t>(s.y) * pitch + static_cast<size_t>(s.x) * _bpp], pitch);
+        p.used_area += static_cast<int64_t>(s.width) * s.height;
+        s.x = x;
+        s.y = y;
+    }
+    _stats.num_repacks++;
+    return true;
+}
+
+void texture_atlas::blit(page &p, int x, int y, int width, int height, const uint8_t *pixels, int pitch) {
+    const size_t page_pitch = static_cast<size_t>(_desc.width) * _bpp;
+    const size_t row_size = static_cast<size_t>(width) * _bpp;
+    for (int row = 0; row < height; row++) {
+        std::memcpy(&p.pixels[(y + row) * page_pitch + static_cast<size_t>(x) * _bpp], pixels + static_cast<size_t>(row) * pitch, row_size);
+    }
+    p.dirty = true;
+}
+
+const texture_atlas::slot *texture_atlas::lookup(atlas_entry entry) const {
+    const uint32_t index = (entry.id & slot_mask);
+    if (index == 0 || index > _slots.size()) {
+        return nullptr;
+    }
+    const auto &s = _slots[index - 1];
+    if (!s.used || s.generation != (entry.id >> slot_bits)) {
+        return nullptr;
+    }
+    return &s;
+}
+
+atlas_region texture_atlas::make_region(const slot &s) const {
+    const float iw = 1.f / _desc.width;
+    const float ih = 1.f / _desc.height;
+    return {
+        _pages[s.page].image,
+        s.page,
+        s.x, s.y, s.width, s.height,
+        s.x * iw, s.y * ih, (s.x + s.width) * iw, (s.y + s.height) * ih,
+    };
+}
+
+} // namespace falcon::gfx
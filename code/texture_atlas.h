@@ -0,0 +1,191 @@
+#ifndef FALCON_TEXTURE_ATLAS_H_
+#define FALCON_TEXTURE_ATLAS_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "sokol_gfx.h"
+
+namespace falcon::gfx {
+
+// atlas entry handle (slot index + generation, 0 is invalid)
+struct atlas_entry {
+    uint32_t id;
+};
+
+// atlas entry location
+struct atlas_region {
+    // page image
+    sg_image image;
+
+    // page index
+    int page;
+
+    // rect in pixels
+    int x, y, width, height;
+
+    // rect in texture coordinates
+    float u0, v0, u1, v1;
+};
+
+// texture atlas description
+struct texture_atlas_desc {
+    // page size
+    int width = 1024;
+    int height = 1024;
+
+    // page limit, entries are evicted when all pages are full
+    int max_pages = 4;
+
+    // RGBA8 or R8
+    sg_pixel_format pixel_format = SG_PIXELFORMAT_RGBA8;
+
+    // empty pixels around each entry
+    int padding = 1;
+
+    // entries used within this many frames are never evicted (at least 1)
+    int min_eviction_age = 2;
+
+    // texture filter
+    sg_filter filter = SG_FILTER_LINEAR;
+
+    // debug label
+    const char *label = nullptr;
+};
+
+// texture atlas statistics
+struct texture_atlas_stats {
+    int num_entries;
+    int num_pages;
+    int num_evictions;
+    int num_repacks;
+    int num_uploads;
+    int64_t uploaded_bytes;
+    double upload_ms;
+
+    // pixels covered by entries / pixels of all pages
+    float efficiency;
+};
+
+// online rectangle packer managing one or more atlas images
+//
+// entries are packed with a skyline bottom-left heuristic into CPU copies of
+// the pages. sokol only allows one update per image and frame, so all entries
+// added during a frame are uploaded together by flush(). when every page is
+// full, the least recently used page drops entries older than
+// min_eviction_age frames and is repacked. pages used in the current frame
+// are never repacked, and an add that would need to evict younger entries
+// fails instead. frames are counted by gfx::frame_index().
+class texture_atlas {
+public:
+    // ctor
+    texture_atlas() = default;
+
+    // dtor
+    ~texture_atlas() { shutdown(); }
+
+    texture_atlas(const texture_atlas &) = delete;
+    texture_atlas &operator=(const texture_atlas &) = delete;
+
+    // setup atlas (pages are created on demand)
+    void setup(const texture_atlas_desc &desc);
+
+    // destroy pages and drop all entries
+    void shutdown();
+
+    // add an image, pixels are tightly packed in the atlas pixel format
+    atlas_entry add(int width, int height, const void *pixels);
+
+    // remove an entry
+    void remove(atlas_entry entry);
+
+    // check entry handle (entries may be evicted)
+    bool valid(atlas_entry entry) const;
+
+    // get entry location and mark it as used this frame
+    atlas_region use(atlas_entry entry);
+
+    // get entry location
+    atlas_region region(atlas_entry entry) const;
+
+    // upload dirty pages, pages already uploaded this frame stay dirty until
+    // the next frame
+    void flush();
+
+    // get page image
+    inline sg_image image(int page) const { return _pages[page].image; }
+
+    // get number of pages
+    inline int num_pages() const { return static_cast<int>(_pages.size()); }
+
+    // get statistics
+    const texture_atlas_stats &stats() const;
+
+private:
+    // skyline segment
+    struct segment {
+        int x, y, width;
+    };
+
+    // page
+    struct page {
+        sg_image image;
+        std::vector<uint8_t> pixels;
+        std::vector<segment> skyline;
+        int64_t used_area;
+        uint64_t last_used;
+        uint64_t uploaded;
+        bool dirty;
+    };
+
+    // entry slot
+    struct slot {
+        uint16_t generation;
+        bool used;
+        int page;
+        int x, y, width, height;
+        uint64_t last_used;
+    };
+
+    // add a page
+    bool add_page();
+
+    // find position in page, returns best y or -1
+    bool fit(const page &p, int width, int height, int &out_x, int &out_y, size_t &out_index) const;
+
+    // insert rect into page skyline
+    bool insert(page &p, int width, int height, int &out_x, int &out_y);
+
+    // drop old entries of a page and pack the rest again, fails without
+    // changes if a younger entry would not fit
+    bool repack(int page_index);
+
+    // copy pixels into page
+    void blit(page &p, int x, int y, int width, int height, const uint8_t *pixels, int pitch);
+
+    // find slot from handle
+    const slot *lookup(atlas_entry entry) const;
+
+    // make region from slot
+    atlas_region make_region(const slot &s) const;
+
+    // description
+    texture_atlas_desc _desc;
+
+    // bytes per pixel
+    int _bpp = 4;
+
+    // pages
+    std::vector<page> _pages;
+
+    // entry slots
+    std::vector<slot> _slots;
+    std::vector<uint32_t> _free_slots;
+
+    // statistics
+    mutable texture_atlas_stats _stats{};
+};
+
+} // namespace falcon::gfx
+
+#endif // FALCON_TEXTURE_ATLAS_H_
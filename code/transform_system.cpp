@@ -0,0 +1,371 @@
+#include "transform_system.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include "sokol_time.h"
+
+namespace {
+
+// handle layout (20 bit slot, 12 bit generation)
+constexpr uint32_t slot_bits = 20;
+constexpr uint32_t slot_mask = (1u << slot_bits) - 1;
+constexpr uint16_t generation_mask = (1u << (32 - slot_bits)) - 1;
+
+inline uint32_t make_id(uint32_t index, uint16_t generation) {
+    return (static_cast<uint32_t>(generation) << slot_bits) | ((index + 1) & slot_mask);
+}
+
+// depth markers during rebuild
+constexpr int depth_unknown = -2;
+constexpr int depth_removed = -1;
+
+// reorder values by order[new] = old
+template <class T>
+void permute(std::vector<T> &values, const std::vector<int> &order, int count) {
+    std::vector<T> sorted(count);
+    for (int i = 0; i < count; i++) {
+        sorted[i] = values[order[i]];
+    }
+    values.swap(sorted);
+}
+
+} // namespace
+
+namespace falcon {
+
+void transform_system::setup(const transform_system_desc &desc) {
+    shutdown();
+
+    _desc = desc;
+    _desc.max_nodes = std::clamp(_desc.max_nodes, 1, static_cast<int>(slot_mask));
+    _desc.chunk_size = std::max(1, _desc.chunk_size);
+
+    _slots.reserve(_desc.max_nodes);
+    _parent.reserve(_desc.max_nodes);
+    _slot.reserve(_desc.max_nodes);
+    _translation.reserve(_desc.max_nodes);
+    _rotation.reserve(_desc.max_nodes);
+    _scale.reserve(_desc.max_nodes);
+    _world.reserve(_desc.max_nodes);
+    _dirty.reserve(_desc.max_nodes);
+}
+
+void transform_system::shutdown() {
+    _slots.clear();
+    _free_slots.clear();
+    _num_alive = 0;
+    _parent.clear();
+    _slot.clear();
+    _translation.clear();
+    _rotation.clear();
+    _scale.clear();
+    _world.clear();
+    _dirty.clear();
+    _levels.clear();
+    _order_stale = false;
+    _any_dirty = false;
+    _stats = {};
+}
+
+transform transform_system::create(transform parent) {
+    if (static_cast<int>(_slot.size()) >= _desc.max_nodes) {
+        return {};
+    }
+
+    uint32_t index;
+    if (!_free_slots.empty()) {
+        index = _free_slots.back();
+        _free_slots.pop_back();
+    } else {
+        index = static_cast<uint32_t>(_slots.size());
+        _slots.push_back({});
+    }
+
+    const int node = static_cast<int>(_slot.size());
+    auto &s = _slots[index];
+    s.node = static_cast<uint32_t>(node);
+    s.parent = lookup(parent);
+    s.generation = static_cast<uint16_t>((s.generation + 1) & generation_mask);
+    if (s.generation == 0) s.generation = 1;
+    s.used = true;
+    s.destroyed = false;
+
+    _parent.push_back(s.parent ? static_cast<int>(_slots[s.parent - 1].node) : -1);
+    _slot.push_back(index);
+    _translation.push_back({ 0.f, 0.f, 0.f });
+    _rotation.push_back(math::quat_identity());
+    _scale.push_back({ 1.f, 1.f, 1.f });
+    _world.push_back(math::mat4_identity());
+    _dirty.push_back(1);
+
+    _num_alive++;
+    _order_stale = true;
+    _any_dirty = true;
+    return { make_id(index, s.generation) };
+}
+
+void transform_system::destroy(transform t) {
+    const uint32_t s = lookup(t);
+    if (s == 0) {
+        return;
+    }
+    _slots[s - 1].destroyed = true;
+    _order_stale = true;
+}
+
+bool transform_system::valid(transform t) const {
+    return lookup(t) != 0;
+}
+
+bool transform_system::set_parent(transform t, transform parent) {
+    const uint32_t s = lookup(t);
+    if (s == 0) {
+        return false;
+    }
+
+    // reject cycles
+    const uint32_t p = lookup(parent);
+    for (uint32_t i = p; i != 0; i = _slots[i - 1].parent) {
+        if (i == s) {
+            return false;
+        }
+    }
+
+    auto &node = _slots[s - 1];
+    if (node.parent != p) {
+        node.parent = p;
+        _dirty[node.node] = 1;
+        _order_stale = true;
+        _any_dirty = true;
+    }
+    return true;
+}
+
+transform transform_system::parent(transform t) const {
+    const uint32_t s = lookup(t);
+    if (s == 0 || _slots[s - 1].parent == 0) {
+        return {};
+    }
+    const auto &p = _slots[_slots[s - 1].parent - 1];
+    return { make_id(_slots[s - 1].parent - 1, p.generation) };
+}
+
+void transform_system::set_local(transform t, const math::vec3 &translation, const math::quat &rotation, const math::vec3 &scale) {
+    const int i = node_index(t);
+    if (i < 0) {
+        return;
+    }
+    _translation[i] = translation;
+    _rotation[i] = rotation;
+    _scale[i] = scale;
+    _dirty[i] = 1;
+    _any_dirty = true;
+}
+
+void transform_system::set_translation(transform t, const math::vec3 &translation) {
+    const int i = node_index(t);
+    if (i < 0) {
+        return;
+    }
+    _translation[i] = translation;
+    _dirty[i] = 1;
+    _any_dirty = true;
+}
+
+void transform_system::set_rotation(transform t, const math::quat &rotation) {
+    const int i = node_index(t);
+    if (i < 0) {
+        return;
+    }
+    _rotation[i] = rotation;
+    _dirty[i] = 1;
+    _any_dirty = true;
+}
+
+void transform_system::set_scale(transform t, const math::vec3 &scale) {
+    const int i = node_index(t);
+    if (i < 0) {
+        return;
+    }
+    _scale[i] = scale;
+    _dirty[i] = 1;
+    _any_dirty = true;
+}
+
+math::vec3 transform_system::translation(transform t) const {
+    const int i = node_index(t);
+    return (i < 0) ? math::vec3{ 0.f, 0.f, 0.f } : _translation[i];
+}
+
+math::quat transform_system::rotation(transform t) const {
+    const int i = node_index(t);
+    return (i < 0) ? math::quat_identity() : _rotation[i];
+}
+
+math::vec3 transform_system::scale(transform t) const {
+    const int i = node_index(t);
+    return (i < 0) ? math::vec3{ 1.f, 1.f, 1.f } : _scale[i];
+}
+
+const math::mat4 &transform_system::world(transform t) const {
+    static const math::mat4 identity = math::mat4_identity();
+    const int i = node_index(t);
+    return (i < 0) ? identity : _world[i];
+}
+
+void transform_system::update() {
+    const uint64_t start = stm_now();
+    _stats = {};
+
+    if (_order_stale) {
+        rebuild();
+        _stats.num_rebuilds++;
+    }
+
+    if (_any_dirty) {
+        // levels in order, nodes of one level in parallel
+        std::atomic<int> num_updated{ 0 };
+        const int num_levels = static_cast<int>(_levels.size()) - 1;
+        for (int level = 0; level < num_levels; level++) {
+            const int first = _levels[level];
+            const int count = _levels[level + 1] - first;
+            auto fn = [this, first, &num_updated](int begin, int end) {
+                int n = 0;
+                for (int i = first + begin; i < first + end; i++) {
+                    const int p = _parent[i];
+                    if (p >= 0 && _dirty[p]) {
+                        _dirty[i] = 1;
+                    }
+                    if (_dirty[i]) {
+                        const math::mat4 local = math::trs(_translation[i], _rotation[i], _scale[i]);
+                        _world[i] = (p >= 0) ? _world[p] * local : local;
+                        n++;
+                    }
+                }
+                num_updated.fetch_add(n, std::memory_order_relaxed);
+            };
+            if (_desc.jobs) {
+                _desc.jobs->parallel_for(count, _desc.chunk_size, fn);
+            } else {
+                fn(0, count);
+            }
+        }
+        std::fill(_dirty.begin(), _dirty.end(), 0);
+        _any_dirty = false;
+        _stats.num_updated = num_updated.load(std::memory_order_relaxed);
+    }
+
+    _stats.num_nodes = _num_alive;
+    _stats.num_levels = std::max(0, static_cast<int>(_levels.size()) - 1);
+    _stats.update_ms = stm_ms(stm_since(start));
+}
+
+void transform_system::gather(const transform *nodes, int count, void *dst, int stride) const {
+    auto *out = static_cast<uint8_t *>(dst);
+    for (int i = 0; i < count; i++) {
+        std::memcpy(out + static_cast<size_t>(i) * stride, world(nodes[i]).data(), sizeof(math::mat4));
+    }
+}
+
+uint32_t transform_system::lookup(transform t) const {
+    const uint32_t index = (t.id & slot_mask);
+    if (index == 0 || index > _slots.size()) {
+        return 0;
+    }
+    const auto &s = _slots[index - 1];
+    if (!s.used || s.destroyed || s.generation != (t.id >> slot_bits)) {
+        return 0;
+    }
+    return index;
+}
+
+int transform_system::node_index(transform t) const {
+    const uint32_t s = lookup(t);
+    return (s == 0) ? -1 : static_cast<int>(_slots[s - 1].node);
+}
+
+void transform_system::rebuild() {
+    const int count = static_cast<int>(_slot.size());
+
+    // depth of every node, destroyed subtrees are marked removed
+    _depth.assign(count, depth_unknown);
+    _order.clear();
+    for (int i = 0; i < count; i++) {
+        int node = i;
+        while (_depth[node] == depth_unknown) {
+            const auto &s = _slots[_slot[node]];
+            if (s.destroyed) {
+                _depth[node] = depth_removed;
+                break;
+            }
+            if (s.parent == 0) {
+                _depth[node] = 0;
+                break;
+            }
+            _order.push_back(node);
+            node = static_cast<int>(_slots[s.parent - 1].node);
+        }
+        while (!_order.empty()) {
+            const int child = _order.back();
+            _order.pop_back();
+            const int p = static_cast<int>(_slots[_slots[_slot[child]].parent - 1].node);
+            _depth[child] = (_depth[p] < 0) ? depth_removed : _depth[p] + 1;
+        }
+    }
+
+    // free removed slots, count nodes per level
+    int max_depth = -1;
+    for (int i = 0; i < count; i++) {
+        if (_depth[i] == depth_removed) {
+            auto &s = _slots[_slot[i]];
+            s.used = false;
+            s.destroyed = false;
+            _free_slots.push_back(_slot[i]);
+            _num_alive--;
+        } else {
+            max_depth = std::max(max_depth, _depth[i]);
+        }
+    }
+    _levels.assign(max_depth + 2, 0);
+    for (int i = 0; i < count; i++) {
+        if (_depth[i] >= 0) {
+            _levels[_depth[i] + 1]++;
+        }
+    }
+    for (int level = 1; level <= max_depth + 1; level++) {
+        _levels[level] += _levels[level - 1];
+    }
+
+    // counting sort, stable within a level
+    const int alive = _levels.back();
+    std::vector<int> cursor(_levels.begin(), _levels.end() - 1);
+    _order.assign(alive, 0);
+    for (int i = 0; i < count; i++) {
+        if (_depth[i] >= 0) {
+            _order[cursor[_depth[i]]++] = i;
+        }
+    }
+
+    permute(_slot, _order, alive);
+    permute(_translation, _order, alive);
+    permute(_rotation, _order, alive);
+    permute(_scale, _order, alive);
+    permute(_world, _order, alive);
+    permute(_dirty, _order, alive);
+
+    // remap slots and parents to the new order
+    for (int i = 0; i < alive; i++) {
+        _slots[_slot[i]].node = static_cast<uint32_t>(i);
+    }
+    _parent.resize(alive);
+    for (int i = 0; i < alive; i++) {
+        const uint32_t p = _slots[_slot[i]].parent;
+        _parent[i] = p ? static_cast<int>(_slots[p - 1].node) : -1;
+    }
+
+    _order_stale = false;
+}
+
+} // namespace falcon
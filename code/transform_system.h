@@ -0,0 +1,156 @@
+#ifndef FALCON_TRANSFORM_SYSTEM_H_
+#define FALCON_TRANSFORM_SYSTEM_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "job_system.h"
+#include "vecmath.h"
+
+namespace falcon {
+
+// transform handle (slot index + generation, 0 is invalid)
+struct transform {
+    uint32_t id;
+};
+
+// transform system description
+struct transform_system_desc {
+    // node capacity (at most 1M)
+    int max_nodes = 64 * 1024;
+
+    // workers for level updates (null: update on the calling thread)
+    job_system *jobs = nullptr;
+
+    // nodes per job, smaller levels are updated inline
+    int chunk_size = 2048;
+};
+
+// transform system statistics (of the last update)
+struct transform_system_stats {
+    int num_nodes;
+    int num_levels;
+    int num_updated;
+    int num_rebuilds;
+    double update_ms;
+};
+
+// hierarchy of local TRS transforms with cached world matrices
+//
+// nodes are stored as structure of arrays sorted by depth, so every level is
+// a contiguous range and parents always precede their children. update()
+// walks the levels in order and recomputes a world matrix only when the node
+// or its parent changed; the nodes of one level are independent and are
+// split across worker threads. structural changes (create, destroy,
+// set_parent) only mark the order stale, it is rebuilt once by the next
+// update with a counting sort over depth. handles stay valid across rebuilds.
+class transform_system {
+public:
+    // ctor
+    transform_system() = default;
+
+    // dtor
+    ~transform_system() { shutdown(); }
+
+    transform_system(const transform_system &) = delete;
+    transform_system &operator=(const transform_system &) = delete;
+
+    // reserve storage
+    void setup(const transform_system_desc &desc);
+
+    // drop all nodes
+    void shutdown();
+
+    // create a node with identity transform (invalid parent: root)
+    transform create(transform parent = {});
+
+    // destroy a node, its descendants are destroyed by the next update
+    void destroy(transform t);
+
+    // check handle
+    bool valid(transform t) const;
+
+    // change parent (invalid: root), fails if parent is t or one of its descendants
+    bool set_parent(transform t, transform parent);
+
+    // get parent
+    transform parent(transform t) const;
+
+    // set local transform
+    void set_local(transform t, const math::vec3 &translation, const math::quat &rotation, const math::vec3 &scale);
+    void set_translation(transform t, const math::vec3 &translation);
+    void set_rotation(transform t, const math::quat &rotation);
+    void set_scale(transform t, const math::vec3 &scale);
+
+    // get local transform
+    math::vec3 translation(transform t) const;
+    math::quat rotation(transform t) const;
+    math::vec3 scale(transform t) const;
+
+    // get world matrix (as of the last update)
+    const math::mat4 &world(transform t) const;
+
+    // rebuild the order if needed and recompute changed world matrices
+    void update();
+
+    // copy world matrices of nodes to dst + i * stride, e.g. into instance data or uniform staging
+    void gather(const transform *nodes, int count, void *dst, int stride) const;
+
+    // get number of nodes
+    inline int num_nodes() const { return _num_alive; }
+
+    // get statistics
+    inline const transform_system_stats &stats() const { return _stats; }
+
+private:
+    // handle slot
+    struct slot {
+        uint32_t node;
+        uint32_t parent;
+        uint16_t generation;
+        bool used;
+        bool destroyed;
+    };
+
+    // resolve handle to slot index + 1 (0: invalid)
+    uint32_t lookup(transform t) const;
+
+    // resolve handle to node index (-1: invalid)
+    int node_index(transform t) const;
+
+    // remove destroyed subtrees and sort nodes by depth
+    void rebuild();
+
+    // description
+    transform_system_desc _desc;
+
+    // handle slots and free list
+    std::vector<slot> _slots;
+    std::vector<uint32_t> _free_slots;
+    int _num_alive = 0;
+
+    // nodes, sorted by depth after rebuild
+    std::vector<int> _parent;
+    std::vector<uint32_t> _slot;
+    std::vector<math::vec3> _translation;
+    std::vector<math::quat> _rotation;
+    std::vector<math::vec3> _scale;
+    std::vector<math::mat4> _world;
+    std::vector<uint8_t> _dirty;
+
+    // first node of each level, plus end
+    std::vector<int> _levels;
+    bool _order_stale = false;
+    bool _any_dirty = false;
+
+    // rebuild scratch
+    std::vector<int> _depth;
+    std::vector<int> _order;
+
+    // statistics
+    transform_system_stats _stats{};
+};
+
+} // namespace falcon
+
+#endif // FALCON_TRANSFORM_SYSTEM_H_
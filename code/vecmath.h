@@ -0,0 +1,455 @@
+#ifndef FALCON_VECMATH_H_
+#define FALCON_VECMATH_H_
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+// instruction set selection (define FALCON_MATH_NO_SIMD to force scalar code,
+// avx needs -mavx or /arch:AVX, see the FALCON_AVX cmake option)
+#if !defined(FALCON_MATH_NO_SIMD)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FALCON_MATH_SSE 1
+#include <emmintrin.h>
+#endif
+#if defined(__AVX__) && defined(FALCON_MATH_SSE)
+#define FALCON_MATH_AVX 1
+#include <immintrin.h>
+#endif
+#endif
+
+namespace falcon::math {
+
+// constants
+constexpr float pi = 3.14159265358979323846f;
+
+// degrees to radians
+inline float radians(float degrees) { return degrees * (pi / 180.f); }
+
+// 3D vector, layout-compatible with hmm_vec3
+struct vec3 {
+    float x, y, z;
+
+    inline float &operator[](int i) { return (&x)[i]; }
+    inline float operator[](int i) const { return (&x)[i]; }
+};
+
+// 4D vector, layout-compatible with hmm_vec4
+struct alignas(16) vec4 {
+    float x, y, z, w;
+
+    inline float &operator[](int i) { return (&x)[i]; }
+    inline float operator[](int i) const { return (&x)[i]; }
+};
+
+// quaternion (x, y, z: vector part, w: scalar part)
+struct alignas(16) quat {
+    float x, y, z, w;
+};
+
+// 4x4 matrix, column-major, layout-compatible with hmm_mat4 and sokol-shdc mat4 uniforms
+struct alignas(16) mat4 {
+    float m[4][4];
+
+    inline float *operator[](int column) { return m[column]; }
+    inline const float *operator[](int column) const { return m[column]; }
+
+    // get pointer for uniform upload
+    inline const float *data() const { return &m[0][0]; }
+
+    // copy into a layout-compatible type (e.g. hmm_mat4 of a vs_params_t)
+    template <class T>
+    inline void store(T &dst) const {
+        static_assert(sizeof(T) == sizeof(float) * 16, "mat4 store target must hold 16 floats");
+        std::memcpy(&dst, m, sizeof(m));
+    }
+};
+
+static_assert(sizeof(vec3) == 12, "vec3 must be 12 bytes");
+static_assert(sizeof(vec4) == 16, "vec4 must be 16 bytes");
+static_assert(sizeof(mat4) == 64, "mat4 must be 64 bytes");
+
+// ---- vec3 ----
+
+inline vec3 operator+(const vec3 &a, const vec3 &b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+inline vec3 operator-(const vec3 &a, const vec3 &b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+inline vec3 operator-(const vec3 &a) { return { -a.x, -a.y, -a.z }; }
+inline vec3 operator*(const vec3 &a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+inline vec3 operator*(float s, const vec3 &a) { return a * s; }
+inline vec3 operator*(const vec3 &a, const vec3 &b) { return { a.x * b.x, a.y * b.y, a.z * b.z }; }
+inline vec3 &operator+=(vec3 &a, const vec3 &b) { a = a + b; return a; }
+inline vec3 &operator-=(vec3 &a, const vec3 &b) { a = a - b; return a; }
+inline vec3 &operator*=(vec3 &a, float s) { a = a * s; return a; }
+
+inline float dot(const vec3 &a, const vec3 &b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline vec3 cross(const vec3 &a, const vec3 &b) {
+    return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+inline float length(const vec3 &a) { return std::sqrt(dot(a, a)); }
+inline vec3 normalize(const vec3 &a) {
+    const float len = length(a);
+    return len > 0.f ? a * (1.f / len) : a;
+}
+inline vec3 lerp(const vec3 &a, const vec3 &b, float t) { return a + (b - a) * t; }
+
+// ---- vec4 ----
+
+#if defined(FALCON_MATH_SSE)
+inline __m128 load(const vec4 &a) { return _mm_load_ps(&a.x); }
+inline vec4 store(__m128 v) { vec4 r; _mm_store_ps(&r.x, v); return r; }
+
+inline vec4 operator+(const vec4 &a, const vec4 &b) { return store(_mm_add_ps(load(a), load(b))); }
+inline vec4 operator-(const vec4 &a, const vec4 &b) { return store(_mm_sub_ps(load(a), load(b))); }
+inline vec4 operator*(const vec4 &a, float s) { return store(_mm_mul_ps(load(a), _mm_set1_ps(s))); }
+inline vec4 operator*(const vec4 &a, const vec4 &b) { return store(_mm_mul_ps(load(a), load(b))); }
+inline float dot(const vec4 &a, const vec4 &b) {
+    __m128 p = _mm_mul_ps(load(a), load(b));
+    p = _mm_add_ps(p, _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 3, 0, 1)));
+    p = _mm_add_ps(p, _mm_shuffle_ps(p, p, _MM_SHUFFLE(0, 1, 2, 3)));
+    return _mm_cvtss_f32(p);
+}
+#else
+inline vec4 operator+(const vec4 &a, const vec4 &b) { return { a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w }; }
+inline vec4 operator-(const vec4 &a, const vec4 &b) { return { a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w }; }
+inline vec4 operator*(const vec4 &a, float s) { return { a.x * s, a.y * s, a.z * s, a.w * s }; }
+inline vec4 operator*(const vec4 &a, const vec4 &b) { return { a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w }; }
+inline float dot(const vec4 &a, const vec4 &b) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
+#endif
+inline vec4 operator*(float s, const vec4 &a) { return a * s; }
+inline vec4 &operator+=(vec4 &a, const vec4 &b) { a = a + b; return a; }
+inline vec4 &operator-=(vec4 &a, const vec4 &b) { a = a - b; return a; }
+inline vec4 &operator*=(vec4 &a, float s) { a = a * s; return a; }
+
+// ---- quat ----
+
+inline quat quat_identity() { return { 0.f, 0.f, 0.f, 1.f }; }
+
+// rotation around normalized axis, angle in degrees (like HMM_Rotate)
+inline quat quat_axis_angle(const vec3 &axis, float degrees) {
+    const float half = radians(degrees) * .5f;
+    const float s = std::sin(half);
+    return { axis.x * s, axis.y * s, axis.z * s, std::cos(half) };
+}
+
+inline quat operator*(const quat &a, const quat &b) {
+    return {
+        a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+    };
+}
+
+inline float dot(const quat &a, const quat &b) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
+
+inline quat normalize(const quat &q) {
+    const float len = std::sqrt(dot(q, q));
+    const float inv = len > 0.f ? 1.f / len : 0.f;
+    return { q.x * inv, q.y * inv, q.z * inv, q.w * inv };
+}
+
+inline quat conjugate(const quat &q) { return { -q.x, -q.y, -q.z, q.w }; }
+
+// rotate vector
+inline vec3 rotate(const quat &q, const vec3 &v) {
+    const vec3 u{ q.x, q.y, q.z };
+    const vec3 t = cross(u, v) * 2.f;
+    return v + t * q.w + cross(u, t);
+}
+
+// normalized linear interpolation along the shortest arc
+inline quat nlerp(const quat &a, const quat &b, float t) {
+    const float s = dot(a, b) < 0.f ? -1.f : 1.f;
+    return normalize({
+        a.x + (b.x * s - a.x) * t,
+        a.y + (b.y * s - a.y) * t,
+        a.z + (b.z * s - a.z) * t,
+        a.w + (b.w * s - a.w) * t,
+    });
+}
+
+// ---- mat4 ----
+
+inline mat4 mat4_identity() {
+    return { { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { 0, 0, 0, 1 } } };
+}
+
+inline mat4 operator*(const mat4 &a, const mat4 &b) {
+    mat4 r;
+#if defined(FALCON_MATH_SSE)
+    const __m128 a0 = _mm_load_ps(a.m[0]);
+    const __m128 a1 = _mm_load_ps(a.m[1]);
+    const __m128 a2 = _mm_load_ps(a.m[2]);
+    const __m128 a3 = _mm_load_ps(a.m[3]);
+    for (int c = 0; c < 4; c++) {
+        __m128 v = _mm_mul_ps(a0, _mm_set1_ps(b.m[c][0]));
+        v = _mm_add_ps(v, _mm_mul_ps(a1, _mm_set1_ps(b.m[c][1])));
+        v = _mm_add_ps(v, _mm_mul_ps(a2, _mm_set1_ps(b.m[c][2])));
+        v = _mm_add_ps(v, _mm_mul_ps(a3, _mm_set1_ps(b.m[c][3])));
+        _mm_store_ps(r.m[c], v);
+    }
+#else
+    for (int c = 0; c < 4; c++) {
+        for (int row = 0; row < 4; row++) {
+            r.m[c][row] = a.m[0][row] * b.m[c][0] + a.m[1][row] * b.m[c][1]
+                + a.m[2][row] * b.m[c][2] + a.m[3][row] * b.m[c][3];
+        }
+    }
+#endif
+    return r;
+}
+
+inline vec4 operator*(const mat4 &a, const vec4 &v) {
+#if defined(FALCON_MATH_SSE)
+    __m128 r = _mm_mul_ps(_mm_load_ps(a.m[0]), _mm_set1_ps(v.x));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_load_ps(a.m[1]), _mm_set1_ps(v.y)));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_load_ps(a.m[2]), _mm_set1_ps(v.z)));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_load_ps(a.m[3]), _mm_set1_ps(v.w)));
+    return store(r);
+#else
+    vec4 r;
+    for (int row = 0; row < 4; row++) {
+        r[row] = a.m[0][row] * v.x + a.m[1][row] * v.y + a.m[2][row] * v.z + a.m[3][row] * v.w;
+    }
+    return r;
+#endif
+}
+
+// transform point (w = 1, no divide)
+inline vec3 transform_point(const mat4 &a, const vec3 &p) {
+    const vec4 r = a * vec4{ p.x, p.y, p.z, 1.f };
+    return { r.x, r.y, r.z };
+}
+
+// transform direction (w = 0)
+inline vec3 transform_vector(const mat4 &a, const vec3 &v) {
+    const vec4 r = a * vec4{ v.x, v.y, v.z, 0.f };
+    return { r.x, r.y, r.z };
+}
+
+inline mat4 transpose(const mat4 &a) {
+    mat4 r;
+#if defined(FALCON_MATH_SSE)
+    __m128 c0 = _mm_load_ps(a.m[0]), c1 = _mm_load_ps(a.m[1]);
+    __m128 c2 = _mm_load_ps(a.m[2]), c3 = _mm_load_ps(a.m[3]);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    _mm_store_ps(r.m[0], c0);
+    _mm_store_ps(r.m[1], c1);
+    _mm_store_ps(r.m[2], c2);
+    _mm_store_ps(r.m[3], c3);
+#else
+    for (int c = 0; c < 4; c++) {
+        for (int row = 0; row < 4; row++) {
+            r.m[c][row] = a.m[row][c];
+        }
+    }
+#endif
+    return r;
+}
+
+inline mat4 translate(const vec3 &t) {
+    mat4 r = mat4_identity();
+    r.m[3][0] = t.x;
+    r.m[3][1] = t.y;
+    r.m[3][2] = t.z;
+    return r;
+}
+
+inline mat4 scale(const vec3 &s) {
+    mat4 r = mat4_identity();
+    r.m[0][0] = s.x;
+    r.m[1][1] = s.y;
+    r.m[2][2] = s.z;
+    return r;
+}
+
+// rotation matrix from quaternion
+inline mat4 to_mat4(const quat &q) {
+    const float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    const float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    const float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+    return { {
+        { 1.f - 2.f * (yy + zz), 2.f * (xy + wz), 2.f * (xz - wy), 0.f },
+        { 2.f * (xy - wz), 1.f - 2.f * (xx + zz), 2.f * (yz + wx), 0.f },
+        { 2.f * (xz + wy), 2.f * (yz - wx), 1.f - 2.f * (xx + yy), 0.f },
+        { 0.f, 0.f, 0.f, 1.f },
+    } };
+}
+
+// rotation around axis, angle in degrees (like HMM_Rotate)
+inline mat4 rotate(float degrees, const vec3 &axis) {
+    return to_mat4(quat_axis_angle(normalize(axis), degrees));
+}
+
+// translation * rotation * scale
+inline mat4 trs(const vec3 &t, const quat &r, const vec3 &s) {
+    mat4 m = to_mat4(r);
+    for (int i = 0; i < 3; i++) {
+        m.m[0][i] *= s.x;
+        m.m[1][i] *= s.y;
+        m.m[2][i] *= s.z;
+    }
+    m.m[3][0] = t.x;
+    m.m[3][1] = t.y;
+    m.m[3][2] = t.z;
+    return m;
+}
+
+// right-handed perspective projection, fov in degrees, clip z in [-1, 1] (like HMM_Perspective)
+inline mat4 perspective(float fov, float aspect, float near_z, float far_z) {
+    mat4 r{};
+    const float cotangent = 1.f / std::tan(radians(fov) * .5f);
+    r.m[0][0] = cotangent / aspect;
+    r.m[1][1] = cotangent;
+    r.m[2][3] = -1.f;
+    r.m[2][2] = (near_z + far_z) / (near_z - far_z);
+    r.m[3][2] = (2.f * near_z * far_z) / (near_z - far_z);
+    return r;
+}
+
+// right-handed orthographic projection, clip z in [-1, 1]
+inline mat4 orthographic(float left, float right, float bottom, float top, float near_z, float far_z) {
+    mat4 r = mat4_identity();
+    r.m[0][0] = 2.f / (right - left);
+    r.m[1][1] = 2.f / (top - bottom);
+    r.m[2][2] = 2.f / (near_z - far_z);
+    r.m[3][0] = (left + right) / (left - right);
+    r.m[3][1] = (bottom + top) / (bottom - top);
+    r.m[3][2] = (far_z + near_z) / (near_z - far_z);
+    return r;
+}
+
+// right-handed view matrix (like HMM_LookAt)
+inline mat4 look_at(const vec3 &eye, const vec3 &center, const vec3 &up) {
+    const vec3 f = normalize(center - eye);
+    const vec3 s = normalize(cross(f, up));
+    const vec3 u = cross(s, f);
+    return { {
+        { s.x, u.x, -f.x, 0.f },
+        { s.y, u.y, -f.y, 0.f },
+        { s.z, u.z, -f.z, 0.f },
+        { -dot(s, eye), -dot(u, eye), dot(f, eye), 1.f },
+    } };
+}
+
+// general inverse (returns identity for singular matrices)
+inline mat4 inverse(const mat4 &a) {
+    const float *m = a.data();
+    float inv[16];
+    inv[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+    inv[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+    inv[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+    inv[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+    inv[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+    inv[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+    inv[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+    inv[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+    inv[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+    inv[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+    inv[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+    inv[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+    inv[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+    inv[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+    inv[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+    inv[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+    const float det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+    if (det == 0.f) {
+        return mat4_identity();
+    }
+    const float inv_det = 1.f / det;
+    mat4 r;
+    for (int i = 0; i < 16; i++) {
+        (&r.m[0][0])[i] = inv[i] * inv_det;
+    }
+    return r;
+}
+
+// ---- batched ----
+
+// out[i] = a * b[i] (e.g. view-projection times model matrices), out may alias b
+inline void mul_batch(const mat4 &a, const mat4 *b, mat4 *out, size_t count) {
+#if defined(FALCON_MATH_AVX)
+    // two columns per instruction
+    const __m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(a.m[0]));
+    const __m256 a1 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(a.m[1]));
+    const __m256 a2 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(a.m[2]));
+    const __m256 a3 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(a.m[3]));
+    for (size_t i = 0; i < count; i++) {
+        for (int c = 0; c < 4; c += 2) {
+            const __m256 bc = _mm256_loadu_ps(b[i].m[c]);
+            __m256 v = _mm256_mul_ps(a0, _mm256_shuffle_ps(bc, bc, _MM_SHUFFLE(0, 0, 0, 0)));
+            v = _mm256_add_ps(v, _mm256_mul_ps(a1, _mm256_shuffle_ps(bc, bc, _MM_SHUFFLE(1, 1, 1, 1))));
+            v = _mm256_add_ps(v, _mm256_mul_ps(a2, _mm256_shuffle_ps(bc, bc, _MM_SHUFFLE(2, 2, 2, 2))));
+            v = _mm256_add_ps(v, _mm256_mul_ps(a3, _mm256_shuffle_ps(bc, bc, _MM_SHUFFLE(3, 3, 3, 3))));
+            _mm256_storeu_ps(out[i].m[c], v);
+        }
+    }
+#else
+    for (size_t i = 0; i < count; i++) {
+        out[i] = a * b[i];
+    }
+#endif
+}
+
+// out[i] = a * (p[i], 1), out may alias p
+inline void transform_points(const mat4 &a, const vec3 *p, vec3 *out, size_t count) {
+#if defined(FALCON_MATH_SSE)
+    const __m128 a0 = _mm_load_ps(a.m[0]);
+    const __m128 a1 = _mm_load_ps(a.m[1]);
+    const __m128 a2 = _mm_load_ps(a.m[2]);
+    const __m128 a3 = _mm_load_ps(a.m[3]);
+    for (size_t i = 0; i < count; i++) {
+        __m128 v = _mm_add_ps(a3, _mm_mul_ps(a0, _mm_set1_ps(p[i].x)));
+        v = _mm_add_ps(v, _mm_mul_ps(a1, _mm_set1_ps(p[i].y)));
+        v = _mm_add_ps(v, _mm_mul_ps(a2, _mm_set1_ps(p[i].z)));
+        alignas(16) float r[4];
+        _mm_store_ps(r, v);
+        out[i] = { r[0], r[1], r[2] };
+    }
+#else
+    for (size_t i = 0; i < count; i++) {
+        out[i] = transform_point(a, p[i]);
+    }
+#endif
+}
+
+// transform points in structure-of-arrays layout (x, y, z arrays), outputs may alias inputs
+inline void transform_points_soa(const mat4 &a, const float *x, const float *y, const float *z,
+                                 float *out_x, float *out_y, float *out_z, size_t count) {
+    size_t i = 0;
+#if defined(FALCON_MATH_AVX)
+    for (; i + 8 <= count; i += 8) {
+        const __m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i), pz = _mm256_loadu_ps(z + i);
+        for (int row = 0; row < 3; row++) {
+            __m256 v = _mm256_set1_ps(a.m[3][row]);
+            v = _mm256_add_ps(v, _mm256_mul_ps(_mm256_set1_ps(a.m[0][row]), px));
+            v = _mm256_add_ps(v, _mm256_mul_ps(_mm256_set1_ps(a.m[1][row]), py));
+            v = _mm256_add_ps(v, _mm256_mul_ps(_mm256_set1_ps(a.m[2][row]), pz));
+            _mm256_storeu_ps((row == 0 ? out_x : row == 1 ? out_y : out_z) + i, v);
+        }
+    }
+#endif
+#if defined(FALCON_MATH_SSE)
+    for (; i + 4 <= count; i += 4) {
+        const __m128 px = _mm_loadu_ps(x + i), py = _mm_loadu_ps(y + i), pz = _mm_loadu_ps(z + i);
+        for (int row = 0; row < 3; row++) {
+            __m128 v = _mm_set1_ps(a.m[3][row]);
+            v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(a.m[0][row]), px));
+            v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(a.m[1][row]), py));
+            v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(a.m[2][row]), pz));
+            _mm_storeu_ps((row == 0 ? out_x : row == 1 ? out_y : out_z) + i, v);
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        const float px = x[i], py = y[i], pz = z[i];
+        out_x[i] = a.m[0][0] * px + a.m[1][0] * py + a.m[2][0] * pz + a.m[3][0];
+        out_y[i] = a.m[0][1] * px + a.m[1][1] * py + a.m[2][1] * pz + a.m[3][1];
+        out_z[i] = a.m[0][2] * px + a.m[1][2] * py + a.m[2][2] * pz + a.m[3][2];
+    }
+}
+
+} // namespace falcon::math
+
+#endif // FALCON_VECMATH_H_
@@ -0,0 +1,178 @@
+#include "vertex_packing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+using falcon::gfx::vertex_semantic;
+using falcon::gfx::vertex_source;
+
+inline int16_t snorm16(float v) {
+    return static_cast<int16_t>(std::lround(std::clamp(v, -1.f, 1.f) * 32767.f));
+}
+
+inline uint8_t unorm8(float v) {
+    return static_cast<uint8_t>(std::lround(std::clamp(v, 0.f, 1.f) * 255.f));
+}
+
+// sources without data or attribute slot are skipped
+inline bool usable(const vertex_source &src) {
+    return src.data && src.attr >= 0 && src.attr < SG_MAX_VERTEX_ATTRIBUTES;
+}
+
+inline const float *element(const vertex_source &src, int index) {
+    const int stride = src.stride ? src.stride : src.components * static_cast<int>(sizeof(float));
+    return reinterpret_cast<const float *>(reinterpret_cast<const uint8_t *>(src.data) + static_cast<size_t>(index) * stride);
+}
+
+inline int packed_size(vertex_semantic semantic) {
+    return semantic == vertex_semantic::position ? 8 : 4;
+}
+
+inline sg_vertex_format packed_format(vertex_semantic semantic) {
+    switch (semantic) {
+    case vertex_semantic::position: return SG_VERTEXFORMAT_SHORT4N;
+    case vertex_semantic::normal: return SG_VERTEXFORMAT_SHORT2N;
+    case vertex_semantic::color: return SG_VERTEXFORMAT_UBYTE4N;
+    case vertex_semantic::texcoord: return SG_VERTEXFORMAT_SHORT2N;
+    }
+    return SG_VERTEXFORMAT_INVALID;
+}
+
+// center and half extent of n components over all vertices
+void bounds(const vertex_source &src, int num_vertices, int n, float center[3], float extent[3]) {
+    float lo[3] = { 0.f, 0.f, 0.f }, hi[3] = { 0.f, 0.f, 0.f };
+    for (int i = 0; i < num_vertices; i++) {
+        const float *p = element(src, i);
+        for (int c = 0; c < n; c++) {
+            lo[c] = (i == 0) ? p[c] : std::min(lo[c], p[c]);
+            hi[c] = (i == 0) ? p[c] : std::max(hi[c], p[c]);
+        }
+    }
+    for (int c = 0; c < n; c++) {
+        center[c] = (lo[c] + hi[c]) * .5f;
+        extent[c] = std::max((hi[c] - lo[c]) * .5f, 1e-20f);
+    }
+}
+
+} // namespace
+
+namespace falcon::gfx {
+
+void encode_oct(const math::vec3 &n, int16_t out[2]) {
+    const float sum = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    float x = (sum > 0.f) ? n.x / sum : 0.f;
+    float y = (sum > 0.f) ? n.y / sum : 0.f;
+    if (n.z < 0.f) {
+        const float fx = (1.f - std::fabs(y)) * (x >= 0.f ? 1.f : -1.f);
+        const float fy = (1.f - std::fabs(x)) * (y >= 0.f ? 1.f : -1.f);
+        x = fx;
+        y = fy;
+    }
+    out[0] = snorm16(x);
+    out[1] = snorm16(y);
+}
+
+math::vec3 decode_oct(const int16_t in[2]) {
+    const float x = std::max(in[0] / 32767.f, -1.f);
+    const float y = std::max(in[1] / 32767.f, -1.f);
+    math::vec3 n = { x, y, 1.f - std::fabs(x) - std::fabs(y) };
+    const float t = std::max(-n.z, 0.f);
+    n.x += (n.x >= 0.f) ? -t : t;
+    n.y += (n.y >= 0.f) ? -t : t;
+    return math::normalize(n);
+}
+
+packed_vertices pack_vertices(const vertex_pack_desc &desc) {
+    packed_vertices packed;
+    packed.num_vertices = desc.num_vertices;
+    packed.buffer_index = desc.buffer_index;
+    packed.params.position_scale = { 1.f, 1.f, 1.f, 0.f };
+    packed.params.position_offset = { 0.f, 0.f, 0.f, 1.f };
+    packed.params.texcoord_scale_offset = { 1.f, 1.f, 0.f, 0.f };
+
+    // layout from the attribute slots
+    int offsets[SG_MAX_VERTEX_ATTRIBUTES] = {};
+    for (int s = 0; s < desc.num_sources; s++) {
+        const vertex_source &src = desc.sources[s];
+        if (!usable(src)) {
+            continue;
+        }
+        offsets[s] = packed.stride;
+        packed.layout.attrs[src.attr].buffer_index = desc.buffer_index;
+        packed.layout.attrs[src.attr].offset = packed.stride;
+        packed.layout.attrs[src.attr].format = packed_format(src.semantic);
+        packed.stride += packed_size(src.semantic);
+        packed.source_stride += src.components * static_cast<int>(sizeof(float));
+    }
+    packed.layout.buffers[desc.buffer_index].stride = packed.stride;
+    packed.data.resize(static_cast<size_t>(packed.stride) * desc.num_vertices);
+
+    for (int s = 0; s < desc.num_sources; s++) {
+        const vertex_source &src = desc.sources[s];
+        if (!usable(src)) {
+            continue;
+        }
+        uint8_t *dst = packed.data.data() + offsets[s];
+        switch (src.semantic) {
+        case vertex_semantic::position: {
+            const int n = std::min(src.components, 3);
+            float center[3] = { 0.f, 0.f, 0.f }, extent[3] = { 1.f, 1.f, 1.f };
+            bounds(src, desc.num_vertices, n, center, extent);
+            for (int i = 0; i < desc.num_vertices; i++, dst += packed.stride) {
+                const float *p = element(src, i);
+                int16_t q[4] = { 0, 0, 0, 0 };
+                for (int c = 0; c < n; c++) {
+                    q[c] = snorm16((p[c] - center[c]) / extent[c]);
+                }
+                std::memcpy(dst, q, sizeof(q));
+            }
+            packed.params.position_scale = { extent[0], extent[1], n > 2 ? extent[2] : 0.f, 0.f };
+            packed.params.position_offset = { center[0], center[1], n > 2 ? center[2] : 0.f, 1.f };
+            break;
+        }
+        case vertex_semantic::normal:
+            for (int i = 0; i < desc.num_vertices; i++, dst += packed.stride) {
+                const float *p = element(src, i);
+                int16_t q[2];
+                encode_oct({ p[0], p[1], p[2] }, q);
+                std::memcpy(dst, q, sizeof(q));
+            }
+            break;
+        case vertex_semantic::color:
+            for (int i = 0; i < desc.num_vertices; i++, dst += packed.stride) {
+                const float *p = element(src, i);
+                dst[0] = unorm8(p[0]);
+                dst[1] = unorm8(p[1]);
+                dst[2] = unorm8(p[2]);
+                dst[3] = (src.components > 3) ? unorm8(p[3]) : 255;
+            }
+            break;
+        case vertex_semantic::texcoord: {
+            float center[3] = { 0.f, 0.f, 0.f }, extent[3] = { 1.f, 1.f, 1.f };
+            bounds(src, desc.num_vertices, 2, center, extent);
+            for (int i = 0; i < desc.num_vertices; i++, dst += packed.stride) {
+                const float *p = element(src, i);
+                const int16_t q[2] = { snorm16((p[0] - center[0]) / extent[0]), snorm16((p[1] - center[1]) / extent[1]) };
+                std::memcpy(dst, q, sizeof(q));
+            }
+            packed.params.texcoord_scale_offset = { extent[0], extent[1], center[0], center[1] };
+            break;
+        }
+        }
+    }
+    return packed;
+}
+
+void configure_layout(sg_pipeline_desc &desc, const packed_vertices &packed) {
+    for (int i = 0; i < SG_MAX_VERTEX_ATTRIBUTES; i++) {
+        if (packed.layout.attrs[i].format != SG_VERTEXFORMAT_INVALID) {
+            desc.layout.attrs[i] = packed.layout.attrs[i];
+        }
+    }
+    desc.layout.buffers[packed.buffer_index].stride = packed.stride;
+}
+
+} // namespace falcon::gfx
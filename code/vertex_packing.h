@@ -0,0 +1,101 @@
+#ifndef FALCON_VERTEX_PACKING_H_
+#define FALCON_VERTEX_PACKING_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "sokol_gfx.h"
+#include "vecmath.h"
+
+namespace falcon::gfx {
+
+// meaning of a source attribute, selects its packed format
+enum class vertex_semantic : uint8_t {
+    // float2/3 -> SHORT4N, remapped to the mesh bounds (8 bytes)
+    position,
+
+    // float3 -> octahedral SHORT2N (4 bytes)
+    normal,
+
+    // float3/4 in [0, 1] -> UBYTE4N (4 bytes)
+    color,
+
+    // float2 -> SHORT2N, remapped to the uv bounds (4 bytes)
+    texcoord,
+};
+
+// one float source stream
+struct vertex_source {
+    vertex_semantic semantic = vertex_semantic::position;
+
+    // shader attribute slot (the ATTR_vs_* constant generated by sokol-shdc)
+    int attr = -1;
+
+    // float data, component count and stride in bytes (0 = tightly packed)
+    const float *data = nullptr;
+    int components = 3;
+    int stride = 0;
+};
+
+// vertex packing description
+struct vertex_pack_desc {
+    // source streams, in the order they are interleaved
+    vertex_source sources[SG_MAX_VERTEX_ATTRIBUTES];
+    int num_sources = 0;
+
+    // vertex count
+    int num_vertices = 0;
+
+    // vertex buffer slot of the packed stream
+    int buffer_index = 0;
+};
+
+// dequantization constants, upload them as a vertex shader uniform block:
+//
+//   pos    = position.xyz * position_scale.xyz + position_offset.xyz
+//   normal = oct_decode(normal.xy)
+//   uv     = texcoord.xy * texcoord_scale_offset.xy + texcoord_scale_offset.zw
+//
+// with oct_decode(e) { vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+//   float t = max(-n.z, 0.0); n.xy += mix(vec2(t), vec2(-t), step(0.0, n.xy));
+//   return normalize(n); }
+struct vertex_pack_params {
+    math::vec4 position_scale;
+    math::vec4 position_offset;
+    math::vec4 texcoord_scale_offset;
+};
+
+// interleaved packed vertices with their pipeline layout
+struct packed_vertices {
+    std::vector<uint8_t> data;
+    int num_vertices = 0;
+
+    // packed and float vertex size in bytes
+    int stride = 0;
+    int source_stride = 0;
+
+    // shader constants
+    vertex_pack_params params{};
+
+    // attribute formats and offsets for the packed stream
+    sg_layout_desc layout{};
+    int buffer_index = 0;
+};
+
+// pack float streams into one interleaved buffer of normalized integer formats
+//
+// only the portable normalized formats (SHORT2N, SHORT4N, UBYTE4N) are used,
+// so the layout works on every backend.
+packed_vertices pack_vertices(const vertex_pack_desc &desc);
+
+// copy the packed attributes and buffer stride into a pipeline layout, other
+// attributes and buffers (e.g. an instance stream) are left alone
+void configure_layout(sg_pipeline_desc &desc, const packed_vertices &packed);
+
+// octahedral normal encoding into two snorm16 values and back
+void encode_oct(const math::vec3 &n, int16_t out[2]);
+math::vec3 decode_oct(const int16_t in[2]);
+
+} // namespace falcon::gfx
+
+#endif // FALCON_VERTEX_PACKING_H_
@@ -0,0 +1,144 @@
+#include <stdio.h>  /* printf() */
+#include <stdlib.h> /* atoi(), malloc(), free() */
+
+#include "sokol_args.h"
+#include "sokol_time.h"
+
+#include "falcon.h"
+
+#define DEFAULT_NUM_ALLOCS (10000)
+#define CHUNK_SIZE (1000)
+
+namespace {
+
+/* small deterministic generator, independent of rand() and the replay seed */
+uint32_t next_random(uint32_t &state) {
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+class app : public falcon::application {
+    void configure(sapp_desc &desc) override {
+        desc.width = 800;
+        desc.height = 600;
+        desc.window_title = "Allocator Benchmark (falcon app)";
+        desc.swap_interval = 0;
+
+        _num_allocs = atoi(sargs_value_def("allocs", "10000"));
+        if (_num_allocs <= 0) {
+            _num_allocs = DEFAULT_NUM_ALLOCS;
+        }
+        _report_time = 0.0;
+        _frame_count = 0;
+    }
+
+    void init() override {
+        _pass_action = falcon::gfx::make_pass_action_clear(0.0f, 0.0f, 0.0f);
+
+        /* mostly small blocks as sokol and containers allocate them */
+        uint32_t state = 1;
+        _sizes.resize(_num_allocs);
+        for (int i = 0; i < _num_allocs; i++) {
+            const uint32_t r = next_random(state);
+            _sizes[i] = (r % 8 == 0) ? 1024 + r % 4096 : 8 + r % 480;
+        }
+        _blocks.resize(_num_allocs);
+        printf("backend: %s, %d allocations per pass\n", falcon_memory_backend(), _num_allocs);
+    }
+
+    void frame() override {
+        const falcon_memory_stats before = falcon_memory_query(FALCON_MEMORY_TAG_APP);
+
+        /* single thread */
+        uint64_t start = stm_now();
+        run(0, _num_allocs, true);
+        const double falcon_ms = stm_ms(stm_since(start));
+        start = stm_now();
+        run(0, _num_allocs, false);
+        const double malloc_ms = stm_ms(stm_since(start));
+
+        /* worker threads, each chunk allocates and frees its own blocks */
+        start = stm_now();
+        jobs().parallel_for(_num_allocs, CHUNK_SIZE, [this](int begin, int end) { run(begin, end, true); });
+        const double falcon_parallel_ms = stm_ms(stm_since(start));
+        start = stm_now();
+        jobs().parallel_for(_num_allocs, CHUNK_SIZE, [this](int begin, int end) { run(begin, end, false); });
+        const double malloc_parallel_ms = stm_ms(stm_since(start));
+
+        const falcon_memory_stats after = falcon_memory_query(FALCON_MEMORY_TAG_APP);
+        if (after.live_bytes != before.live_bytes) {
+            printf("leak: %lld bytes\n", (long long)(after.live_bytes - before.live_bytes));
+        }
+        bench().check(after.live_bytes == before.live_bytes, "tagged allocations leaked");
+
+        falcon::gfx::begin(_pass_action, width(), height());
+
+        /* medians of a bench_frames run, compared relative to malloc in the same frame */
+        bench().note("falcon_ms", falcon_ms);
+        bench().note("malloc_ms", malloc_ms);
+        bench().note("falcon_parallel_ms", falcon_parallel_ms);
+        bench().note("malloc_parallel_ms", malloc_parallel_ms);
+        bench().add("falcon_ratio", falcon_ms / malloc_ms);
+        bench().add("falcon_parallel_ratio", falcon_parallel_ms / malloc_parallel_ms);
+
+        /* report once per second */
+        _falcon_time += falcon_ms;
+        _malloc_time += malloc_ms;
+        _falcon_parallel_time += falcon_parallel_ms;
+        _malloc_parallel_time += malloc_parallel_ms;
+        _frame_count++;
+        _report_time += delta_time();
+        if (_report_time >= 1.0) {
+            const double n = (double)_frame_count;
+            printf("%d allocs: falcon %.3f ms, malloc %.3f ms, %d threads: falcon %.3f ms, malloc %.3f ms\n",
+                _num_allocs, _falcon_time / n, _malloc_time / n, jobs().num_threads(),
+                _falcon_parallel_time / n, _malloc_parallel_time / n);
+            _falcon_time = 0.0;
+            _malloc_time = 0.0;
+            _falcon_parallel_time = 0.0;
+            _malloc_parallel_time = 0.0;
+            _report_time = 0.0;
+            _frame_count = 0;
+        }
+    }
+
+    /* allocate and touch blocks [begin, end), free every other one, then the rest backwards */
+    void run(int begin, int end, bool tagged) {
+        for (int i = begin; i < end; i++) {
+            void *p = tagged ? falcon_malloc(FALCON_MEMORY_TAG_APP, _sizes[i]) : malloc(_sizes[i]);
+            *(volatile uint8_t *)p = (uint8_t)i;
+            _blocks[i] = p;
+        }
+        for (int i = begin; i < end; i += 2) {
+            release(_blocks[i], tagged);
+        }
+        for (int i = end - 1 - ((end - begin) % 2 == 0 ? 0 : 1); i > begin; i -= 2) {
+            release(_blocks[i], tagged);
+        }
+    }
+
+    static void release(void *p, bool tagged) {
+        if (tagged) {
+            falcon_free(p);
+        }
+        else {
+            free(p);
+        }
+    }
+
+    int _num_allocs;
+    double _report_time;
+    int _frame_count;
+    double _falcon_time = 0.0;
+    double _malloc_time = 0.0;
+    double _falcon_parallel_time = 0.0;
+    double _malloc_parallel_time = 0.0;
+
+    falcon::gfx::pass_action _pass_action;
+    std::vector<size_t> _sizes;
+    std::vector<void *> _blocks;
+};
+
+} // namespace
+
+FALCON_MAIN(::app);
@@ -5,7 +5,60 @@ set(FALCON_INCLUDE_DIR ${FALCON_PATH})
 # library: falcon
 add_library(falcon STATIC)
 target_include_directories(falcon PUBLIC ${FALCON_INCLUDE_DIR})
-target_sources(falcon PRIVATE ${FALCON_PATH}/application.cpp)
+target_sources(falcon PRIVATE
+    ${FALCON_PATH}/application.cpp
+    ${FALCON_PATH}/bench_report.cpp
+    ${FALCON_PATH}/creation_queue.cpp
+    ${FALCON_PATH}/culling.cpp
+    ${FALCON_PATH}/debug_draw.cpp
+    ${FALCON_PATH}/frame_arena.cpp
+    ${FALCON_PATH}/frame_pacer.cpp
+    ${FALCON_PATH}/gltf_loader.cpp
+    ${FALCON_PATH}/input.cpp
+    ${FALCON_PATH}/input_recorder.cpp
+    ${FALCON_PATH}/instance_batch.cpp
+    ${FALCON_PATH}/job_system.cpp
+    ${FALCON_PATH}/mesh_arena.cpp
+    ${FALCON_PATH}/mesh_lod.cpp
+    ${FALCON_PATH}/mesh_optimizer.cpp
+    ${FALCON_PATH}/occlusion_culler.cpp
+    ${FALCON_PATH}/spatial_index.cpp
+    ${FALCON_PATH}/sprite_batch.cpp
+    ${FALCON_PATH}/text_renderer.cpp
+    ${FALCON_PATH}/texture_atlas.cpp
+    ${FALCON_PATH}/transform_system.cpp
+    ${FALCON_PATH}/vertex_packing.cpp
+)
+
+# avx paths in vecmath.h (public, inline code must match across targets)
+option(FALCON_AVX "Compile with AVX (binaries require an AVX capable cpu)" OFF)
+if(FALCON_AVX)
+    if(MSVC)
+        target_compile_options(falcon PUBLIC /arch:AVX)
+    else()
+        target_compile_options(falcon PUBLIC -mavx)
+    endif()
+endif()
+
+# test runs without a window: sokol_gfx dummy backend, sokol_app entry
+# points from headless.cpp (public, examples see the backend define too)
+option(FALCON_HEADLESS "Build without a window and GPU for test runs (sokol_gfx dummy backend)" OFF)
+if(FALCON_HEADLESS)
+    target_sources(falcon PRIVATE ${FALCON_PATH}/headless.cpp)
+endif()
+
+# library: falcon_memory (sokol allocates through it)
+set(FALCON_MEMORY_BACKEND "tracking" CACHE STRING "Memory backend: tracking, pool or system")
+set_property(CACHE FALCON_MEMORY_BACKEND PROPERTY STRINGS tracking pool system)
+option(FALCON_MEMORY_TRACK_NEW "Charge global new/delete to the app memory tag" OFF)
+add_library(falcon_memory STATIC)
+target_include_directories(falcon_memory PUBLIC ${FALCON_INCLUDE_DIR})
+target_sources(falcon_memory PRIVATE ${FALCON_PATH}/allocator.cpp)
+string(TOUPPER ${FALCON_MEMORY_BACKEND} FALCON_MEMORY_BACKEND_DEFINE)
+target_compile_definitions(falcon_memory PRIVATE FALCON_MEMORY_BACKEND_${FALCON_MEMORY_BACKEND_DEFINE})
+if(FALCON_MEMORY_TRACK_NEW)
+    target_compile_definitions(falcon_memory PRIVATE FALCON_MEMORY_TRACK_NEW)
+endif()
 
 # link sokol
 include(cmake/sokol.cmake)
@@ -8,23 +8,35 @@ target_include_directories(sokol PUBLIC ${SOKOL_INCLUDE_DIR} ${X11_INCLUDE_DIR})
 target_sources(sokol PRIVATE ${CMAKE_SOURCE_DIR}/sokol.c)
 
 # link libraries
-find_package(X11 REQUIRED)
 find_package(Threads REQUIRED)
-find_package(OpenGL REQUIRED)
 find_package(ALSA REQUIRED)
 target_link_libraries(sokol PUBLIC
-    ${X11_LIBRARIES}
-    ${X11_Xcursor_LIB}
-    ${X11_Xinput_LIB}
     Threads::Threads
-    OpenGL::OpenGL
     ${ALSA_LIBRARIES}
     ${CMAKE_DL_LIBS}
     ${CMAKE_M_LIBS}
+    falcon_memory
 )
 
-# TODO: renderer
-target_compile_definitions(sokol PUBLIC SOKOL_GLCORE33)
+if(FALCON_HEADLESS)
+    # no window or GL, sokol_app and sokol_glue are not compiled
+    target_compile_definitions(sokol PUBLIC SOKOL_DUMMY_BACKEND FALCON_HEADLESS)
+else()
+    find_package(X11 REQUIRED)
+    find_package(OpenGL REQUIRED)
+    target_link_libraries(sokol PUBLIC
+        ${X11_LIBRARIES}
+        ${X11_Xcursor_LIB}
+        ${X11_Xinput_LIB}
+        OpenGL::OpenGL
+    )
+
+    # TODO: renderer
+    target_compile_definitions(sokol PUBLIC SOKOL_GLCORE33)
+endif()
+
+# FALCON_MAIN defines main() and returns the exit status of the app
+target_compile_definitions(sokol PUBLIC SOKOL_NO_ENTRY)
 
 # vars
 set(SOKOL_LIBRARIES sokol)
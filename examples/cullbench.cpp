@@ -0,0 +1,179 @@
+#include <stdio.h>  /* printf() */
+#include <stdlib.h> /* atoi(), rand() */
+#include <string.h> /* memcmp() */
+
+#include "sokol_args.h"
+#include "sokol_time.h"
+
+#include "falcon.h"
+
+#define NUM_SIZES (3)
+#define MIN_OBJECTS_PER_FRAME (1000000)
+
+namespace {
+
+// object counts benchmarked when no objects= argument is given
+const int default_sizes[NUM_SIZES] = { 10000, 100000, 1000000 };
+
+class app : public falcon::application {
+    void configure(sapp_desc &desc) override {
+        desc.width = 800;
+        desc.height = 600;
+        desc.window_title = "Culling Benchmark (falcon app)";
+        desc.swap_interval = 0;
+
+        const int objects = atoi(sargs_value_def("objects", "0"));
+        for (int i = 0; i < NUM_SIZES; i++) {
+            _sizes[i] = (objects > 0) ? objects : default_sizes[i];
+        }
+        _num_sizes = (objects > 0) ? 1 : NUM_SIZES;
+        _angle = 0.f;
+        _report_time = 0.0;
+        _frame_count = 0;
+    }
+
+    void init() override {
+        _pass_action = falcon::gfx::make_pass_action_clear(0.0f, 0.0f, 0.0f);
+
+        // random spheres in a 200^3 cube, stored both as SoA and AoS
+        const int count = _sizes[_num_sizes - 1];
+        _x.resize(count);
+        _y.resize(count);
+        _z.resize(count);
+        _r.resize(count);
+        _aos.resize(count);
+        for (int i = 0; i < count; i++) {
+            _x[i] = (rand() / (float)RAND_MAX - 0.5f) * 200.0f;
+            _y[i] = (rand() / (float)RAND_MAX - 0.5f) * 200.0f;
+            _z[i] = (rand() / (float)RAND_MAX - 0.5f) * 200.0f;
+            _r[i] = 0.5f + rand() / (float)RAND_MAX;
+            _aos[i] = { _x[i], _y[i], _z[i], _r[i] };
+        }
+        _naive_visible.resize(count);
+
+        falcon::frustum_culler_desc culler_desc;
+        _single.setup(culler_desc);
+        culler_desc.jobs = &jobs();
+        _parallel.setup(culler_desc);
+    }
+
+    void frame() override {
+        using namespace falcon::math;
+        _angle += 0.5f;
+        const mat4 proj = perspective(60.0f, (float)width() / (float)height(), 0.1f, 150.0f);
+        const mat4 view = look_at({ 0.0f, 0.0f, 0.0f }, { std::sin(radians(_angle)), 0.0f, std::cos(radians(_angle)) }, { 0.0f, 1.0f, 0.0f });
+        const falcon::frustum f = falcon::make_frustum(proj * view);
+
+        const falcon::sphere_soa spheres = { _x.data(), _y.data(), _z.data(), _r.data() };
+        for (int s = 0; s < _num_sizes; s++) {
+            const int count = _sizes[s];
+
+            /* small sets are culled repeatedly, times are per cull */
+            const int repeats = (count < MIN_OBJECTS_PER_FRAME) ? MIN_OBJECTS_PER_FRAME / count : 1;
+
+            /* naive: array of structs, one object and plane at a time */
+            uint64_t start = stm_now();
+            int visible = 0;
+            for (int r = 0; r < repeats; r++) {
+                visible = 0;
+                for (int i = 0; i < count; i++) {
+                    const sphere &o = _aos[i];
+                    bool inside = true;
+                    for (int p = 0; p < 6 && inside; p++) {
+                        inside = dot(vec3{ f.planes[p].x, f.planes[p].y, f.planes[p].z }, vec3{ o.x, o.y, o.z }) + f.planes[p].w >= -o.r;
+                    }
+                    if (inside) {
+                        _naive_visible[visible++] = (uint32_t)i;
+                    }
+                }
+            }
+            const double naive_ms = stm_ms(stm_since(start)) / repeats;
+            _naive_time[s] += naive_ms;
+            _num_visible[s] = visible;
+
+            /* SoA + SIMD, single thread */
+            double simd_ms = 0.0;
+            for (int r = 0; r < repeats; r++) {
+                _single.cull(f, spheres, count);
+                simd_ms += _single.stats().cull_ms / repeats;
+            }
+            _single_time[s] += simd_ms;
+
+            /* SoA + SIMD, worker threads */
+            double parallel_ms = 0.0;
+            for (int r = 0; r < repeats; r++) {
+                _parallel.cull(f, spheres, count);
+                parallel_ms += _parallel.stats().cull_ms / repeats;
+            }
+            _parallel_time[s] += parallel_ms;
+
+            /* medians of a bench_frames run, per object count, compared relative to naive */
+            char name[64];
+            snprintf(name, sizeof(name), "naive_%d_ms", count);
+            bench().note(name, naive_ms);
+            snprintf(name, sizeof(name), "simd_%d_ms", count);
+            bench().note(name, simd_ms);
+            snprintf(name, sizeof(name), "parallel_%d_ms", count);
+            bench().note(name, parallel_ms);
+            snprintf(name, sizeof(name), "simd_%d_ratio", count);
+            bench().add(name, simd_ms / naive_ms);
+            snprintf(name, sizeof(name), "parallel_%d_ratio", count);
+            bench().add(name, parallel_ms / naive_ms);
+
+            if ((int)_parallel.visible().size() != visible || (int)_single.visible().size() != visible) {
+                printf("mismatch at %d objects: naive %d, simd %d, parallel %d\n",
+                    count, visible, (int)_single.visible().size(), (int)_parallel.visible().size());
+            }
+            /* chunks are compacted in order, so all lists are sorted like the naive one */
+            const bool same_single = (int)_single.visible().size() == visible &&
+                memcmp(_single.visible().data(), _naive_visible.data(), visible * sizeof(uint32_t)) == 0;
+            const bool same_parallel = (int)_parallel.visible().size() == visible &&
+                memcmp(_parallel.visible().data(), _naive_visible.data(), visible * sizeof(uint32_t)) == 0;
+            bench().check(same_single, "simd culling differs from naive");
+            bench().check(same_parallel, "parallel culling differs from naive");
+        }
+
+        falcon::gfx::begin(_pass_action, width(), height());
+
+        /* report once per second */
+        _frame_count++;
+        _report_time += delta_time();
+        if (_report_time >= 1.0) {
+            for (int s = 0; s < _num_sizes; s++) {
+                printf("objects: %d, visible: %d, naive: %.3f ms, simd: %.3f ms, simd + %d threads: %.3f ms\n",
+                    _sizes[s], _num_visible[s], _naive_time[s] / _frame_count, _single_time[s] / _frame_count,
+                    jobs().num_threads(), _parallel_time[s] / _frame_count);
+                _naive_time[s] = 0.0;
+                _single_time[s] = 0.0;
+                _parallel_time[s] = 0.0;
+            }
+            _report_time = 0.0;
+            _frame_count = 0;
+        }
+    }
+
+    struct sphere {
+        float x, y, z, r;
+    };
+
+    int _sizes[NUM_SIZES];
+    int _num_sizes;
+    float _angle;
+    double _report_time;
+    int _frame_count;
+    int _num_visible[NUM_SIZES] = {};
+    double _naive_time[NUM_SIZES] = {};
+    double _single_time[NUM_SIZES] = {};
+    double _parallel_time[NUM_SIZES] = {};
+
+    falcon::gfx::pass_action _pass_action;
+    std::vector<float> _x, _y, _z, _r;
+    std::vector<sphere> _aos;
+    std::vector<uint32_t> _naive_visible;
+    falcon::frustum_culler _single;
+    falcon::frustum_culler _parallel;
+};
+
+} // namespace
+
+FALCON_MAIN(::app);
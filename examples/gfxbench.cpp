@@ -0,0 +1,319 @@
+#include <stdio.h>  /* printf() */
+#include <stdlib.h> /* atoi() */
+#include <string.h> /* strcmp() */
+
+#include "sokol_args.h"
+#include "sokol_time.h"
+
+#include "falcon.h"
+
+#define NUM_BUILDS (10000)
+#define NUM_PIPELINES (2)
+#define NUM_MESHES (2)
+#define NUM_MATERIALS (4)
+#define NUM_GROUPS (NUM_PIPELINES * NUM_MESHES * NUM_MATERIALS)
+
+#if defined(SOKOL_GLES3)
+#define GLSL_VERSION "#version 300 es\nprecision highp float;\n"
+#else
+#define GLSL_VERSION "#version 330\n"
+#endif
+
+namespace {
+
+/* per-vertex position, per-instance transform rows in slots 1..4 */
+const char *vs_source =
+    GLSL_VERSION
+    "uniform vec4 color;\n"
+    "layout(location=0) in vec2 pos;\n"
+    "layout(location=1) in vec4 row0;\n"
+    "layout(location=2) in vec4 row1;\n"
+    "layout(location=3) in vec4 row2;\n"
+    "layout(location=4) in vec4 row3;\n"
+    "out vec4 frag;\n"
+    "void main() {\n"
+    "    gl_Position = mat4(row0, row1, row2, row3) * vec4(pos, 0.0, 1.0);\n"
+    "    frag = color;\n"
+    "}\n";
+
+const char *fs_source =
+    GLSL_VERSION
+    "in vec4 frag;\n"
+    "out vec4 frag_color;\n"
+    "void main() {\n"
+    "    frag_color = frag;\n"
+    "}\n";
+
+/* small deterministic generator, independent of rand() and the replay seed */
+uint32_t next_random(uint32_t &state) {
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+/* fields set by both pipeline descriptor variants */
+bool same_pipeline_desc(const sg_pipeline_desc &a, const sg_pipeline_desc &b) {
+    for (int i = 0; i < 5; i++) {
+        if (a.layout.attrs[i].format != b.layout.attrs[i].format ||
+            a.layout.attrs[i].buffer_index != b.layout.attrs[i].buffer_index ||
+            a.layout.attrs[i].offset != b.layout.attrs[i].offset) {
+            return false;
+        }
+    }
+    return a.layout.buffers[1].step_func == b.layout.buffers[1].step_func &&
+        a.shader.id == b.shader.id && a.rasterizer.cull_mode == b.rasterizer.cull_mode &&
+        strcmp(a.label, b.label) == 0;
+}
+
+/* draw of the state filtering benchmark */
+struct draw_item {
+    int pipeline;
+    int mesh;
+    int material;
+    float transform[16];
+};
+
+class app : public falcon::application {
+    void configure(sapp_desc &desc) override {
+        desc.width = 800;
+        desc.height = 600;
+        desc.window_title = "Gfx Benchmark (falcon app)";
+        desc.swap_interval = 0;
+
+        _num_draws = atoi(sargs_value_def("draws", "4096"));
+        if (_num_draws <= 0) {
+            _num_draws = 4096;
+        }
+        _report_time = 0.0;
+        _frame_count = 0;
+    }
+
+    void init() override {
+        using namespace falcon::gfx;
+        _pass_action = make_pass_action_clear(0.0f, 0.0f, 0.0f);
+
+        /* two meshes, a triangle and a quad as two triangles */
+        const float triangle[] = { 0.0f, 0.5f, 0.5f, -0.5f, -0.5f, -0.5f };
+        const float quad[] = { -0.5f, -0.5f, 0.5f, -0.5f, 0.5f, 0.5f, -0.5f, -0.5f, 0.5f, 0.5f, -0.5f, 0.5f };
+        _meshes[0] = make_vertex_buffer(triangle, (int)sizeof(triangle), "gfxbench-triangle");
+        _meshes[1] = make_vertex_buffer(quad, (int)sizeof(quad), "gfxbench-quad");
+        _num_elements[0] = 3;
+        _num_elements[1] = 6;
+
+        _shader = make_shader([](auto &_) {
+            _.vs.source = vs_source;
+            _.vs.uniform_blocks[0].size = 4 * (int)sizeof(float);
+            _.vs.uniform_blocks[0].uniforms[0].name = "color";
+            _.vs.uniform_blocks[0].uniforms[0].type = SG_UNIFORMTYPE_FLOAT4;
+            _.fs.source = fs_source;
+        });
+
+        /* pipelines differing only in culling */
+        for (int p = 0; p < NUM_PIPELINES; p++) {
+            _pipelines[p] = make_pipeline(pipeline_desc(p == 0 ? SG_CULLMODE_NONE : SG_CULLMODE_BACK));
+        }
+
+        /* one stream each for the batch and the direct reference */
+        falcon::gfx::instance_batch_desc batch_desc;
+        batch_desc.instance_size = 16 * (int)sizeof(float);
+        batch_desc.max_instances = _num_draws;
+        batch_desc.label = "gfxbench-batch";
+        _batch.setup(batch_desc);
+        _direct_instances = make_buffer([this](auto &_) {
+            _.size = _num_draws * 16 * (int)sizeof(float);
+            _.usage = SG_USAGE_STREAM;
+            _.label = "gfxbench-direct";
+        });
+
+        /* random but fixed draw list */
+        uint32_t state = 1;
+        _draws.resize(_num_draws);
+        _direct_data.resize((size_t)_num_draws * 16);
+        for (int i = 0; i < _num_draws; i++) {
+            draw_item &d = _draws[i];
+            const uint32_t group = next_random(state) % NUM_GROUPS;
+            d.pipeline = (int)(group % NUM_PIPELINES);
+            d.mesh = (int)(group / NUM_PIPELINES % NUM_MESHES);
+            d.material = (int)(group / (NUM_PIPELINES * NUM_MESHES));
+            for (int k = 0; k < 16; k++) {
+                d.transform[k] = (k % 5 == 0) ? 0.01f : 0.0f;
+            }
+            d.transform[12] = (float)(next_random(state) % 2000) / 1000.0f - 1.0f;
+            d.transform[13] = (float)(next_random(state) % 2000) / 1000.0f - 1.0f;
+            memcpy(&_direct_data[(size_t)i * 16], d.transform, sizeof(d.transform));
+            _used_groups[group] = true;
+        }
+        for (bool used : _used_groups) {
+            _num_groups += used ? 1 : 0;
+        }
+    }
+
+    void frame() override {
+        /* descriptor builders against plain struct initialization */
+        uint64_t start = stm_now();
+        int num_valid = 0;
+        for (int i = 0; i < NUM_BUILDS; i++) {
+            const sg_buffer buf = falcon::gfx::make_buffer([](auto &_) {
+                _.size = 256;
+                _.usage = SG_USAGE_DYNAMIC;
+                _.label = "gfxbench-builder";
+            });
+            num_valid += (sg_query_buffer_state(buf) == SG_RESOURCESTATE_VALID) ? 1 : 0;
+            sg_destroy_buffer(buf);
+        }
+        const double builder_ms = stm_ms(stm_since(start));
+        start = stm_now();
+        for (int i = 0; i < NUM_BUILDS; i++) {
+            sg_buffer_desc desc{};
+            desc.size = 256;
+            desc.usage = SG_USAGE_DYNAMIC;
+            desc.label = "gfxbench-direct";
+            const sg_buffer buf = sg_make_buffer(&desc);
+            num_valid += (sg_query_buffer_state(buf) == SG_RESOURCESTATE_VALID) ? 1 : 0;
+            sg_destroy_buffer(buf);
+        }
+        const double direct_build_ms = stm_ms(stm_since(start));
+        bench().check(num_valid == 2 * NUM_BUILDS, "buffer created by a descriptor builder is not valid");
+
+        /* pipeline descriptors only, no resources */
+        start = stm_now();
+        bool same = true;
+        for (int i = 0; i < NUM_BUILDS; i++) {
+            const sg_cull_mode cull = (i % 2) ? SG_CULLMODE_BACK : SG_CULLMODE_NONE;
+            const auto desc = falcon::gfx::make<sg_pipeline_desc>([&](auto &_) { _ = pipeline_desc(cull); });
+            same &= (desc.rasterizer.cull_mode == cull);
+        }
+        const double make_desc_ms = stm_ms(stm_since(start));
+        start = stm_now();
+        for (int i = 0; i < NUM_BUILDS; i++) {
+            const sg_cull_mode cull = (i % 2) ? SG_CULLMODE_BACK : SG_CULLMODE_NONE;
+            const sg_pipeline_desc desc = pipeline_desc(cull);
+            same &= (desc.rasterizer.cull_mode == cull);
+        }
+        const double direct_desc_ms = stm_ms(stm_since(start));
+        same &= same_pipeline_desc(falcon::gfx::make<sg_pipeline_desc>([this](auto &_) { _ = pipeline_desc(SG_CULLMODE_BACK); }),
+            pipeline_desc(SG_CULLMODE_BACK));
+        bench().check(same, "falcon::gfx::make differs from plain initialization");
+
+        /* state filtering, both variants draw the same list in one pass */
+        double direct_ms = 0.0, batched_ms = 0.0;
+        {
+            auto pass = falcon::gfx::begin(_pass_action, width(), height());
+
+            /* every draw applies its full state */
+            start = stm_now();
+            const int base_offset = sg_append_buffer(_direct_instances, _direct_data.data(), (int)(_direct_data.size() * sizeof(float)));
+            for (int i = 0; i < _num_draws; i++) {
+                const draw_item &d = _draws[i];
+                sg_apply_pipeline(_pipelines[d.pipeline]);
+                sg_bindings bindings{};
+                bindings.vertex_buffers[0] = _meshes[d.mesh];
+                bindings.vertex_buffers[1] = _direct_instances;
+                bindings.vertex_buffer_offsets[1] = base_offset + i * (int)sizeof(d.transform);
+                sg_apply_bindings(&bindings);
+                sg_apply_uniforms(SG_SHADERSTAGE_VS, 0, _colors[d.material], (int)sizeof(_colors[d.material]));
+                sg_draw(0, _num_elements[d.mesh], 1);
+            }
+            direct_ms = stm_ms(stm_since(start));
+
+            /* the batch merges draws of equal state */
+            start = stm_now();
+            for (int i = 0; i < _num_draws; i++) {
+                const draw_item &d = _draws[i];
+                sg_bindings bindings{};
+                bindings.vertex_buffers[0] = _meshes[d.mesh];
+                _batch.uniforms(SG_SHADERSTAGE_VS, 0, _colors[d.material], (int)sizeof(_colors[d.material]));
+                _batch.draw(_pipelines[d.pipeline], bindings, 0, _num_elements[d.mesh], d.transform);
+            }
+            _batch.flush();
+            batched_ms = stm_ms(stm_since(start));
+        }
+
+        const falcon::gfx::instance_batch_stats &s = _batch.stats();
+        bench().check(s.num_batches == _num_groups, "instance batch did not merge draws of equal state");
+        bench().check(s.num_instances == _num_draws && s.num_dropped == 0, "instance batch lost draws");
+
+        /* medians of a bench_frames run, compared relative to the plain variants */
+        bench().note("builder_ms", builder_ms);
+        bench().note("direct_build_ms", direct_build_ms);
+        bench().note("make_desc_ms", make_desc_ms);
+        bench().note("direct_desc_ms", direct_desc_ms);
+        bench().note("direct_ms", direct_ms);
+        bench().note("batched_ms", batched_ms);
+        bench().add("builder_ratio", builder_ms / direct_build_ms);
+        bench().add("make_desc_ratio", make_desc_ms / direct_desc_ms);
+        bench().add("batched_ratio", batched_ms / direct_ms);
+
+        /* report once per second */
+        _builder_time += builder_ms;
+        _direct_build_time += direct_build_ms;
+        _direct_time += direct_ms;
+        _batched_time += batched_ms;
+        _frame_count++;
+        _report_time += delta_time();
+        if (_report_time >= 1.0) {
+            const double n = (double)_frame_count;
+            printf("%d buffers: builder %.3f ms, direct %.3f ms, %d draws: direct %.3f ms, batched %.3f ms (%d batches)\n",
+                NUM_BUILDS, _builder_time / n, _direct_build_time / n, _num_draws,
+                _direct_time / n, _batched_time / n, s.num_batches);
+            _builder_time = 0.0;
+            _direct_build_time = 0.0;
+            _direct_time = 0.0;
+            _batched_time = 0.0;
+            _report_time = 0.0;
+            _frame_count = 0;
+        }
+    }
+
+    void cleanup() override {
+        _batch.shutdown();
+        for (int p = 0; p < NUM_PIPELINES; p++) {
+            falcon::gfx::destroy(_pipelines[p]);
+        }
+        falcon::gfx::destroy(_shader);
+        for (int m = 0; m < NUM_MESHES; m++) {
+            falcon::gfx::destroy(_meshes[m]);
+        }
+        falcon::gfx::destroy(_direct_instances);
+    }
+
+    /* instanced pipeline of the benchmark */
+    sg_pipeline_desc pipeline_desc(sg_cull_mode cull_mode) const {
+        sg_pipeline_desc desc{};
+        desc.layout.attrs[0].format = SG_VERTEXFORMAT_FLOAT2;
+        falcon::gfx::instance_batch::configure_layout(desc, 1, 1, 4);
+        desc.shader = _shader;
+        desc.rasterizer.cull_mode = cull_mode;
+        desc.label = "gfxbench-pipeline";
+        return desc;
+    }
+
+    int _num_draws;
+    double _report_time;
+    int _frame_count;
+    double _builder_time = 0.0;
+    double _direct_build_time = 0.0;
+    double _direct_time = 0.0;
+    double _batched_time = 0.0;
+
+    falcon::gfx::pass_action _pass_action;
+    falcon::gfx::buffer _meshes[NUM_MESHES];
+    int _num_elements[NUM_MESHES];
+    falcon::gfx::shader _shader;
+    falcon::gfx::pipeline _pipelines[NUM_PIPELINES];
+    falcon::gfx::buffer _direct_instances;
+    falcon::gfx::instance_batch _batch;
+    std::vector<draw_item> _draws;
+    std::vector<float> _direct_data;
+    bool _used_groups[NUM_GROUPS] = {};
+    int _num_groups = 0;
+    float _colors[NUM_MATERIALS][4] = {
+        { 1.0f, 0.0f, 0.0f, 1.0f },
+        { 0.0f, 1.0f, 0.0f, 1.0f },
+        { 0.0f, 0.0f, 1.0f, 1.0f },
+        { 1.0f, 1.0f, 0.0f, 1.0f },
+    };
+};
+
+} // namespace
+
+FALCON_MAIN(::app);
@@ -0,0 +1,86 @@
+#include <stdio.h>  /* printf() */
+#include <math.h>   /* sin() */
+#include <stdlib.h> /* atof(), atoi() */
+
+#include "sokol_args.h"
+#include "sokol_time.h"
+
+#include "falcon.h"
+
+namespace {
+
+class app : public falcon::application {
+    void configure(sapp_desc &desc) override {
+        desc.width = 800;
+        desc.height = 600;
+        desc.window_title = "Render On Demand Benchmark (falcon app)";
+
+        set_on_demand(atoi(sargs_value_def("on_demand", "1")) != 0, atof(sargs_value_def("idle_sleep", "10")));
+        set_coalesce_input(true);
+        _last = {};
+    }
+
+    void init() override {
+        _pass_action = falcon::gfx::make_pass_action_clear(0.0f, 0.0f, 0.0f);
+        _report_start = stm_now();
+    }
+
+    /* clear colour follows the mouse, space toggles a pulsing animation */
+    void frame() override {
+        const falcon::input_snapshot &in = input();
+        _x = in.mouse_x / (float)width();
+        _y = in.mouse_y / (float)height();
+        if (in.pressed(SAPP_KEYCODE_SPACE)) {
+            _pulse = !_pulse;
+            set_animating(_pulse);
+        }
+        _num_events += in.num_events;
+        if (_pulse) {
+            _time += (float)delta_time();
+        }
+        const float b = _pulse ? 0.5f + 0.5f * (float)sin(_time * 4.0f) : 0.0f;
+        _pass_action = falcon::gfx::make_pass_action_clear(_x, _y, b);
+        falcon::gfx::begin(_pass_action, width(), height());
+        report();
+    }
+
+    /* the share of redrawn frames is reported by replays as active_ratio */
+    void idle() override {
+        report();
+    }
+
+    /* report once per second */
+    void report() {
+        if (stm_sec(stm_since(_report_start)) < 1.0) {
+            return;
+        }
+        const falcon::redraw_stats &s = redraws();
+        const int active = s.num_active - _last.num_active;
+        const int idle = s.num_idle - _last.num_idle;
+        const double active_ms = s.active_ms - _last.active_ms;
+        const double idle_ms = s.idle_ms - _last.idle_ms;
+        const double active_cpu = s.active_cpu_ms - _last.active_cpu_ms;
+        const double idle_cpu = s.idle_cpu_ms - _last.idle_cpu_ms;
+        printf("%s: active %d frames, cpu %.1f%%, idle %d frames, cpu %.1f%%, %d events\n",
+            on_demand() ? "on demand" : "continuous",
+            active, (active_ms > 0.0) ? 100.0 * active_cpu / active_ms : 0.0,
+            idle, (idle_ms > 0.0) ? 100.0 * idle_cpu / idle_ms : 0.0, _num_events);
+        _num_events = 0;
+        _last = s;
+        _report_start = stm_now();
+    }
+
+    float _x = 0.0f;
+    float _y = 0.0f;
+    float _time = 0.0f;
+    bool _pulse = false;
+    int _num_events = 0;
+    uint64_t _report_start = 0;
+    falcon::redraw_stats _last;
+
+    falcon::gfx::pass_action _pass_action;
+};
+
+} // namespace
+
+FALCON_MAIN(::app);
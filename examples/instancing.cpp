@@ -1,4 +1,5 @@
 #include <stdlib.h> /* rand() */
+#include <string.h> /* memcpy() */
 
 #define HANDMADE_MATH_IMPLEMENTATION
 #define HANDMADE_MATH_NO_SSE
@@ -8,7 +9,7 @@
 #include "instancing-sapp.glsl.h"
 
 #define MAX_PARTICLES (512 * 1024)
-#define NUM_PARTICLES_EMITTED_PER_FRAME (10)
+#define NUM_PARTICLES_EMITTED_PER_STEP (10)
 
 namespace {
 
@@ -19,12 +20,18 @@ class app : public falcon::application {
         desc.sample_count = 4;
         desc.window_title = "Instancing (falcon app)";
 
+        /* simulate at 60 Hz independent of the display rate */
+        set_fixed_timestep(60.0);
+
         _ry = 0.f;
         _vs_params = vs_params_t{};
         _cur_num_particles = 0;
         for (auto &pos : _pos) {
             pos = {};
         }
+        for (auto &pos : _prev_pos) {
+            pos = {};
+        }
         for (auto &vel : _vel) {
             vel = {};
         }
@@ -87,14 +94,17 @@ class app : public falcon::application {
         });
     }
 
-    void frame() override {
-        const float w = (float)width(), h = (float)height();
-        const float frame_time = delta_time();
+    void fixed_update(double dt) override {
+        const float step = (float)dt;
+
+        /* keep the last state for interpolation */
+        memcpy(_prev_pos, _pos, _cur_num_particles * sizeof(hmm_vec3));
 
         /* emit new particles */
-        for (int i = 0; i < NUM_PARTICLES_EMITTED_PER_FRAME; i++) {
+        for (int i = 0; i < NUM_PARTICLES_EMITTED_PER_STEP; i++) {
             if (_cur_num_particles < MAX_PARTICLES) {
                 _pos[_cur_num_particles] = HMM_Vec3(0.0, 0.0, 0.0);
+                _prev_pos[_cur_num_particles] = _pos[_cur_num_particles];
                 _vel[_cur_num_particles] = HMM_Vec3(
                     ((float)(rand() & 0x7FFF) / 0x7FFF) - 0.5f,
                     ((float)(rand() & 0x7FFF) / 0x7FFF) * 0.5f + 2.0f,
@@ -108,10 +118,10 @@ class app : public falcon::application {
 
         /* update particle positions */
         for (int i = 0; i < _cur_num_particles; i++) {
-            _vel[i].Y -= 1.0f * frame_time;
-            _pos[i].X += _vel[i].X * frame_time;
-            _pos[i].Y += _vel[i].Y * frame_time;
-            _pos[i].Z += _vel[i].Z * frame_time;
+            _vel[i].Y -= 1.0f * step;
+            _pos[i].X += _vel[i].X * step;
+            _pos[i].Y += _vel[i].Y * step;
+            _pos[i].Z += _vel[i].Z * step;
             /* bounce back from 'ground' */
             if (_pos[i].Y < -2.0f) {
                 _pos[i].Y = -1.8f;
@@ -119,9 +129,19 @@ class app : public falcon::application {
                 _vel[i].X *= 0.8f; _vel[i].Y *= 0.8f; _vel[i].Z *= 0.8f;
             }
         }
+    }
+
+    void render() override {
+        const float w = (float)width(), h = (float)height();
+
+        /* blend the last two fixed steps */
+        const float t = alpha();
+        for (int i = 0; i < _cur_num_particles; i++) {
+            _draw_pos[i] = HMM_AddVec3(_prev_pos[i], HMM_MultiplyVec3f(HMM_SubtractVec3(_pos[i], _prev_pos[i]), t));
+        }
 
         /* update instance data */
-        falcon::gfx::update_buffer(_bindings.vertex_buffers[1], _pos, _cur_num_particles*sizeof(hmm_vec3));
+        falcon::gfx::update_buffer(_bindings.vertex_buffers[1], _draw_pos, _cur_num_particles*sizeof(hmm_vec3));
 
         /* model-view-projection matrix */
         hmm_mat4 proj = HMM_Perspective(60.0f, w/h, 0.01f, 50.0f);
@@ -146,6 +166,8 @@ class app : public falcon::application {
     int _cur_num_particles;
     hmm_vec3 _pos[MAX_PARTICLES];
     hmm_vec3 _vel[MAX_PARTICLES];
+    hmm_vec3 _prev_pos[MAX_PARTICLES];
+    hmm_vec3 _draw_pos[MAX_PARTICLES];
 };
 
 } // namespace
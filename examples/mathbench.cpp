@@ -0,0 +1,168 @@
+#include <math.h>   /* fabsf() */
+#include <stdio.h>  /* printf() */
+#include <stdlib.h> /* atoi() */
+
+#define HANDMADE_MATH_IMPLEMENTATION
+#define HANDMADE_MATH_NO_SSE
+#include "HandmadeMath.h"
+
+#include "sokol_args.h"
+#include "sokol_time.h"
+
+#include "falcon.h"
+
+#define DEFAULT_NUM_OBJECTS (100000)
+/* largest difference to HandmadeMath, relative to the largest element */
+#define MAX_RELATIVE_DIFFERENCE (1e-4f)
+
+namespace {
+
+class app : public falcon::application {
+    void configure(sapp_desc &desc) override {
+        desc.width = 800;
+        desc.height = 600;
+        desc.window_title = "Math Benchmark (falcon app)";
+        desc.swap_interval = 0;
+
+        _num_objects = atoi(sargs_value_def("objects", "100000"));
+        if (_num_objects <= 0) {
+            _num_objects = DEFAULT_NUM_OBJECTS;
+        }
+        _angle = 0.f;
+        _report_time = 0.0;
+        _hmm_time = 0.0;
+        _falcon_time = 0.0;
+        _batch_time = 0.0;
+        _frame_count = 0;
+    }
+
+    void init() override {
+        _pass_action = falcon::gfx::make_pass_action_clear(0.0f, 0.0f, 0.0f);
+
+        _positions.resize(_num_objects);
+        for (int i = 0; i < _num_objects; i++) {
+            _positions[i] = { (float)(i % 100), (float)((i / 100) % 100), (float)(i / 10000) };
+        }
+        _hmm_mvp.resize(_num_objects);
+        _falcon_models.resize(_num_objects);
+        _falcon_mvp.resize(_num_objects);
+    }
+
+    void frame() override {
+        const float w = (float)width(), h = (float)height();
+        _angle += 1.0f;
+
+        /* HandmadeMath, scalar (as used by the other examples) */
+        uint64_t start = stm_now();
+        {
+            hmm_mat4 proj = HMM_Perspective(60.0f, w/h, 0.01f, 100.0f);
+            hmm_mat4 view = HMM_LookAt(HMM_Vec3(0.0f, 1.5f, 6.0f), HMM_Vec3(0.0f, 0.0f, 0.0f), HMM_Vec3(0.0f, 1.0f, 0.0f));
+            hmm_mat4 view_proj = HMM_MultiplyMat4(proj, view);
+            hmm_mat4 rot = HMM_Rotate(_angle, HMM_Vec3(0.0f, 1.0f, 0.0f));
+            for (int i = 0; i < _num_objects; i++) {
+                const auto &p = _positions[i];
+                hmm_mat4 model = HMM_MultiplyMat4(HMM_Translate(HMM_Vec3(p.x, p.y, p.z)), rot);
+                _hmm_mvp[i] = HMM_MultiplyMat4(view_proj, model);
+            }
+        }
+        const double hmm_ms = stm_ms(stm_since(start));
+
+        /* falcon::math, one matrix at a time */
+        start = stm_now();
+        {
+            using namespace falcon::math;
+            const mat4 view_proj = perspective(60.0f, w/h, 0.01f, 100.0f) * look_at({ 0.0f, 1.5f, 6.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f });
+            const quat rot = quat_axis_angle({ 0.0f, 1.0f, 0.0f }, _angle);
+            for (int i = 0; i < _num_objects; i++) {
+                _falcon_mvp[i] = view_proj * trs(_positions[i], rot, { 1.0f, 1.0f, 1.0f });
+            }
+        }
+        const double falcon_ms = stm_ms(stm_since(start));
+
+        /* falcon::math, batched */
+        start = stm_now();
+        {
+            using namespace falcon::math;
+            const mat4 view_proj = perspective(60.0f, w/h, 0.01f, 100.0f) * look_at({ 0.0f, 1.5f, 6.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f });
+            const quat rot = quat_axis_angle({ 0.0f, 1.0f, 0.0f }, _angle);
+            for (int i = 0; i < _num_objects; i++) {
+                _falcon_models[i] = trs(_positions[i], rot, { 1.0f, 1.0f, 1.0f });
+            }
+            mul_batch(view_proj, _falcon_models.data(), _falcon_mvp.data(), _falcon_mvp.size());
+        }
+        const double batch_ms = stm_ms(stm_since(start));
+
+        falcon::gfx::begin(_pass_action, width(), height());
+
+        /* medians of a bench_frames run, compared relative to HandmadeMath */
+        bench().note("hmm_ms", hmm_ms);
+        bench().note("falcon_ms", falcon_ms);
+        bench().note("batched_ms", batch_ms);
+        bench().add("falcon_ratio", falcon_ms / hmm_ms);
+        bench().add("batched_ratio", batch_ms / hmm_ms);
+        bench().check(max_difference() <= MAX_RELATIVE_DIFFERENCE * max_element(), "falcon::math differs from HandmadeMath");
+
+        /* report once per second */
+        _hmm_time += hmm_ms;
+        _falcon_time += falcon_ms;
+        _batch_time += batch_ms;
+        _frame_count++;
+        _report_time += delta_time();
+        if (_report_time >= 1.0) {
+            const double scale = 1.0 / _frame_count;
+            printf("objects: %d, hmm: %.3f ms, falcon: %.3f ms, falcon batched: %.3f ms (max diff %g)\n",
+                _num_objects, _hmm_time * scale, _falcon_time * scale, _batch_time * scale, max_difference());
+            _report_time = 0.0;
+            _hmm_time = 0.0;
+            _falcon_time = 0.0;
+            _batch_time = 0.0;
+            _frame_count = 0;
+        }
+    }
+
+    /* compare results of both libraries */
+    float max_difference() const {
+        float result = 0.0f;
+        for (int i = 0; i < _num_objects; i++) {
+            for (int c = 0; c < 4; c++) {
+                for (int r = 0; r < 4; r++) {
+                    const float d = fabsf(_hmm_mvp[i].Elements[c][r] - _falcon_mvp[i][c][r]);
+                    result = d > result ? d : result;
+                }
+            }
+        }
+        return result;
+    }
+
+    /* largest absolute element of the reference results */
+    float max_element() const {
+        float result = 1.0f;
+        for (int i = 0; i < _num_objects; i++) {
+            for (int c = 0; c < 4; c++) {
+                for (int r = 0; r < 4; r++) {
+                    const float e = fabsf(_hmm_mvp[i].Elements[c][r]);
+                    result = e > result ? e : result;
+                }
+            }
+        }
+        return result;
+    }
+
+    int _num_objects;
+    float _angle;
+    double _report_time;
+    double _hmm_time;
+    double _falcon_time;
+    double _batch_time;
+    int _frame_count;
+
+    falcon::gfx::pass_action _pass_action;
+    std::vector<falcon::math::vec3> _positions;
+    std::vector<hmm_mat4> _hmm_mvp;
+    std::vector<falcon::math::mat4> _falcon_models;
+    std::vector<falcon::math::mat4> _falcon_mvp;
+};
+
+} // namespace
+
+FALCON_MAIN(::app);
@@ -0,0 +1,54 @@
+#include <stdio.h>  /* printf() */
+#include <stdlib.h> /* atof(), atoi(), rand() */
+
+#include "sokol_args.h"
+#include "sokol_time.h"
+
+#include "falcon.h"
+
+namespace {
+
+class app : public falcon::application {
+    void configure(sapp_desc &desc) override {
+        desc.width = 800;
+        desc.height = 600;
+        desc.window_title = "Frame Pacing Benchmark (falcon app)";
+        desc.swap_interval = 0;
+
+        set_frame_rate(atof(sargs_value_def("fps", "120")), atoi(sargs_value_def("late_input", "0")) != 0);
+        _work_ms = atof(sargs_value_def("work", "2"));
+        _report_time = 0.0;
+    }
+
+    void init() override {
+        _pass_action = falcon::gfx::make_pass_action_clear(0.0f, 0.0f, 0.0f);
+    }
+
+    void frame() override {
+        /* uneven cpu work, between half and all of the work argument */
+        const double work = _work_ms * (0.5 + 0.5 * (rand() / (double)RAND_MAX));
+        const uint64_t start = stm_now();
+        while (stm_ms(stm_since(start)) < work) {
+        }
+        falcon::gfx::begin(_pass_action, width(), height());
+
+        /* report once per second */
+        _report_time += delta_time();
+        if (_report_time >= 1.0) {
+            const falcon::frame_pacer_stats &s = pacer().stats();
+            printf("target %.3f ms%s: frame %.3f ms, jitter %.3f ms, max error %.3f ms, sleep %.3f ms, spin %.3f ms, oversleep %.3f ms, missed %d\n",
+                pacer().target(), pacer().late_input() ? " (late input)" : "",
+                s.frame_ms, s.jitter_ms, s.max_error_ms, s.sleep_ms, s.spin_ms, s.oversleep_ms, s.num_missed);
+            _report_time = 0.0;
+        }
+    }
+
+    double _work_ms;
+    double _report_time;
+
+    falcon::gfx::pass_action _pass_action;
+};
+
+} // namespace
+
+FALCON_MAIN(::app);
@@ -0,0 +1,369 @@
+#include <stdio.h>  /* printf() */
+#include <stdlib.h> /* atoi() */
+#include <string.h> /* memcpy() */
+
+#include <algorithm>
+#include <cmath>
+
+#include "sokol_args.h"
+#include "sokol_time.h"
+
+#include "falcon.h"
+
+/* attribute slots as sokol-shdc would generate them */
+#define ATTR_vs_pos (0)
+#define ATTR_vs_normal (1)
+#define ATTR_vs_color0 (2)
+#define ATTR_vs_texcoord0 (3)
+
+#if defined(SOKOL_GLES3)
+#define GLSL_VERSION "#version 300 es\nprecision highp float;\n"
+#else
+#define GLSL_VERSION "#version 330\n"
+#endif
+
+namespace {
+
+/* float vertices, every attribute feeds the color so none is optimized out */
+const char *float_vs_source =
+    GLSL_VERSION
+    "uniform vec4 transform;\n"
+    "layout(location=0) in vec3 pos;\n"
+    "layout(location=1) in vec3 normal;\n"
+    "layout(location=2) in vec4 color0;\n"
+    "layout(location=3) in vec2 texcoord0;\n"
+    "out vec4 color;\n"
+    "void main() {\n"
+    "    gl_Position = vec4(pos * transform.xyz, 1.0);\n"
+    "    color = color0 * vec4(normal * 0.5 + 0.5, 1.0) * vec4(fract(texcoord0), 1.0, 1.0);\n"
+    "}\n";
+
+/* packed vertices, dequantized with vertex_pack_params */
+const char *packed_vs_source =
+    GLSL_VERSION
+    "uniform vec4 transform;\n"
+    "uniform vec4 position_scale;\n"
+    "uniform vec4 position_offset;\n"
+    "uniform vec4 texcoord_scale_offset;\n"
+    "layout(location=0) in vec4 pos;\n"
+    "layout(location=1) in vec2 normal;\n"
+    "layout(location=2) in vec4 color0;\n"
+    "layout(location=3) in vec2 texcoord0;\n"
+    "out vec4 color;\n"
+    "vec3 oct_decode(vec2 e) {\n"
+    "    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));\n"
+    "    float t = max(-n.z, 0.0);\n"
+    "    n.xy += mix(vec2(t), vec2(-t), step(0.0, n.xy));\n"
+    "    return normalize(n);\n"
+    "}\n"
+    "void main() {\n"
+    "    vec3 p = pos.xyz * position_scale.xyz + position_offset.xyz;\n"
+    "    vec3 n = oct_decode(normal);\n"
+    "    vec2 uv = texcoord0 * texcoord_scale_offset.xy + texcoord_scale_offset.zw;\n"
+    "    gl_Position = vec4(p * transform.xyz, 1.0);\n"
+    "    color = color0 * vec4(n * 0.5 + 0.5, 1.0) * vec4(fract(uv), 1.0, 1.0);\n"
+    "}\n";
+
+const char *fs_source =
+    GLSL_VERSION
+    "in vec4 color;\n"
+    "out vec4 frag_color;\n"
+    "void main() {\n"
+    "    frag_color = color;\n"
+    "}\n";
+
+/* vertex shader uniforms of the packed pipeline (the float one uses transform only) */
+struct vs_params_t {
+    float transform[4];
+    falcon::gfx::vertex_pack_params pack;
+};
+
+/* float vertex as used by the examples */
+struct vertex_t {
+    float pos[3];
+    float normal[3];
+    float color[4];
+    float uv[2];
+};
+
+/* uv sphere or torus (inner radius > 0) with normals, colors and uvs */
+void make_mesh(std::vector<vertex_t> &out, int rings, int sectors, float radius, float inner) {
+    const float pi = 3.14159265f;
+    for (int r = 0; r <= rings; r++) {
+        for (int s = 0; s <= sectors; s++) {
+            const float u = (float)s / sectors, v = (float)r / rings;
+            const float phi = u * 2.0f * pi;
+            vertex_t vtx;
+            if (inner > 0.0f) {
+                const float theta = v * 2.0f * pi;
+                const float ring = radius + inner * std::cos(theta);
+                vtx.pos[0] = ring * std::cos(phi);
+                vtx.pos[1] = inner * std::sin(theta);
+                vtx.pos[2] = ring * std::sin(phi);
+                vtx.normal[0] = std::cos(theta) * std::cos(phi);
+                vtx.normal[1] = std::sin(theta);
+                vtx.normal[2] = std::cos(theta) * std::sin(phi);
+            } else {
+                const float theta = v * pi;
+                vtx.normal[0] = std::sin(theta) * std::cos(phi);
+                vtx.normal[1] = std::cos(theta);
+                vtx.normal[2] = std::sin(theta) * std::sin(phi);
+                vtx.pos[0] = vtx.normal[0] * radius;
+                vtx.pos[1] = vtx.normal[1] * radius;
+                vtx.pos[2] = vtx.normal[2] * radius;
+            }
+            vtx.color[0] = u;
+            vtx.color[1] = v;
+            vtx.color[2] = 1.0f - u;
+            vtx.color[3] = 1.0f;
+            vtx.uv[0] = u * 4.0f;
+            vtx.uv[1] = v * 2.0f;
+            out.push_back(vtx);
+        }
+    }
+}
+
+/* triangle list of a make_mesh() grid */
+void make_indices(std::vector<uint32_t> &out, int rings, int sectors) {
+    for (int r = 0; r < rings; r++) {
+        for (int s = 0; s < sectors; s++) {
+            const uint32_t i0 = (uint32_t)(r * (sectors + 1) + s), i1 = i0 + (uint32_t)(sectors + 1);
+            out.insert(out.end(), { i0, i1, i0 + 1, i0 + 1, i1, i1 + 1 });
+        }
+    }
+}
+
+const char *format_name(sg_vertex_format fmt) {
+    switch (fmt) {
+    case SG_VERTEXFORMAT_SHORT2N: return "SHORT2N";
+    case SG_VERTEXFORMAT_SHORT4N: return "SHORT4N";
+    case SG_VERTEXFORMAT_UBYTE4N: return "UBYTE4N";
+    default: return "?";
+    }
+}
+
+class app : public falcon::application {
+    void configure(sapp_desc &desc) override {
+        desc.width = 800;
+        desc.height = 600;
+        desc.window_title = "Vertex Packing Benchmark (falcon app)";
+        desc.swap_interval = 0;
+
+        _draws = atoi(sargs_value_def("draws", "100"));
+        if (_draws <= 0) {
+            _draws = 100;
+        }
+        _mode = 0;
+        _skip = true;
+        _frame_ms[0] = _frame_ms[1] = 0.0;
+        _report_time = 0.0;
+        _frame_count = 0;
+    }
+
+    void init() override {
+        using namespace falcon::gfx;
+        _pass_action = make_pass_action_clear(0.0f, 0.0f, 0.0f);
+
+        /* benchmark mesh set: spheres and tori of increasing density */
+        const int resolutions[] = { 16, 64, 256, 512 };
+        for (int res : resolutions) {
+            for (int torus = 0; torus < 2; torus++) {
+                _meshes.emplace_back();
+                make_mesh(_meshes.back(), res, res * 2, torus ? 250.0f : 10.0f, torus ? 40.0f : 0.0f);
+                std::vector<uint32_t> indices;
+                make_indices(indices, res, res * 2);
+                _num_elements.push_back((int)indices.size());
+                _index_buffers.push_back(make_index_buffer(indices.data(), (int)(indices.size() * sizeof(uint32_t)), "packbench-indices"));
+            }
+        }
+
+        size_t float_bytes = 0, packed_bytes = 0;
+        int num_vertices = 0;
+        double pack_ms = 0.0, copy_ms = 0.0;
+        float pos_error = 0.0f, normal_error = 0.0f, uv_error = 0.0f;
+        for (size_t m = 0; m < _meshes.size(); m++) {
+            const auto &mesh = _meshes[m];
+            vertex_pack_desc desc;
+            desc.num_vertices = (int)mesh.size();
+            desc.num_sources = 4;
+            desc.sources[0] = { vertex_semantic::position, ATTR_vs_pos, mesh[0].pos, 3, (int)sizeof(vertex_t) };
+            desc.sources[1] = { vertex_semantic::normal, ATTR_vs_normal, mesh[0].normal, 3, (int)sizeof(vertex_t) };
+            desc.sources[2] = { vertex_semantic::color, ATTR_vs_color0, mesh[0].color, 4, (int)sizeof(vertex_t) };
+            desc.sources[3] = { vertex_semantic::texcoord, ATTR_vs_texcoord0, mesh[0].uv, 2, (int)sizeof(vertex_t) };
+
+            uint64_t start = stm_now();
+            const packed_vertices packed = pack_vertices(desc);
+            pack_ms += stm_ms(stm_since(start));
+
+            /* reference: a plain copy of the float vertices */
+            std::vector<vertex_t> copy(mesh.size());
+            start = stm_now();
+            memcpy(copy.data(), mesh.data(), mesh.size() * sizeof(vertex_t));
+            copy_ms += stm_ms(stm_since(start));
+
+            /* decode on the cpu the way the vertex shader would */
+            const auto &p = packed.params;
+            for (int i = 0; i < packed.num_vertices; i++) {
+                const uint8_t *v = packed.data.data() + (size_t)i * packed.stride;
+                int16_t q[4];
+                memcpy(q, v + packed.layout.attrs[ATTR_vs_pos].offset, 8);
+                for (int c = 0; c < 3; c++) {
+                    const float s = (&p.position_scale.x)[c], o = (&p.position_offset.x)[c];
+                    pos_error = std::max(pos_error, std::fabs(q[c] / 32767.0f * s + o - mesh[i].pos[c]));
+                }
+                memcpy(q, v + packed.layout.attrs[ATTR_vs_normal].offset, 4);
+                const falcon::math::vec3 n = decode_oct(q);
+                const float d = n.x * mesh[i].normal[0] + n.y * mesh[i].normal[1] + n.z * mesh[i].normal[2];
+                normal_error = std::max(normal_error, std::acos(std::min(d, 1.0f)) * 57.2958f);
+                memcpy(q, v + packed.layout.attrs[ATTR_vs_texcoord0].offset, 4);
+                uv_error = std::max(uv_error, std::fabs(q[0] / 32767.0f * p.texcoord_scale_offset.x + p.texcoord_scale_offset.z - mesh[i].uv[0]));
+            }
+
+            float_bytes += mesh.size() * sizeof(vertex_t);
+            packed_bytes += packed.data.size();
+            num_vertices += packed.num_vertices;
+            _params.push_back(packed.params);
+            _float_buffers.push_back(make_vertex_buffer(mesh.data(), (int)(mesh.size() * sizeof(vertex_t)), "float-vertices"));
+            _packed_buffers.push_back(make_vertex_buffer(packed.data.data(), (int)packed.data.size(), "packed-vertices"));
+
+            if (m == 0) {
+                sg_pipeline_desc pip_desc{};
+                configure_layout(pip_desc, packed);
+                printf("layout: stride %d bytes (float %d)\n", pip_desc.layout.buffers[0].stride, (int)sizeof(vertex_t));
+                const char *names[] = { "pos", "normal", "color0", "texcoord0" };
+                for (int a = 0; a < 4; a++) {
+                    printf("  attr %d %-9s offset %2d %s\n", a, names[a], pip_desc.layout.attrs[a].offset, format_name(pip_desc.layout.attrs[a].format));
+                }
+
+                /* the packed layout is the same for every mesh of the set */
+                _shaders[1] = make_shader(shader_desc(packed_vs_source, true));
+                _pipelines[1] = make_pipeline(pipeline_desc(pip_desc, _shaders[1], "packed-pipeline"));
+            }
+        }
+
+        /* float pipeline */
+        {
+            sg_pipeline_desc pip_desc{};
+            pip_desc.layout.buffers[0].stride = (int)sizeof(vertex_t);
+            pip_desc.layout.attrs[ATTR_vs_pos].format = SG_VERTEXFORMAT_FLOAT3;
+            pip_desc.layout.attrs[ATTR_vs_normal].format = SG_VERTEXFORMAT_FLOAT3;
+            pip_desc.layout.attrs[ATTR_vs_color0].format = SG_VERTEXFORMAT_FLOAT4;
+            pip_desc.layout.attrs[ATTR_vs_texcoord0].format = SG_VERTEXFORMAT_FLOAT2;
+            _shaders[0] = make_shader(shader_desc(float_vs_source, false));
+            _pipelines[0] = make_pipeline(pipeline_desc(pip_desc, _shaders[0], "float-pipeline"));
+        }
+
+        printf("%d meshes, %d vertices: float %.2f MB, packed %.2f MB (%.1f%% less), packed in %.3f ms\n",
+            (int)_meshes.size(), num_vertices, float_bytes / (1024.0 * 1024.0), packed_bytes / (1024.0 * 1024.0),
+            100.0 * (1.0 - (double)packed_bytes / (double)float_bytes), pack_ms);
+        printf("max error: position %.5f, normal %.4f deg, uv %.6f\n", pos_error, normal_error, uv_error);
+
+        /* lower is better for all of these, so the baseline catches regressions,
+           packing is compared relative to copying the float data, a single
+           measurement where only large changes count */
+        bench().note("pack_ms", pack_ms);
+        bench().note("copy_ms", copy_ms);
+        bench().add("pack_ratio", pack_ms / copy_ms, 0.5);
+        bench().add("packed_bytes_ratio", (double)packed_bytes / (double)float_bytes);
+        bench().add("position_error", pos_error);
+        bench().add("normal_error_deg", normal_error);
+        bench().add("uv_error", uv_error);
+    }
+
+    void frame() override {
+        /* the set is drawn _draws times from the float or the packed buffers,
+           shrunk to a few pixels so vertex fetch dominates the frame time */
+        {
+            auto pass = falcon::gfx::begin(_pass_action, width(), height());
+            auto pip = pass.pipeline(_pipelines[_mode]);
+            vs_params_t params{ { 0.0002f, 0.0002f, 0.0002f, 0.0f }, {} };
+            for (int d = 0; d < _draws; d++) {
+                for (size_t m = 0; m < _meshes.size(); m++) {
+                    sg_bindings bindings{};
+                    bindings.vertex_buffers[0] = _mode ? _packed_buffers[m] : _float_buffers[m];
+                    bindings.index_buffer = _index_buffers[m];
+                    params.pack = _params[m];
+                    pip.bindings(bindings)
+                        .uniforms(SG_SHADERSTAGE_VS, 0, &params, _mode ? (int)sizeof(params) : (int)sizeof(params.transform))
+                        .draw(0, _num_elements[m], 1);
+                }
+            }
+        }
+
+        /* measured frame time, the first frame after switching is skipped */
+        if (_skip) {
+            _skip = false;
+            return;
+        }
+        bench().note(_mode ? "packed_frame_ms" : "float_frame_ms", 1000.0 * delta_time());
+        _frame_count++;
+        _report_time += delta_time();
+        if (_report_time >= 1.0) {
+            _frame_ms[_mode] = 1000.0 * _report_time / _frame_count;
+            if (_mode == 1) {
+                printf("%d draws of the set: float %.2f ms, packed %.2f ms per frame (%.2fx)\n", _draws,
+                    _frame_ms[0], _frame_ms[1], _frame_ms[1] > 0.0 ? _frame_ms[0] / _frame_ms[1] : 0.0);
+            }
+            _mode ^= 1;
+            _skip = true;
+            _report_time = 0.0;
+            _frame_count = 0;
+        }
+    }
+
+    void cleanup() override {
+        for (size_t m = 0; m < _meshes.size(); m++) {
+            falcon::gfx::destroy(_float_buffers[m]);
+            falcon::gfx::destroy(_packed_buffers[m]);
+            falcon::gfx::destroy(_index_buffers[m]);
+        }
+        for (int i = 0; i < 2; i++) {
+            falcon::gfx::destroy(_pipelines[i]);
+            falcon::gfx::destroy(_shaders[i]);
+        }
+    }
+
+    /* shader with the float or the packed vertex shader */
+    static sg_shader_desc shader_desc(const char *vs_source, bool packed) {
+        const char *names[] = { "transform", "position_scale", "position_offset", "texcoord_scale_offset" };
+        sg_shader_desc desc{};
+        desc.vs.source = vs_source;
+        desc.vs.uniform_blocks[0].size = packed ? (int)sizeof(vs_params_t) : 4 * (int)sizeof(float);
+        for (int i = 0; i < (packed ? 4 : 1); i++) {
+            desc.vs.uniform_blocks[0].uniforms[i].name = names[i];
+            desc.vs.uniform_blocks[0].uniforms[i].type = SG_UNIFORMTYPE_FLOAT4;
+        }
+        desc.fs.source = fs_source;
+        return desc;
+    }
+
+    /* indexed triangle pipeline on top of a vertex layout */
+    static sg_pipeline_desc pipeline_desc(const sg_pipeline_desc &layout, sg_shader shader, const char *label) {
+        sg_pipeline_desc desc = layout;
+        desc.shader = shader;
+        desc.index_type = SG_INDEXTYPE_UINT32;
+        desc.label = label;
+        return desc;
+    }
+
+    int _draws;
+    int _mode;
+    bool _skip;
+    double _frame_ms[2];
+    double _report_time;
+    int _frame_count;
+
+    falcon::gfx::pass_action _pass_action;
+    std::vector<std::vector<vertex_t>> _meshes;
+    std::vector<int> _num_elements;
+    std::vector<falcon::gfx::vertex_pack_params> _params;
+    std::vector<falcon::gfx::buffer> _float_buffers;
+    std::vector<falcon::gfx::buffer> _packed_buffers;
+    std::vector<falcon::gfx::buffer> _index_buffers;
+    falcon::gfx::shader _shaders[2];
+    falcon::gfx::pipeline _pipelines[2];
+};
+
+} // namespace
+
+FALCON_MAIN(::app);
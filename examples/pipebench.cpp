@@ -0,0 +1,117 @@
+#include <stdio.h>  /* printf() */
+#include <stdlib.h> /* atoi(), rand() */
+
+#include <cmath>
+#include <vector>
+
+#include "sokol_args.h"
+
+#include "falcon.h"
+
+namespace {
+
+float random01() {
+    return rand() / (float)RAND_MAX;
+}
+
+/* particle state, one copy per snapshot slot */
+struct snapshot {
+    std::vector<falcon::math::vec3> positions;
+    std::vector<falcon::math::vec3> velocities;
+};
+
+class app : public falcon::application {
+    void configure(sapp_desc &desc) override {
+        desc.width = 800;
+        desc.height = 600;
+        desc.window_title = "Pipelined Update Benchmark (falcon app)";
+        desc.swap_interval = 0;
+
+        _num_particles = atoi(sargs_value_def("particles", "200000"));
+        if (_num_particles <= 0) {
+            _num_particles = 200000;
+        }
+        set_pipelined(atoi(sargs_value_def("pipelined", "1")) != 0);
+        _report_time = 0.0;
+        _frame_count = 0;
+    }
+
+    void init() override {
+        _pass_action = falcon::gfx::make_pass_action_clear(0.0f, 0.0f, 0.0f);
+        for (auto &s : _snapshots) {
+            s.positions.resize(_num_particles);
+            s.velocities.resize(_num_particles);
+        }
+        for (int i = 0; i < _num_particles; i++) {
+            _snapshots[render_index()].positions[i] = { 0.0f, 0.0f, 0.0f };
+            _snapshots[render_index()].velocities[i] = { random01() - 0.5f, random01() * 4.0f, random01() - 0.5f };
+        }
+    }
+
+    /* simulation: reads the last snapshot, writes the next one */
+    void update(double dt) override {
+        using namespace falcon::math;
+        const snapshot &src = _snapshots[render_index()];
+        snapshot &dst = _snapshots[update_index()];
+        const float t = (float)dt;
+        for (int i = 0; i < _num_particles; i++) {
+            vec3 v = src.velocities[i] + vec3{ 0.0f, -9.81f * t, 0.0f };
+            vec3 p = src.positions[i] + v * t;
+            if (p.y < 0.0f) {
+                p.y = -p.y;
+                v.y = std::fabs(v.y) * 0.9f;
+            }
+            dst.positions[i] = p;
+            dst.velocities[i] = v;
+        }
+    }
+
+    /* render prep: per-particle colors from the snapshot being displayed */
+    void render() override {
+        const snapshot &s = _snapshots[render_index()];
+        uint32_t *colors = frame_memory().alloc_array<uint32_t>(_num_particles);
+        for (int i = 0; i < _num_particles; i++) {
+            const float h = std::sqrt(s.positions[i].y * s.positions[i].y + 1.0f);
+            const uint32_t c = (uint32_t)(std::fmod(h, 1.0f) * 255.0f);
+            colors[i] = 0xFF000000 | (c << 16) | (c << 8) | c;
+        }
+        falcon::gfx::begin(_pass_action, width(), height());
+
+        /* report once per second */
+        _frame_count++;
+        _report_time += delta_time();
+        _frame_time += delta_time() * 1000.0;
+        _update_time += timings().update_ms;
+        _render_time += timings().render_ms;
+        _wait_time += timings().wait_ms;
+        if (_report_time >= 1.0) {
+            const double n = (double)_frame_count;
+            const falcon::frame_arena_stats &m = frame_memory().stats();
+            printf("%s %d particles: frame %.3f ms, update %.3f ms, render %.3f ms, wait %.3f ms, frame memory %zu KiB (high water %zu KiB, heap %zu KiB)\n",
+                pipelined() ? "pipelined" : "serial", _num_particles,
+                _frame_time / n, _update_time / n, _render_time / n, _wait_time / n,
+                m.used / 1024, m.high_water / 1024, m.overflow_bytes / 1024);
+            _frame_time = 0.0;
+            _update_time = 0.0;
+            _render_time = 0.0;
+            _wait_time = 0.0;
+            _report_time = 0.0;
+            _frame_count = 0;
+        }
+    }
+
+    int _num_particles;
+    double _report_time;
+    int _frame_count;
+    double _frame_time = 0.0;
+    double _update_time = 0.0;
+    double _render_time = 0.0;
+    double _wait_time = 0.0;
+
+    falcon::gfx::pass_action _pass_action;
+    snapshot _snapshots[2];
+};
+
+} // namespace
+
+FALCON_MAIN(::app);
@@ -6,10 +6,33 @@
 /* this is only needed for the debug-inspection headers */
 #define SOKOL_TRACE_HOOKS
 /* sokol 3D-API defines are provided by build options */
+/* allocations are routed through falcon_memory, tagged per header */
+#include "allocator.h"
+#define SOKOL_MALLOC(s) falcon_malloc(FALCON_MEMORY_TAG_APP, s)
+#define SOKOL_CALLOC(n, s) falcon_calloc(FALCON_MEMORY_TAG_APP, n, s)
+#define SOKOL_FREE(p) falcon_free(p)
+/* headless builds get the sokol_app entry points from falcon (headless.cpp) */
+#if !defined(FALCON_HEADLESS)
 #include "sokol_app.h"
+#endif
 #include "sokol_args.h"
-#include "sokol_gfx.h"
 #include "sokol_time.h"
+#undef SOKOL_MALLOC
+#undef SOKOL_CALLOC
+#define SOKOL_MALLOC(s) falcon_malloc(FALCON_MEMORY_TAG_GFX, s)
+#define SOKOL_CALLOC(n, s) falcon_calloc(FALCON_MEMORY_TAG_GFX, n, s)
+#include "sokol_gfx.h"
+#undef SOKOL_MALLOC
+#undef SOKOL_CALLOC
+#define SOKOL_MALLOC(s) falcon_malloc(FALCON_MEMORY_TAG_AUDIO, s)
+#define SOKOL_CALLOC(n, s) falcon_calloc(FALCON_MEMORY_TAG_AUDIO, n, s)
 #include "sokol_audio.h"
+#undef SOKOL_MALLOC
+#undef SOKOL_CALLOC
+#define SOKOL_MALLOC(s) falcon_malloc(FALCON_MEMORY_TAG_FETCH, s)
+#define SOKOL_CALLOC(n, s) falcon_calloc(FALCON_MEMORY_TAG_FETCH, n, s)
 #include "sokol_fetch.h"
+/* sokol_glue needs sokol_app and sokol_gfx, it does not allocate */
+#if !defined(FALCON_HEADLESS)
 #include "sokol_glue.h"
+#endif
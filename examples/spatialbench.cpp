@@ -0,0 +1,269 @@
+#include <math.h>   /* fabsf() */
+#include <stdio.h>  /* printf() */
+#include <stdlib.h> /* atoi(), rand() */
+
+#include <algorithm>     /* std::sort(), std::swap() */
+#include <unordered_map> /* grid move reference */
+
+#include "sokol_args.h"
+#include "sokol_time.h"
+
+#include "falcon.h"
+
+#define DEFAULT_NUM_OBJECTS (100000)
+#define NUM_RAYS (1000)
+#define NUM_BRUTE_RAYS (20)
+
+namespace {
+
+float random01() {
+    return rand() / (float)RAND_MAX;
+}
+
+/* brute force references: every box against the frustum, same test as the index */
+bool brute_visible(const falcon::frustum &f, const falcon::aabb &b) {
+    using namespace falcon::math;
+    const vec3 c = (b.min + b.max) * 0.5f;
+    const vec3 e = (b.max - b.min) * 0.5f;
+    for (const auto &p : f.planes) {
+        const float d = p.x * c.x + p.y * c.y + p.z * c.z + p.w;
+        const float r = fabsf(p.x) * e.x + fabsf(p.y) * e.y + fabsf(p.z) * e.z;
+        if (d + r < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* every box against the ray, returns the closest entry distance or -1 */
+float brute_raycast(const falcon::ray &r, const std::vector<falcon::aabb> &boxes) {
+    using namespace falcon::math;
+    const vec3 inv_dir = { 1.0f / r.direction.x, 1.0f / r.direction.y, 1.0f / r.direction.z };
+    float closest = -1.0f;
+    for (const auto &b : boxes) {
+        float t0 = 0.0f, t1 = (closest >= 0.0f) ? closest : r.max_t;
+        for (int axis = 0; axis < 3; axis++) {
+            float near_t = (b.min[axis] - r.origin[axis]) * inv_dir[axis];
+            float far_t = (b.max[axis] - r.origin[axis]) * inv_dir[axis];
+            if (near_t > far_t) {
+                std::swap(near_t, far_t);
+            }
+            t0 = std::max(t0, near_t);
+            t1 = std::min(t1, far_t);
+        }
+        if (t0 <= t1) {
+            closest = t0;
+        }
+    }
+    return closest;
+}
+
+falcon::ray random_ray() {
+    using namespace falcon::math;
+    falcon::ray r;
+    r.origin = { (random01() - 0.5f) * 1000.0f, 0.0f, (random01() - 0.5f) * 1000.0f };
+    r.direction = normalize(vec3{ random01() - 0.5f, random01() - 0.5f, random01() - 0.5f });
+    return r;
+}
+
+class app : public falcon::application {
+    void configure(sapp_desc &desc) override {
+        desc.width = 800;
+        desc.height = 600;
+        desc.window_title = "Spatial Index Benchmark (falcon app)";
+        desc.swap_interval = 0;
+
+        _num_objects = atoi(sargs_value_def("objects", "100000"));
+        if (_num_objects <= 0) {
+            _num_objects = DEFAULT_NUM_OBJECTS;
+        }
+        _num_moving = _num_objects / 100;
+        _angle = 0.f;
+        _report_time = 0.0;
+        _frame_count = 0;
+    }
+
+    void init() override {
+        using namespace falcon::math;
+        _pass_action = falcon::gfx::make_pass_action_clear(0.0f, 0.0f, 0.0f);
+
+        /* random boxes on a 1000 x 100 x 1000 field */
+        _boxes.resize(_num_objects);
+        for (auto &b : _boxes) {
+            const vec3 c = { (random01() - 0.5f) * 1000.0f, (random01() - 0.5f) * 100.0f, (random01() - 0.5f) * 1000.0f };
+            const float e = 0.5f + random01() * 2.0f;
+            b = { c - vec3{ e, e, e }, c + vec3{ e, e, e } };
+        }
+
+        _bvh.build(_boxes.data(), _num_objects);
+        printf("bvh build: %d objects, %d nodes, depth %d, %.3f ms\n",
+            _num_objects, _bvh.stats().num_nodes, _bvh.stats().depth, _bvh.stats().build_ms);
+
+        falcon::loose_grid_desc grid_desc;
+        grid_desc.cell_size = 8.0f;
+        _grid.setup(grid_desc);
+        const uint64_t start = stm_now();
+        for (int i = 0; i < _num_objects; i++) {
+            _grid.update((uint32_t)i, _boxes[i]);
+        }
+        const double insert_ms = stm_ms(stm_since(start));
+        for (int i = 0; i < _num_objects; i++) {
+            _moved[(uint32_t)i] = _boxes[i];
+        }
+        printf("grid insert: %d objects, %d cells, %.3f ms\n", _num_objects, _grid.stats().num_cells, insert_ms);
+        bench().note("bvh_build_ms", _bvh.stats().build_ms);
+        bench().note("grid_insert_ms", insert_ms);
+        _grid.reset_stats();
+
+        _changed.resize(_num_moving);
+    }
+
+    void frame() override {
+        using namespace falcon::math;
+        _angle += 0.5f;
+
+        /* move 1% of the objects */
+        for (int i = 0; i < _num_moving; i++) {
+            const uint32_t index = (uint32_t)(rand() % _num_objects);
+            const vec3 offset = { (random01() - 0.5f), 0.0f, (random01() - 0.5f) };
+            _boxes[index].min += offset;
+            _boxes[index].max += offset;
+            _changed[i] = index;
+        }
+
+        /* incremental refit, then a full refit of the same tree as reference */
+        _bvh.refit(_boxes.data(), _changed.data(), _num_moving);
+        const double refit_ms = _bvh.stats().refit_ms;
+        _bvh.refit(_boxes.data());
+        const double full_refit_ms = _bvh.stats().refit_ms;
+
+        /* grid moves */
+        uint64_t start = stm_now();
+        for (int i = 0; i < _num_moving; i++) {
+            _grid.update(_changed[i], _boxes[_changed[i]]);
+        }
+        const double grid_move_ms = stm_ms(stm_since(start));
+
+        /* reference: storing the moved boxes in a hash map */
+        start = stm_now();
+        for (int i = 0; i < _num_moving; i++) {
+            _moved[_changed[i]] = _boxes[_changed[i]];
+        }
+        const double map_move_ms = stm_ms(stm_since(start));
+
+        /* frustum queries */
+        const mat4 proj = perspective(60.0f, (float)width() / (float)height(), 0.1f, 300.0f);
+        const mat4 view = look_at({ 0.0f, 0.0f, 0.0f }, { std::sin(radians(_angle)), 0.0f, std::cos(radians(_angle)) }, { 0.0f, 1.0f, 0.0f });
+        const falcon::frustum f = falcon::make_frustum(proj * view);
+        start = stm_now();
+        _brute_results.clear();
+        for (int i = 0; i < _num_objects; i++) {
+            if (brute_visible(f, _boxes[i])) {
+                _brute_results.push_back((uint32_t)i);
+            }
+        }
+        const double brute_frustum_ms = stm_ms(stm_since(start));
+        start = stm_now();
+        _results.clear();
+        _num_bvh_visible = _bvh.query(f, _results);
+        const double bvh_frustum_ms = stm_ms(stm_since(start));
+        std::sort(_results.begin(), _results.end());
+        bench().check(_results == _brute_results, "bvh frustum query differs from brute force");
+        start = stm_now();
+        _results.clear();
+        _num_grid_visible = _grid.query(f, _results);
+        const double grid_frustum_ms = stm_ms(stm_since(start));
+        std::sort(_results.begin(), _results.end());
+        bench().check(_results == _brute_results, "grid frustum query differs from brute force");
+
+        /* ray queries */
+        start = stm_now();
+        _num_hits = 0;
+        for (int i = 0; i < NUM_RAYS; i++) {
+            const falcon::ray r = random_ray();
+            falcon::ray_hit hit;
+            _num_hits += _bvh.raycast(r, hit) ? 1 : 0;
+        }
+        const double ray_ms = stm_ms(stm_since(start));
+
+        /* a few rays against every box, the closest distances must match */
+        bool same_hits = true;
+        start = stm_now();
+        for (int i = 0; i < NUM_BRUTE_RAYS; i++) {
+            const falcon::ray r = random_ray();
+            falcon::ray_hit hit;
+            const bool bvh_hit = _bvh.raycast(r, hit);
+            const float t = brute_raycast(r, _boxes);
+            same_hits &= (bvh_hit == (t >= 0.0f)) && (!bvh_hit || fabsf(hit.t - t) <= 1e-4f * (1.0f + t));
+        }
+        const double brute_ray_ms = stm_ms(stm_since(start)) * ((double)NUM_RAYS / NUM_BRUTE_RAYS);
+        bench().check(same_hits, "bvh raycast differs from brute force");
+
+        falcon::gfx::begin(_pass_action, width(), height());
+
+        /* medians of a bench_frames run, compared relative to the references */
+        bench().note("refit_ms", refit_ms);
+        bench().note("grid_move_ms", grid_move_ms);
+        bench().note("brute_frustum_ms", brute_frustum_ms);
+        bench().note("bvh_frustum_ms", bvh_frustum_ms);
+        bench().note("grid_frustum_ms", grid_frustum_ms);
+        bench().note("ray_ms", ray_ms);
+        bench().note("full_refit_ms", full_refit_ms);
+        bench().note("map_move_ms", map_move_ms);
+        bench().add("refit_ratio", refit_ms / full_refit_ms);
+        bench().add("grid_move_ratio", grid_move_ms / map_move_ms);
+        bench().add("bvh_frustum_ratio", bvh_frustum_ms / brute_frustum_ms);
+        bench().add("grid_frustum_ratio", grid_frustum_ms / brute_frustum_ms);
+        bench().add("ray_ratio", ray_ms / brute_ray_ms);
+
+        /* report once per second */
+        _refit_time += refit_ms;
+        _grid_move_time += grid_move_ms;
+        _bvh_frustum_time += bvh_frustum_ms;
+        _grid_frustum_time += grid_frustum_ms;
+        _ray_time += ray_ms;
+        _frame_count++;
+        _report_time += delta_time();
+        if (_report_time >= 1.0) {
+            const double n = (double)_frame_count;
+            printf("refit %d: %.3f ms, grid move %d: %.3f ms, frustum bvh: %.3f ms (%d), frustum grid: %.3f ms (%d), %d rays: %.3f ms (%d hits)\n",
+                _num_moving, _refit_time / n, _num_moving, _grid_move_time / n,
+                _bvh_frustum_time / n, _num_bvh_visible, _grid_frustum_time / n, _num_grid_visible,
+                NUM_RAYS, _ray_time / n, _num_hits);
+            _refit_time = 0.0;
+            _grid_move_time = 0.0;
+            _bvh_frustum_time = 0.0;
+            _grid_frustum_time = 0.0;
+            _ray_time = 0.0;
+            _report_time = 0.0;
+            _frame_count = 0;
+        }
+    }
+
+    int _num_objects;
+    int _num_moving;
+    float _angle;
+    double _report_time;
+    int _frame_count;
+    double _refit_time = 0.0;
+    double _grid_move_time = 0.0;
+    double _bvh_frustum_time = 0.0;
+    double _grid_frustum_time = 0.0;
+    double _ray_time = 0.0;
+    int _num_bvh_visible = 0;
+    int _num_grid_visible = 0;
+    int _num_hits = 0;
+
+    falcon::gfx::pass_action _pass_action;
+    std::vector<falcon::aabb> _boxes;
+    std::vector<uint32_t> _changed;
+    std::vector<uint32_t> _results;
+    std::vector<uint32_t> _brute_results;
+    std::unordered_map<uint32_t, falcon::aabb> _moved;
+    falcon::bvh _bvh;
+    falcon::loose_grid _grid;
+};
+
+} // namespace
+
+FALCON_MAIN(::app);
@@ -0,0 +1,145 @@
+#include <stdio.h>  /* printf() */
+#include <stdlib.h> /* rand(), atoi() */
+
+#include "sokol_args.h"
+#include "sokol_time.h"
+
+#include "falcon.h"
+
+#define NUM_TEXTURES (16)
+#define TEX_SIZE (16)
+#define DEFAULT_NUM_SPRITES (100000)
+
+namespace {
+
+class app : public falcon::application {
+    void configure(sapp_desc &desc) override {
+        desc.width = 1024;
+        desc.height = 768;
+        desc.window_title = "Sprites (falcon app)";
+        desc.swap_interval = 0;
+
+        _num_sprites = atoi(sargs_value_def("sprites", "100000"));
+        if (_num_sprites <= 0) {
+            _num_sprites = DEFAULT_NUM_SPRITES;
+        }
+        _report_time = 0.0;
+        _cpu_time = 0.0;
+        _frame_count = 0;
+    }
+
+    struct particle {
+        float x, y;
+        float vx, vy;
+    };
+
+    void init() override {
+        using namespace falcon::gfx;
+
+        if (sapp_gles2()) {
+            /* this demo needs GLES3/WebGL */
+            _pass_action = make_pass_action_clear(1.0f, 0.0f, 0.0f);
+            return;
+        }
+
+        _pass_action = make_pass_action_clear(0.1f, 0.1f, 0.15f);
+
+        falcon::gfx::sprite_batch_desc batch_desc;
+        batch_desc.max_sprites = _num_sprites;
+        batch_desc.filter = SG_FILTER_NEAREST;
+        batch_desc.label = "sprites";
+        _batch.setup(batch_desc);
+
+        /* same-sized checkerboard textures, all end up in one array image */
+        static uint32_t pixels[TEX_SIZE][TEX_SIZE];
+        for (int i = 0; i < NUM_TEXTURES; i++) {
+            const uint32_t color = 0xFF000000 | (rand() & 0x00FFFFFF);
+            for (int y = 0; y < TEX_SIZE; y++) {
+                for (int x = 0; x < TEX_SIZE; x++) {
+                    pixels[y][x] = ((x ^ y) & 4) ? color : 0x80FFFFFF;
+                }
+            }
+            _textures[i] = _batch.add_texture(TEX_SIZE, TEX_SIZE, pixels);
+        }
+        _batch.build();
+
+        _particles.resize(_num_sprites);
+        _sprites.resize(_num_sprites);
+        for (int i = 0; i < _num_sprites; i++) {
+            auto &p = _particles[i];
+            p.x = (float)(rand() % width());
+            p.y = (float)(rand() % height());
+            p.vx = ((float)(rand() & 0x7FFF) / 0x7FFF - 0.5f) * 200.0f;
+            p.vy = ((float)(rand() & 0x7FFF) / 0x7FFF - 0.5f) * 200.0f;
+
+            auto &s = _sprites[i];
+            s.width = (float)TEX_SIZE;
+            s.height = (float)TEX_SIZE;
+            s.texture = _textures[i % NUM_TEXTURES];
+            s.blend = (i & 7) ? falcon::gfx::sprite_blend::alpha : falcon::gfx::sprite_blend::additive;
+        }
+    }
+
+    void frame() override {
+        if (sapp_gles2()) {
+            falcon::gfx::begin(_pass_action, width(), height());
+            return;
+        }
+
+        const float w = (float)width(), h = (float)height();
+        const float dt = (float)delta_time();
+
+        /* move sprites, bounce off the window edges */
+        const uint64_t start = stm_now();
+        for (int i = 0; i < _num_sprites; i++) {
+            auto &p = _particles[i];
+            p.x += p.vx * dt;
+            p.y += p.vy * dt;
+            if ((p.x < 0.0f && p.vx < 0.0f) || (p.x > w && p.vx > 0.0f)) p.vx = -p.vx;
+            if ((p.y < 0.0f && p.vy < 0.0f) || (p.y > h && p.vy > 0.0f)) p.vy = -p.vy;
+
+            auto &s = _sprites[i];
+            s.x = p.x;
+            s.y = p.y;
+            s.rotation = (i & 1) ? p.x * 0.01f : 0.0f;
+            _batch.draw(s);
+        }
+
+        if (auto pass = falcon::gfx::begin(_pass_action, width(), height())) {
+            _batch.flush(width(), height());
+        }
+        _cpu_time += stm_sec(stm_since(start));
+
+        /* report once per second */
+        _frame_count++;
+        _report_time += delta_time();
+        if (_report_time >= 1.0) {
+            const auto &stats = _batch.stats();
+            printf("sprites: %d, draws: %d, fps: %.1f, cpu: %.2f ms/frame\n",
+                stats.num_sprites, stats.num_draws,
+                _frame_count / _report_time, 1000.0 * _cpu_time / _frame_count);
+            _report_time = 0.0;
+            _cpu_time = 0.0;
+            _frame_count = 0;
+        }
+    }
+
+    void cleanup() override {
+        _batch.shutdown();
+    }
+
+    int _num_sprites;
+    double _report_time;
+    double _cpu_time;
+    int _frame_count;
+
+    falcon::gfx::pass_action _pass_action;
+    falcon::gfx::sprite_batch _batch;
+    falcon::gfx::sprite_texture _textures[NUM_TEXTURES];
+    std::vector<particle> _particles;
+    std::vector<falcon::gfx::sprite> _sprites;
+};
+
+} // namespace
+
+FALCON_MAIN(::app);